@@ -0,0 +1,118 @@
+#include <cstdint>
+#include <random>
+#include <string>
+
+#include <benchmark/benchmark.h>
+
+#include "util/base64.h"
+
+namespace {
+
+std::string LegacyEncodeBase64(const std::string& data) {
+  const char* chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  std::string result;
+  int val = 0, valb = -6;
+
+  for (unsigned char c : data) {
+    val = (val << 8) + c;
+    valb += 8;
+    while (valb >= 0) {
+      result.push_back(chars[(val >> valb) & 0x3F]);
+      valb -= 6;
+    }
+  }
+
+  if (valb > -6) {
+    result.push_back(chars[((val << 8) >> (valb + 8)) & 0x3F]);
+  }
+
+  while (result.size() % 4) {
+    result.push_back('=');
+  }
+
+  return result;
+}
+
+std::string RandomBytes(std::size_t size) {
+  std::mt19937_64 engine(42);
+  std::string data(size, '\0');
+  for (auto& byte : data) {
+    byte = static_cast<char>(engine());
+  }
+  return data;
+}
+
+void SetThroughput(benchmark::State& state, std::size_t bytes) {
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) *
+                          static_cast<std::int64_t>(bytes));
+}
+
+void BM_LegacyEncode(benchmark::State& state) {
+  auto data = RandomBytes(static_cast<std::size_t>(state.range(0)));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(LegacyEncodeBase64(data));
+  }
+  SetThroughput(state, data.size());
+}
+
+void BM_Encode(benchmark::State& state) {
+  auto kernel = static_cast<duw::Base64Kernel>(state.range(1));
+  if (!duw::IsBase64KernelSupported(kernel)) {
+    state.SkipWithError("kernel not supported on this CPU");
+    return;
+  }
+
+  auto data = RandomBytes(static_cast<std::size_t>(state.range(0)));
+  state.SetLabel(duw::Base64KernelName(kernel));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(duw::Base64Encode(data, kernel));
+  }
+  SetThroughput(state, data.size());
+}
+
+void BM_Decode(benchmark::State& state) {
+  auto kernel = static_cast<duw::Base64Kernel>(state.range(1));
+  if (!duw::IsBase64KernelSupported(kernel)) {
+    state.SkipWithError("kernel not supported on this CPU");
+    return;
+  }
+
+  auto encoded = duw::Base64Encode(RandomBytes(static_cast<std::size_t>(state.range(0))));
+  state.SetLabel(duw::Base64KernelName(kernel));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(duw::Base64Decode(encoded, kernel));
+  }
+  SetThroughput(state, encoded.size());
+}
+
+void BM_StreamingEncode(benchmark::State& state) {
+  constexpr std::size_t CHUNK_BYTES = 64 * 1024;
+  auto data = RandomBytes(static_cast<std::size_t>(state.range(0)));
+  std::string chunk;
+  for (auto _ : state) {
+    duw::Base64Encoder encoder;
+    for (std::size_t offset = 0; offset < data.size(); offset += CHUNK_BYTES) {
+      chunk.clear();
+      encoder.Update(std::string_view(data).substr(offset, CHUNK_BYTES), chunk);
+      benchmark::DoNotOptimize(chunk.data());
+    }
+    encoder.Finish(chunk);
+  }
+  SetThroughput(state, data.size());
+}
+
+void KernelArgs(benchmark::internal::Benchmark* benchmark) {
+  for (std::int64_t size : {1 << 20, 8 << 20, 32 << 20}) {
+    for (auto kernel : {duw::Base64Kernel::KERNEL_SCALAR, duw::Base64Kernel::KERNEL_SSSE3,
+                        duw::Base64Kernel::KERNEL_AVX2, duw::Base64Kernel::KERNEL_NEON}) {
+      benchmark->Args({size, static_cast<std::int64_t>(kernel)});
+    }
+  }
+}
+
+}  // anonymous namespace
+
+BENCHMARK(BM_LegacyEncode)->Arg(1 << 20)->Arg(8 << 20)->Arg(32 << 20);
+BENCHMARK(BM_Encode)->Apply(KernelArgs);
+BENCHMARK(BM_Decode)->Apply(KernelArgs);
+BENCHMARK(BM_StreamingEncode)->Arg(8 << 20)->Arg(32 << 20);
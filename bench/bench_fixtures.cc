@@ -0,0 +1,35 @@
+#include "bench_fixtures.h"
+
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+#include <nlohmann/json.hpp>
+
+namespace duw {
+
+const std::string& FixturePayload() {
+  static const std::string payload = [] {
+    std::ifstream file(DUW_BENCH_FIXTURE, std::ios::binary);
+    if (!file) {
+      throw std::runtime_error("Failed to open fixture " DUW_BENCH_FIXTURE);
+    }
+    std::ostringstream content;
+    content << file.rdbuf();
+    return content.str();
+  }();
+  return payload;
+}
+
+std::string ScaledPayload(std::size_t copies) {
+  auto recorded = nlohmann::json::parse(FixturePayload());
+  nlohmann::json result = nlohmann::json::object();
+  for (std::size_t copy = 0; copy < copies; ++copy) {
+    for (const auto& [city, services] : recorded["result"].items()) {
+      result[copy == 0 ? city : city + " " + std::to_string(copy)] = services;
+    }
+  }
+  return nlohmann::json{{"result", std::move(result)}}.dump();
+}
+
+}  // namespace duw
@@ -0,0 +1,15 @@
+#ifndef BENCH_FIXTURES_H
+#define BENCH_FIXTURES_H
+
+#include <cstddef>
+#include <string>
+
+namespace duw {
+
+const std::string& FixturePayload();
+
+std::string ScaledPayload(std::size_t copies);
+
+}  // namespace duw
+
+#endif  // BENCH_FIXTURES_H
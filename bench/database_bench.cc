@@ -0,0 +1,169 @@
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+#include <spdlog/spdlog.h>
+
+#include "bench_fixtures.h"
+#include "core/sample_spool.h"
+#include "core/status_parser.h"
+#include "data/storage_profile.h"
+#include "services/database_service.h"
+
+namespace {
+
+constexpr std::array<const char*, 3> PROFILE_NAMES = {"durable", "balanced", "throughput"};
+
+class ScratchDatabase {
+ public:
+  explicit ScratchDatabase(const std::string& name)
+      : path_(std::filesystem::temp_directory_path() / ("duw-bench-" + name + ".db")) {
+    Remove();
+  }
+  ~ScratchDatabase() { Remove(); }
+
+  ScratchDatabase(const ScratchDatabase&) = delete;
+  ScratchDatabase& operator=(const ScratchDatabase&) = delete;
+
+  std::string Path() const { return path_.string(); }
+
+ private:
+  std::filesystem::path path_;
+
+  void Remove() {
+    std::error_code ec;
+    for (const char* suffix : {"", "-wal", "-shm"}) {
+      std::filesystem::remove(path_.string() + suffix, ec);
+    }
+  }
+};
+
+enum class SaveMode : std::uint8_t {
+  ROW_AT_A_TIME = 0,
+  BATCHED = 1
+};
+
+void SaveTickets(benchmark::State& state, SaveMode mode) {
+  spdlog::set_level(spdlog::level::warn);
+  const char* profile_name = PROFILE_NAMES[static_cast<std::size_t>(state.range(1))];
+  auto profile = duw::FindStorageProfile(profile_name);
+  ScratchDatabase database(profile_name);
+  duw::DatabaseService service;
+  auto tickets = duw::ParseJsonResponse(
+      duw::ScaledPayload(static_cast<std::size_t>(state.range(0))), 0);
+  if (!profile || !tickets || !service.Initialize(database.Path(), *profile)) {
+    state.SkipWithError("failed to prepare database");
+    return;
+  }
+
+  state.SetLabel(profile_name);
+  std::int64_t timestamp_ms = 0;
+  for (auto _ : state) {
+    ++timestamp_ms;
+    for (auto& ticket : *tickets) {
+      ticket.timestamp_ms = timestamp_ms;
+    }
+    if (mode == SaveMode::BATCHED) {
+      benchmark::DoNotOptimize(service.SaveTicketInfoBatch(*tickets));
+    } else {
+      for (const auto& ticket : *tickets) {
+        benchmark::DoNotOptimize(service.SaveTicketInfo(ticket));
+      }
+    }
+  }
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()) *
+                          static_cast<std::int64_t>(tickets->size()));
+}
+
+void BM_SaveTicketInfo(benchmark::State& state) {
+  SaveTickets(state, SaveMode::ROW_AT_A_TIME);
+}
+
+void BM_SaveTicketInfoBatch(benchmark::State& state) {
+  SaveTickets(state, SaveMode::BATCHED);
+}
+
+std::optional<duw::TicketChangeSet> ChangeSet(benchmark::State& state) {
+  auto tickets = duw::ParseJsonResponse(
+      duw::ScaledPayload(static_cast<std::size_t>(state.range(0))), 0);
+  if (!tickets) {
+    return std::nullopt;
+  }
+
+  duw::TicketChangeSet change_set;
+  change_set.changed = std::move(*tickets);
+  return change_set;
+}
+
+void NextCycle(duw::TicketChangeSet& change_set) {
+  ++change_set.timestamp_ms;
+  for (auto& ticket : change_set.changed) {
+    ticket.timestamp_ms = change_set.timestamp_ms;
+    ++ticket.queue_length;
+  }
+}
+
+void BM_SpoolAppend(benchmark::State& state) {
+  spdlog::set_level(spdlog::level::warn);
+  ScratchDatabase file("spool");
+  duw::SampleSpool spool(file.Path());
+  auto change_set = ChangeSet(state);
+  if (!change_set || !spool.IsOpen()) {
+    state.SkipWithError("failed to prepare spool");
+    return;
+  }
+
+  std::uint64_t sequence = 0;
+  for (auto _ : state) {
+    NextCycle(*change_set);
+    if (!spool.Append(*change_set)) {
+      state.SkipWithError("failed to append to spool");
+      return;
+    }
+    spool.MarkStored(++sequence);
+  }
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()) *
+                          static_cast<std::int64_t>(change_set->changed.size()));
+}
+
+void BM_SaveChangeSets(benchmark::State& state) {
+  spdlog::set_level(spdlog::level::warn);
+  const char* profile_name = PROFILE_NAMES[static_cast<std::size_t>(state.range(1))];
+  auto profile = duw::FindStorageProfile(profile_name);
+  ScratchDatabase database(profile_name);
+  duw::DatabaseService service;
+  auto change_set = ChangeSet(state);
+  if (!profile || !change_set || !service.Initialize(database.Path(), *profile)) {
+    state.SkipWithError("failed to prepare database");
+    return;
+  }
+
+  state.SetLabel(profile_name);
+  for (auto _ : state) {
+    NextCycle(*change_set);
+    change_set->sequence = static_cast<std::uint64_t>(change_set->timestamp_ms);
+    benchmark::DoNotOptimize(service.SaveChangeSets(std::span(&*change_set, 1)));
+  }
+  state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()) *
+                          static_cast<std::int64_t>(change_set->changed.size()));
+}
+
+void ProfileArgs(benchmark::internal::Benchmark* benchmark) {
+  for (std::int64_t copies : {1, 8}) {
+    for (std::size_t profile = 0; profile < PROFILE_NAMES.size(); ++profile) {
+      benchmark->Args({copies, static_cast<std::int64_t>(profile)});
+    }
+  }
+}
+
+}  // anonymous namespace
+
+BENCHMARK(BM_SaveTicketInfo)->Apply(ProfileArgs);
+BENCHMARK(BM_SaveTicketInfoBatch)->Apply(ProfileArgs);
+BENCHMARK(BM_SpoolAppend)->Arg(1)->Arg(8);
+BENCHMARK(BM_SaveChangeSets)->Apply(ProfileArgs);
@@ -0,0 +1,164 @@
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+
+#include "bench_fixtures.h"
+#include "core/payload_recording.h"
+#include "core/status_parser.h"
+
+namespace {
+
+constexpr std::int64_t CHECK_TIMESTAMP_MS = 1700000000000;
+
+struct ParserCase {
+  std::string name;
+  std::string payload;
+};
+
+using Tickets = std::optional<std::vector<duw::TicketInfo>>;
+
+bool SameTicket(const duw::TicketInfo& left, const duw::TicketInfo& right) {
+  return left.city == right.city && left.queue_status == right.queue_status &&
+         left.queue_length == right.queue_length && left.timestamp_ms == right.timestamp_ms &&
+         left.service_name == right.service_name && left.service_id == right.service_id &&
+         left.operations_count == right.operations_count &&
+         left.enabled_operations == right.enabled_operations;
+}
+
+std::string Describe(const Tickets& tickets) {
+  if (!tickets.has_value()) {
+    return "no tickets";
+  }
+  return std::to_string(tickets->size()) + " tickets";
+}
+
+std::optional<std::string> FindMismatch(const Tickets& expected, const Tickets& actual) {
+  if (expected.has_value() != actual.has_value() ||
+      (expected.has_value() && expected->size() != actual->size())) {
+    return Describe(expected) + " vs " + Describe(actual);
+  }
+  for (std::size_t i = 0; expected.has_value() && i < expected->size(); ++i) {
+    if (!SameTicket((*expected)[i], (*actual)[i])) {
+      return "ticket " + std::to_string(i) + " for city " + (*expected)[i].city + " differs";
+    }
+  }
+  return std::nullopt;
+}
+
+std::string MutateFixture(const std::string& recorded,
+                          const std::function<void(nlohmann::json&)>& mutate) {
+  auto payload = nlohmann::json::parse(recorded);
+  mutate(payload);
+  return payload.dump();
+}
+
+nlohmann::json& FirstService(nlohmann::json& payload) {
+  return payload["result"].begin().value()[0];
+}
+
+std::vector<ParserCase> FixtureCases(const std::string& recorded) {
+  std::string first_city = nlohmann::json::parse(recorded)["result"].begin().key();
+
+  return {
+      {"recorded", recorded},
+      {"scaled x8", duw::ScaledPayload(8)},
+      {"empty payload", ""},
+      {"truncated", recorded.substr(0, recorded.size() / 2)},
+      {"missing result", R"({"status":"ok"})"},
+      {"result array", R"({"result":[]})"},
+      {"result null", R"({"result":null})"},
+      {"empty result", R"({"result":{}})"},
+      {"duplicate city",
+       R"({"result":{"A":[{"id":1,"name":"x","operations":[]}],)"
+       R"("A":[{"id":2,"name":"y","operations":[{"enabled":true}]},{}]}})"},
+      {"nested result key",
+       R"({"result":{"A":[{"id":1,"name":"x","result":{"B":[{}]},"operations":[]}]}})"},
+      {"extra root keys",
+       MutateFixture(recorded, [](nlohmann::json& payload) {
+         payload["meta"] = {{"result", nlohmann::json::array()}, {"count", 3}};
+       })},
+      {"city not an array",
+       MutateFixture(recorded, [&first_city](nlohmann::json& payload) {
+         payload["result"][first_city] = {{"id", 1}};
+       })},
+      {"city empty array",
+       MutateFixture(recorded, [&first_city](nlohmann::json& payload) {
+         payload["result"][first_city] = nlohmann::json::array();
+       })},
+      {"first service not an object",
+       MutateFixture(recorded, [](nlohmann::json& payload) { FirstService(payload) = 7; })},
+      {"first service without fields",
+       MutateFixture(recorded, [](nlohmann::json& payload) {
+         FirstService(payload) = nlohmann::json::object();
+       })},
+      {"operations not an array",
+       MutateFixture(recorded, [](nlohmann::json& payload) {
+         FirstService(payload)["operations"] = {{"enabled", true}};
+       })},
+      {"operations with scalars",
+       MutateFixture(recorded, [](nlohmann::json& payload) {
+         FirstService(payload)["operations"] = {1, nullptr, {{"enabled", true}}, {{"id", 2}}};
+       })},
+      {"escaped keys",
+       R"({"result":{"Wroc\u0142aw":[{"id":3,"na\u006de":"\u0142","operations":[]}]}})"},
+  };
+}
+
+bool CheckCase(const ParserCase& parser_case, duw::StatusParser& reused_parser) {
+  Tickets dom = duw::ParseJsonResponse(parser_case.payload, CHECK_TIMESTAMP_MS);
+  Tickets sax = duw::StreamParseJsonResponse(parser_case.payload, CHECK_TIMESTAMP_MS);
+  std::vector<duw::TicketInfo> reused_tickets;
+  Tickets reused;
+  if (reused_parser.Parse(parser_case.payload, CHECK_TIMESTAMP_MS, reused_tickets)) {
+    reused = std::move(reused_tickets);
+  }
+
+  auto mismatch = FindMismatch(dom, sax);
+  const char* parser_name = "SAX";
+  if (!mismatch.has_value()) {
+    mismatch = FindMismatch(dom, reused);
+    parser_name = "reused SAX";
+  }
+  if (mismatch.has_value()) {
+    spdlog::error("{}: DOM and {} parsers disagree: {}", parser_case.name, parser_name,
+                  *mismatch);
+    return false;
+  }
+
+  spdlog::info("{}: {}", parser_case.name, Describe(dom));
+  return true;
+}
+
+}  // anonymous namespace
+
+int main(int argc, char* argv[]) {
+  std::vector<ParserCase> cases = FixtureCases(duw::FixturePayload());
+  for (int arg = 1; arg < argc; ++arg) {
+    std::string path = argv[arg];
+    auto recording = duw::LoadRecording(path, std::chrono::milliseconds::zero());
+    if (!recording.has_value()) {
+      spdlog::error("Failed to load recorded payloads from {}", path);
+      return 1;
+    }
+    for (std::size_t i = 0; i < recording->size(); ++i) {
+      cases.push_back({path + " #" + std::to_string(i), std::move((*recording)[i].body)});
+    }
+  }
+
+  duw::StatusParser reused_parser;
+  std::size_t failed = 0;
+  for (const auto& parser_case : cases) {
+    if (!CheckCase(parser_case, reused_parser)) {
+      failed++;
+    }
+  }
+
+  spdlog::info("{} of {} parser cases agree", cases.size() - failed, cases.size());
+  return failed == 0 ? 0 : 1;
+}
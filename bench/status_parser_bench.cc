@@ -0,0 +1,62 @@
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include "bench_fixtures.h"
+#include "core/status_parser.h"
+#include "util/allocation_counter.h"
+
+namespace {
+
+void SetThroughput(benchmark::State& state, std::size_t bytes) {
+  state.SetBytesProcessed(static_cast<std::int64_t>(state.iterations()) *
+                          static_cast<std::int64_t>(bytes));
+}
+
+void BM_ParseJsonResponse(benchmark::State& state) {
+  auto payload = duw::ScaledPayload(static_cast<std::size_t>(state.range(0)));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(duw::ParseJsonResponse(payload, 0));
+  }
+  SetThroughput(state, payload.size());
+}
+
+void BM_StreamParseJsonResponse(benchmark::State& state) {
+  auto payload = duw::ScaledPayload(static_cast<std::size_t>(state.range(0)));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(duw::StreamParseJsonResponse(payload, 0));
+  }
+  SetThroughput(state, payload.size());
+}
+
+void BM_StatusParserReuse(benchmark::State& state) {
+  auto payload = duw::ScaledPayload(static_cast<std::size_t>(state.range(0)));
+  duw::StatusParser parser;
+  std::vector<duw::TicketInfo> tickets;
+  parser.Parse(payload, 0, tickets);
+  auto allocations_before = duw::ThreadAllocationCount();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(parser.Parse(payload, 0, tickets));
+  }
+  if (duw::AllocationCountingEnabled()) {
+    state.counters["allocs"] = benchmark::Counter(
+        static_cast<double>(duw::ThreadAllocationCount() - allocations_before),
+        benchmark::Counter::kAvgIterations);
+  }
+  SetThroughput(state, payload.size());
+}
+
+void BM_GetCurrentTimestamp(benchmark::State& state) {
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(duw::GetCurrentTimestamp());
+  }
+}
+
+}  // anonymous namespace
+
+BENCHMARK(BM_ParseJsonResponse)->Arg(1)->Arg(8)->Arg(64);
+BENCHMARK(BM_StreamParseJsonResponse)->Arg(1)->Arg(8)->Arg(64);
+BENCHMARK(BM_StatusParserReuse)->Arg(1)->Arg(8)->Arg(64);
+BENCHMARK(BM_GetCurrentTimestamp);
@@ -1,8 +1,13 @@
+#include <chrono>
 #include <cstdlib>
 #include <memory>
 
 #include <spdlog/spdlog.h>
 
+#include "metrics_server.h"
+#include "read_api_server.h"
+#include "replay.h"
+#include "signal_watcher.h"
 #include "../core/collector.h"
 #include "../services/database_service.h"
 #include "../services/env_service.h"
@@ -10,19 +15,64 @@
 #include "../services/http_client.h"
 
 int main() {
-  auto http_client = std::make_unique<duw::HttpClient>();
-  auto storage = std::make_unique<duw::DatabaseService>();
   auto env_service = std::make_unique<duw::EnvService>();
-  auto github_service = duw::CreateGitHubService(std::make_unique<duw::HttpClient>());
+  auto params = env_service->GetParams();
+  auto http_client = std::make_unique<duw::HttpClient>(duw::HttpClientOptions{
+      .connect_timeout = std::chrono::milliseconds(params.http_connect_timeout_ms),
+      .read_timeout = std::chrono::milliseconds(params.http_read_timeout_ms),
+      .write_timeout = std::chrono::milliseconds(params.http_read_timeout_ms),
+      .total_timeout = std::chrono::milliseconds(params.http_total_timeout_ms)});
+  auto storage = std::make_unique<duw::DatabaseService>();
+  auto github_service = duw::CreateGitHubService(std::make_unique<duw::HttpClient>(
+      duw::HttpClientOptions{
+          .total_timeout = std::chrono::seconds(params.github_download_timeout_seconds),
+          .compress_requests = params.http_compress_requests,
+          .authorization = params.github_token.empty() ? "" : "Bearer " + params.github_token}));
   
   auto collector = std::make_unique<duw::Collector>(
       std::move(http_client), std::move(storage), 
       std::move(env_service), std::move(github_service));
 
   const char* mode_env = std::getenv("MODE");
+  if (mode_env != nullptr && std::string(mode_env) == "backfill_rollups") {
+    return collector->BackfillRollups();
+  }
+  if (mode_env != nullptr && std::string(mode_env) == "vacuum") {
+    return collector->Vacuum();
+  }
+
   bool polling_mode =
       (mode_env != nullptr) && std::string(mode_env) == "polling";
 
+  duw::SignalWatcher signal_watcher([&collector](int) { collector->RequestStop(); });
+
+  if (mode_env != nullptr && std::string(mode_env) == "replay") {
+    return duw::RunReplay(*collector, params);
+  }
+
+  std::unique_ptr<duw::ReadApiServer> read_api;
+  if (polling_mode && params.read_api_port > 0) {
+    read_api = std::make_unique<duw::ReadApiServer>(
+        duw::ReadApiOptions{.host = params.read_api_host,
+                            .port = params.read_api_port,
+                            .db_path = params.db_path,
+                            .max_rows = params.read_api_max_rows,
+                            .max_range = std::chrono::hours(params.read_api_max_range_hours)},
+        collector->LatestStates());
+    if (!read_api->Start()) {
+      return 1;
+    }
+  }
+
+  std::unique_ptr<duw::MetricsServer> metrics_server;
+  if (polling_mode && params.metrics_port > 0) {
+    metrics_server = std::make_unique<duw::MetricsServer>(
+        duw::MetricsServerOptions{.host = params.metrics_host, .port = params.metrics_port});
+    if (!metrics_server->Start()) {
+      return 1;
+    }
+  }
+
   int result = collector->Start(polling_mode);
 
   if (result != 0) {
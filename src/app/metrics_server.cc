@@ -0,0 +1,44 @@
+#include "metrics_server.h"
+
+#include <spdlog/spdlog.h>
+
+#include "../util/metrics.h"
+
+namespace duw {
+
+namespace {
+
+constexpr const char* PROMETHEUS_CONTENT_TYPE = "text/plain; version=0.0.4";
+
+}  // anonymous namespace
+
+MetricsServer::MetricsServer(MetricsServerOptions options) : options_(std::move(options)) {
+  server_.Get("/metrics", [](const httplib::Request&, httplib::Response& response) {
+    response.set_content(MetricsRegistry::Get().RenderPrometheus(), PROMETHEUS_CONTENT_TYPE);
+  });
+}
+
+MetricsServer::~MetricsServer() {
+  Stop();
+}
+
+bool MetricsServer::Start() {
+  if (!server_.bind_to_port(options_.host, options_.port)) {
+    spdlog::error("Metrics endpoint failed to bind {}:{}", options_.host, options_.port);
+    return false;
+  }
+
+  listener_ = std::thread([this] { server_.listen_after_bind(); });
+  server_.wait_until_ready();
+  spdlog::info("Metrics endpoint listening on {}:{}/metrics", options_.host, options_.port);
+  return true;
+}
+
+void MetricsServer::Stop() {
+  server_.stop();
+  if (listener_.joinable()) {
+    listener_.join();
+  }
+}
+
+}  // namespace duw
@@ -0,0 +1,35 @@
+#ifndef METRICS_SERVER_H
+#define METRICS_SERVER_H
+
+#include <string>
+#include <thread>
+
+#include <httplib.h>
+
+namespace duw {
+
+struct MetricsServerOptions {
+  std::string host = "127.0.0.1";
+  int port = 0;
+};
+
+class MetricsServer {
+ public:
+  explicit MetricsServer(MetricsServerOptions options);
+  ~MetricsServer();
+
+  MetricsServer(const MetricsServer&) = delete;
+  MetricsServer& operator=(const MetricsServer&) = delete;
+
+  bool Start();
+  void Stop();
+
+ private:
+  MetricsServerOptions options_;
+  httplib::Server server_;
+  std::thread listener_;
+};
+
+}  // namespace duw
+
+#endif  // METRICS_SERVER_H
@@ -0,0 +1,204 @@
+#include "read_api_server.h"
+
+#include <charconv>
+#include <cstdint>
+#include <optional>
+
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+#include <sqlite3.h>
+
+#include "../data/db_statement.h"
+#include "../services/database_service.h"
+
+namespace duw {
+
+namespace {
+
+constexpr int HTTP_BAD_REQUEST = 400;
+constexpr int HTTP_NOT_FOUND = 404;
+constexpr int HTTP_SERVICE_UNAVAILABLE = 503;
+constexpr int HISTORY_BUSY_TIMEOUT_MS = 1000;
+constexpr const char* JSON_CONTENT_TYPE = "application/json";
+
+constexpr const char* RAW_HISTORY_SQL = R"(
+  SELECT s.ts, s.valid_to, st.name, s.queue_length, s.operations_count, s.enabled_operations
+  FROM queue_samples s
+  JOIN queue_statuses st ON st.id = s.status_id
+  WHERE s.city_id = (SELECT id FROM cities WHERE name = ?1) AND s.ts >= ?2 AND s.ts < ?3
+  ORDER BY s.ts
+  LIMIT ?4;
+)";
+
+std::optional<std::int64_t> ParseInt64(const std::string& text) {
+  std::int64_t value = 0;
+  auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+  if (ec != std::errc{} || ptr != text.data() + text.size()) {
+    return std::nullopt;
+  }
+  return value;
+}
+
+void SetError(httplib::Response& response, int status, const std::string& message) {
+  response.status = status;
+  response.set_content(nlohmann::json{{"error", message}}.dump(), JSON_CONTENT_TYPE);
+}
+
+nlohmann::json RawHistoryRow(sqlite3_stmt* stmt) {
+  nlohmann::json row = {
+      {"ts", sqlite3_column_int64(stmt, 0)},
+      {"valid_to", nullptr},
+      {"queue_status", reinterpret_cast<const char*>(sqlite3_column_text(stmt, 2))},
+      {"queue_length", sqlite3_column_int(stmt, 3)},
+      {"operations_count", sqlite3_column_int(stmt, 4)},
+      {"enabled_operations", sqlite3_column_int(stmt, 5)}};
+  if (sqlite3_column_type(stmt, 1) != SQLITE_NULL) {
+    row["valid_to"] = sqlite3_column_int64(stmt, 1);
+  }
+  return row;
+}
+
+nlohmann::json RollupHistoryRow(sqlite3_stmt* stmt) {
+  return {{"bucket_start", sqlite3_column_int64(stmt, 0)},
+          {"change_count", sqlite3_column_int64(stmt, 1)},
+          {"covered_ms", sqlite3_column_int64(stmt, 2)},
+          {"queue_length_min", sqlite3_column_int(stmt, 3)},
+          {"queue_length_max", sqlite3_column_int(stmt, 4)},
+          {"queue_length_avg", sqlite3_column_double(stmt, 5)},
+          {"enabled_operations_min", sqlite3_column_int(stmt, 6)},
+          {"enabled_operations_max", sqlite3_column_int(stmt, 7)},
+          {"enabled_operations_avg", sqlite3_column_double(stmt, 8)}};
+}
+
+}  // anonymous namespace
+
+ReadApiServer::ReadApiServer(ReadApiOptions options, const LatestStateCache& latest_state)
+    : options_(std::move(options)), latest_state_(latest_state) {
+  server_.Get("/v1/latest", [this](const httplib::Request& request, httplib::Response& response) {
+    HandleLatest(request, response);
+  });
+  server_.Get(R"(/v1/latest/([^/]+))",
+              [this](const httplib::Request& request, httplib::Response& response) {
+                HandleLatestCity(request, response);
+              });
+  server_.Get("/v1/history", [this](const httplib::Request& request, httplib::Response& response) {
+    HandleHistory(request, response);
+  });
+}
+
+ReadApiServer::~ReadApiServer() {
+  Stop();
+}
+
+bool ReadApiServer::Start() {
+  if (!server_.bind_to_port(options_.host, options_.port)) {
+    spdlog::error("Read API failed to bind {}:{}", options_.host, options_.port);
+    return false;
+  }
+
+  listener_ = std::thread([this] { server_.listen_after_bind(); });
+  server_.wait_until_ready();
+  spdlog::info("Read API listening on {}:{}", options_.host, options_.port);
+  return true;
+}
+
+void ReadApiServer::Stop() {
+  server_.stop();
+  if (listener_.joinable()) {
+    listener_.join();
+  }
+}
+
+void ReadApiServer::HandleLatest(const httplib::Request&, httplib::Response& response) const {
+  response.set_content(latest_state_.AllCitiesJson(), JSON_CONTENT_TYPE);
+}
+
+void ReadApiServer::HandleLatestCity(const httplib::Request& request,
+                                     httplib::Response& response) const {
+  auto state = latest_state_.Load();
+  auto it = state->city_json.find(request.matches[1]);
+  if (it == state->city_json.end()) {
+    SetError(response, HTTP_NOT_FOUND, "unknown city");
+    return;
+  }
+  response.set_content(it->second, JSON_CONTENT_TYPE);
+}
+
+void ReadApiServer::HandleHistory(const httplib::Request& request, httplib::Response& response) {
+  auto from = ParseInt64(request.get_param_value("from"));
+  auto to = ParseInt64(request.get_param_value("to"));
+  std::string city = request.get_param_value("city");
+  std::string resolution =
+      request.has_param("resolution") ? request.get_param_value("resolution") : "raw";
+  if (city.empty() || !from.has_value() || !to.has_value() || *to <= *from) {
+    SetError(response, HTTP_BAD_REQUEST, "city, from and to (epoch ms, from < to) are required");
+    return;
+  }
+
+  if (*to - *from > std::chrono::milliseconds(options_.max_range).count()) {
+    SetError(response, HTTP_BAD_REQUEST,
+             "range exceeds " + std::to_string(options_.max_range.count()) + " hours");
+    return;
+  }
+
+  bool raw = resolution == "raw";
+  auto rollup_sql = RollupHistorySql(resolution);
+  if (!raw && !rollup_sql.has_value()) {
+    SetError(response, HTTP_BAD_REQUEST, "resolution must be raw, minute, hour or day");
+    return;
+  }
+
+  std::lock_guard lock(history_mutex_);
+  sqlite3* db = HistoryConnection();
+  if (db == nullptr) {
+    SetError(response, HTTP_SERVICE_UNAVAILABLE, "database unavailable");
+    return;
+  }
+
+  DBStatement stmt(db, raw ? std::string(RAW_HISTORY_SQL) : *rollup_sql);
+  if (!stmt.IsValid()) {
+    SetError(response, HTTP_SERVICE_UNAVAILABLE, "database unavailable");
+    return;
+  }
+  sqlite3_bind_text(stmt.Get(), 1, city.c_str(), -1, SQLITE_STATIC);
+  sqlite3_bind_int64(stmt.Get(), 2, *from);
+  sqlite3_bind_int64(stmt.Get(), 3, *to);
+  sqlite3_bind_int(stmt.Get(), 4, options_.max_rows + 1);
+
+  nlohmann::json rows = nlohmann::json::array();
+  bool truncated = false;
+  int result_code = SQLITE_ROW;
+  while ((result_code = sqlite3_step(stmt.Get())) == SQLITE_ROW) {
+    if (static_cast<int>(rows.size()) == options_.max_rows) {
+      truncated = true;
+      break;
+    }
+    rows.push_back(raw ? RawHistoryRow(stmt.Get()) : RollupHistoryRow(stmt.Get()));
+  }
+
+  if (!truncated && result_code != SQLITE_DONE) {
+    spdlog::warn("Read API history query failed: {}", sqlite3_errmsg(db));
+    SetError(response, HTTP_SERVICE_UNAVAILABLE, "query failed");
+    return;
+  }
+
+  response.set_content(nlohmann::json{{"city", city},
+                                      {"resolution", resolution},
+                                      {"truncated", truncated},
+                                      {"rows", std::move(rows)}}
+                           .dump(),
+                       JSON_CONTENT_TYPE);
+}
+
+sqlite3* ReadApiServer::HistoryConnection() {
+  if (history_connection_ == nullptr || !history_connection_->IsValid()) {
+    history_connection_ = std::make_unique<DBConnection>(options_.db_path, OpenMode::OPEN_READ_ONLY);
+    if (!history_connection_->IsValid()) {
+      return nullptr;
+    }
+    sqlite3_busy_timeout(history_connection_->Get(), HISTORY_BUSY_TIMEOUT_MS);
+  }
+  return history_connection_->Get();
+}
+
+}  // namespace duw
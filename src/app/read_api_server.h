@@ -0,0 +1,52 @@
+#ifndef READ_API_SERVER_H
+#define READ_API_SERVER_H
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include <httplib.h>
+
+#include "../core/latest_state_cache.h"
+#include "../data/db_connection.h"
+
+namespace duw {
+
+struct ReadApiOptions {
+  std::string host = "127.0.0.1";
+  int port = 0;
+  std::string db_path;
+  int max_rows = 5000;
+  std::chrono::hours max_range{24 * 7};
+};
+
+class ReadApiServer {
+ public:
+  ReadApiServer(ReadApiOptions options, const LatestStateCache& latest_state);
+  ~ReadApiServer();
+
+  ReadApiServer(const ReadApiServer&) = delete;
+  ReadApiServer& operator=(const ReadApiServer&) = delete;
+
+  bool Start();
+  void Stop();
+
+ private:
+  ReadApiOptions options_;
+  const LatestStateCache& latest_state_;
+  httplib::Server server_;
+  std::thread listener_;
+  std::mutex history_mutex_;
+  std::unique_ptr<DBConnection> history_connection_;
+
+  void HandleLatest(const httplib::Request& request, httplib::Response& response) const;
+  void HandleLatestCity(const httplib::Request& request, httplib::Response& response) const;
+  void HandleHistory(const httplib::Request& request, httplib::Response& response);
+  sqlite3* HistoryConnection();
+};
+
+}  // namespace duw
+
+#endif  // READ_API_SERVER_H
@@ -0,0 +1,148 @@
+#include "replay.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include <spdlog/spdlog.h>
+
+#include "replay_server.h"
+#include "../core/payload_recording.h"
+#include "../util/allocation_counter.h"
+#include "../util/metrics.h"
+
+namespace duw {
+
+namespace {
+
+constexpr double MS_PER_SECOND = 1000.0;
+
+std::int64_t DatabaseBytes(const std::string& db_path) {
+  std::int64_t total = 0;
+  for (const auto& path : {db_path, db_path + "-wal"}) {
+    std::error_code error;
+    auto size = std::filesystem::file_size(path, error);
+    total += error ? 0 : static_cast<std::int64_t>(size);
+  }
+  return total;
+}
+
+double PercentileMs(std::vector<std::chrono::nanoseconds> durations, double percentile) {
+  if (durations.empty()) {
+    return 0.0;
+  }
+  auto rank = std::ceil(percentile * static_cast<double>(durations.size()));
+  auto nth = durations.begin() + std::max<std::ptrdiff_t>(static_cast<std::ptrdiff_t>(rank) - 1, 0);
+  std::ranges::nth_element(durations, nth);
+  return std::chrono::duration<double, std::milli>(*nth).count();
+}
+
+void ReportStage(const std::string& stage, const std::string& metric, const MetricLabels& labels) {
+  const auto* histogram = MetricsRegistry::Get().FindHistogram(metric, labels);
+  if (histogram == nullptr || histogram->Count() == 0) {
+    return;
+  }
+  spdlog::info("  {:<6} p50 {:8.3f} ms  p99 {:8.3f} ms  ({} samples)", stage,
+               histogram->Quantile(0.5) * MS_PER_SECOND, histogram->Quantile(0.99) * MS_PER_SECOND,
+               histogram->Count());
+}
+
+bool CheckAllocationBudget(int max_allocations) {
+  const auto* histogram = MetricsRegistry::Get().FindHistogram("duw_ingest_allocations");
+  if (!AllocationCountingEnabled() || histogram == nullptr || histogram->Count() == 0) {
+    if (max_allocations >= 0) {
+      spdlog::critical("REPLAY_MAX_ALLOCATIONS needs a build with DUW_COUNT_ALLOCATIONS=ON");
+      return false;
+    }
+    return true;
+  }
+
+  double typical = histogram->Quantile(0.5);
+  spdlog::info("  allocs p50 {:8.1f}     p99 {:8.1f}     per ingested payload", typical,
+               histogram->Quantile(0.99));
+  if (max_allocations >= 0 && typical > max_allocations) {
+    spdlog::critical("Typical ingest made {:.1f} allocations, budget is {}", typical,
+                     max_allocations);
+    return false;
+  }
+  return true;
+}
+
+std::vector<ReplayCycle> BuildCycles(const std::vector<RecordedPayload>& payloads,
+                                     bool original_timing) {
+  std::vector<ReplayCycle> cycles;
+  cycles.reserve(payloads.size());
+  auto first_captured_at_ms = payloads.front().captured_at_ms;
+  std::int64_t last_timestamp_ms = 0;
+  for (const auto& payload : payloads) {
+    auto offset = std::chrono::milliseconds(
+        original_timing ? std::max<std::int64_t>(payload.captured_at_ms - first_captured_at_ms, 0)
+                        : 0);
+    last_timestamp_ms = std::max(payload.captured_at_ms, last_timestamp_ms + 1);
+    cycles.push_back(ReplayCycle{.offset = offset, .timestamp_ms = last_timestamp_ms});
+  }
+  return cycles;
+}
+
+}  // anonymous namespace
+
+int RunReplay(Collector& collector, const EnvServiceParams& params) {
+  if (params.replay_path.empty()) {
+    spdlog::critical("MODE=replay requires REPLAY_PATH");
+    return 1;
+  }
+  if (params.replay_timing != "fast" && params.replay_timing != "original") {
+    spdlog::critical("Unknown replay timing: {}", params.replay_timing);
+    return 1;
+  }
+
+  auto spacing = params.polling_interval_ms > 0
+                     ? std::chrono::milliseconds(params.polling_interval_ms)
+                     : std::chrono::milliseconds(std::chrono::seconds(params.polling_rate_seconds));
+  auto payloads = LoadRecording(params.replay_path, spacing);
+  if (!payloads.has_value() || payloads->empty()) {
+    spdlog::critical("No payloads to replay in {}", params.replay_path);
+    return 1;
+  }
+
+  auto cycles = BuildCycles(*payloads, params.replay_timing == "original");
+  std::vector<std::string> bodies;
+  bodies.reserve(payloads->size());
+  for (auto& payload : *payloads) {
+    bodies.push_back(std::move(payload.body));
+  }
+
+  ReplayServer server(std::move(bodies));
+  if (!server.Start()) {
+    return 1;
+  }
+
+  auto db_bytes_before = DatabaseBytes(params.db_path);
+  auto result = collector.Replay(server.Url(), cycles);
+  server.Stop();
+  if (!result.has_value()) {
+    return 1;
+  }
+
+  double elapsed_seconds = std::chrono::duration<double>(result->elapsed).count();
+  auto db_bytes_after = DatabaseBytes(params.db_path);
+  spdlog::info("Replayed {} of {} cycles in {:.3f} s ({:.1f} cycles/s)", result->completed_cycles,
+               cycles.size(), elapsed_seconds,
+               elapsed_seconds > 0 ? static_cast<double>(result->completed_cycles) / elapsed_seconds
+                                   : 0.0);
+  spdlog::info("  cycle  p50 {:8.3f} ms  p99 {:8.3f} ms",
+               PercentileMs(result->cycle_durations, 0.5),
+               PercentileMs(result->cycle_durations, 0.99));
+  ReportStage("fetch", "duw_fetch_duration_seconds", {{"source", "duw"}});
+  ReportStage("parse", "duw_parse_duration_seconds", {});
+  ReportStage("save", "duw_db_save_duration_seconds", {});
+  bool within_budget = CheckAllocationBudget(params.replay_max_allocations);
+  spdlog::info("Database grew by {} bytes ({} -> {})", db_bytes_after - db_bytes_before,
+               db_bytes_before, db_bytes_after);
+  return result->completed_cycles == cycles.size() && within_budget ? 0 : 1;
+}
+
+}  // namespace duw
@@ -0,0 +1,13 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include "../core/collector.h"
+#include "../services/env_service.h"
+
+namespace duw {
+
+int RunReplay(Collector& collector, const EnvServiceParams& params);
+
+}  // namespace duw
+
+#endif  // REPLAY_H
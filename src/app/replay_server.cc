@@ -0,0 +1,55 @@
+#include "replay_server.h"
+
+#include <spdlog/spdlog.h>
+
+namespace duw {
+
+namespace {
+
+constexpr int HTTP_GONE = 410;
+constexpr const char* REPLAY_HOST = "127.0.0.1";
+constexpr const char* DUW_STATUS_PATH = "/status_kolejek/query.php";
+
+}  // anonymous namespace
+
+ReplayServer::ReplayServer(std::vector<std::string> bodies) : bodies_(std::move(bodies)) {
+  server_.Get(DUW_STATUS_PATH, [this](const httplib::Request&, httplib::Response& response) {
+    auto index = next_body_.fetch_add(1, std::memory_order_relaxed);
+    if (index >= bodies_.size()) {
+      response.status = HTTP_GONE;
+      return;
+    }
+    response.set_content(bodies_[index], "application/json");
+  });
+}
+
+ReplayServer::~ReplayServer() {
+  Stop();
+}
+
+bool ReplayServer::Start() {
+  port_ = server_.bind_to_any_port(REPLAY_HOST);
+  if (port_ < 0) {
+    spdlog::error("Replay server failed to bind {}", REPLAY_HOST);
+    return false;
+  }
+
+  listener_ = std::thread([this] { server_.listen_after_bind(); });
+  server_.wait_until_ready();
+  spdlog::info("Replaying {} payloads from {}", bodies_.size(), Url());
+  return true;
+}
+
+void ReplayServer::Stop() {
+  server_.stop();
+  if (listener_.joinable()) {
+    listener_.join();
+  }
+}
+
+std::string ReplayServer::Url() const {
+  return "http://" + std::string(REPLAY_HOST) + ":" + std::to_string(port_) + DUW_STATUS_PATH +
+         "?status";
+}
+
+}  // namespace duw
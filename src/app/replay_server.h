@@ -0,0 +1,36 @@
+#ifndef REPLAY_SERVER_H
+#define REPLAY_SERVER_H
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <httplib.h>
+
+namespace duw {
+
+class ReplayServer {
+ public:
+  explicit ReplayServer(std::vector<std::string> bodies);
+  ~ReplayServer();
+
+  ReplayServer(const ReplayServer&) = delete;
+  ReplayServer& operator=(const ReplayServer&) = delete;
+
+  bool Start();
+  void Stop();
+  std::string Url() const;
+
+ private:
+  std::vector<std::string> bodies_;
+  std::atomic<std::size_t> next_body_{0};
+  httplib::Server server_;
+  std::thread listener_;
+  int port_ = -1;
+};
+
+}  // namespace duw
+
+#endif  // REPLAY_SERVER_H
@@ -0,0 +1,48 @@
+#include "signal_watcher.h"
+
+#include <pthread.h>
+
+#include <cstdlib>
+
+#include <spdlog/spdlog.h>
+
+namespace duw {
+
+namespace {
+
+constexpr int WAKE_SIGNAL = SIGUSR1;
+constexpr int EXIT_SIGNAL_BASE = 128;
+
+}  // anonymous namespace
+
+SignalWatcher::SignalWatcher(Handler handler) : handler_(std::move(handler)) {
+  sigemptyset(&signals_);
+  sigaddset(&signals_, SIGINT);
+  sigaddset(&signals_, SIGTERM);
+  sigaddset(&signals_, WAKE_SIGNAL);
+  pthread_sigmask(SIG_BLOCK, &signals_, nullptr);
+  watcher_ = std::thread(&SignalWatcher::Watch, this);
+}
+
+SignalWatcher::~SignalWatcher() {
+  pthread_kill(watcher_.native_handle(), WAKE_SIGNAL);
+  watcher_.join();
+}
+
+void SignalWatcher::Watch() {
+  bool stopping = false;
+  int signal_number = 0;
+  while (sigwait(&signals_, &signal_number) == 0 && signal_number != WAKE_SIGNAL) {
+    if (stopping) {
+      spdlog::warn("Received signal {} again, exiting immediately", signal_number);
+      spdlog::shutdown();
+      std::_Exit(EXIT_SIGNAL_BASE + signal_number);
+    }
+
+    spdlog::info("Received signal {}, shutting down", signal_number);
+    stopping = true;
+    handler_(signal_number);
+  }
+}
+
+}  // namespace duw
@@ -0,0 +1,30 @@
+#ifndef SIGNAL_WATCHER_H
+#define SIGNAL_WATCHER_H
+
+#include <csignal>
+#include <functional>
+#include <thread>
+
+namespace duw {
+
+class SignalWatcher {
+ public:
+  using Handler = std::function<void(int)>;
+
+  explicit SignalWatcher(Handler handler);
+  ~SignalWatcher();
+
+  SignalWatcher(const SignalWatcher&) = delete;
+  SignalWatcher& operator=(const SignalWatcher&) = delete;
+
+ private:
+  sigset_t signals_;
+  Handler handler_;
+  std::thread watcher_;
+
+  void Watch();
+};
+
+}  // namespace duw
+
+#endif  // SIGNAL_WATCHER_H
@@ -0,0 +1,91 @@
+#include "adaptive_poll_policy.h"
+
+#include <algorithm>
+
+#include <spdlog/spdlog.h>
+
+#include "../util/metrics.h"
+
+namespace duw {
+
+namespace {
+
+constexpr int MAX_BACKOFF_SHIFT = 20;
+
+Gauge& PollIntervalGauge() {
+  static Gauge& gauge = MetricsRegistry::Get().GetGauge(
+      "duw_poll_interval_ms", "Delay before the next poll chosen by adaptive polling");
+  return gauge;
+}
+
+Gauge& CircuitOpenGauge() {
+  static Gauge& gauge = MetricsRegistry::Get().GetGauge(
+      "duw_poll_circuit_open", "1 while repeated failures hold polling at the backoff cap");
+  return gauge;
+}
+
+}  // anonymous namespace
+
+AdaptivePollPolicy::AdaptivePollPolicy(AdaptivePollOptions options,
+                                       std::chrono::milliseconds initial_interval)
+    : options_(options) {
+  options_.min_interval = std::max(options_.min_interval, std::chrono::milliseconds(1));
+  options_.max_interval = std::max(options_.max_interval, options_.min_interval);
+  options_.max_backoff = std::max(options_.max_backoff, options_.max_interval);
+  options_.circuit_failures = std::max(options_.circuit_failures, 1);
+  interval_ = std::clamp(initial_interval, options_.min_interval, options_.max_interval);
+  PublishLocked();
+}
+
+void AdaptivePollPolicy::RecordSuccess(std::size_t changed_cities, int max_queue_length_change) {
+  std::lock_guard lock(mutex_);
+  if (consecutive_failures_ >= options_.circuit_failures) {
+    spdlog::info("Upstream recovered after {} failed polls, closing circuit",
+                 consecutive_failures_);
+  }
+  consecutive_failures_ = 0;
+
+  if (max_queue_length_change >= options_.spike_queue_change) {
+    interval_ = options_.min_interval;
+  } else if (changed_cities > 0) {
+    interval_ = std::max(interval_ / 2, options_.min_interval);
+  } else {
+    interval_ = std::min(interval_ * 3 / 2, options_.max_interval);
+  }
+  PublishLocked();
+}
+
+void AdaptivePollPolicy::RecordFailure() {
+  std::lock_guard lock(mutex_);
+  consecutive_failures_++;
+  if (consecutive_failures_ == options_.circuit_failures) {
+    spdlog::warn("{} consecutive failed polls, opening circuit and probing every {} ms",
+                 consecutive_failures_, options_.max_backoff.count());
+  }
+  PublishLocked();
+}
+
+AdaptivePollPolicy::Clock::time_point AdaptivePollPolicy::NextPollTime(Clock::time_point now) {
+  std::lock_guard lock(mutex_);
+  last_poll_ = last_poll_.has_value() ? std::max(*last_poll_ + DelayLocked(), now) : now;
+  return *last_poll_;
+}
+
+std::chrono::milliseconds AdaptivePollPolicy::DelayLocked() const {
+  if (consecutive_failures_ == 0) {
+    return interval_;
+  }
+  if (consecutive_failures_ >= options_.circuit_failures) {
+    return options_.max_backoff;
+  }
+
+  auto backoff = interval_ * (1 << std::min(consecutive_failures_, MAX_BACKOFF_SHIFT));
+  return std::min(backoff, options_.max_backoff);
+}
+
+void AdaptivePollPolicy::PublishLocked() const {
+  PollIntervalGauge().Set(DelayLocked().count());
+  CircuitOpenGauge().Set(consecutive_failures_ >= options_.circuit_failures ? 1 : 0);
+}
+
+}  // namespace duw
@@ -0,0 +1,45 @@
+#ifndef ADAPTIVE_POLL_POLICY_H
+#define ADAPTIVE_POLL_POLICY_H
+
+#include <chrono>
+#include <cstddef>
+#include <mutex>
+#include <optional>
+
+namespace duw {
+
+struct AdaptivePollOptions {
+  std::chrono::milliseconds min_interval{2000};
+  std::chrono::milliseconds max_interval{60000};
+  std::chrono::milliseconds max_backoff{300000};
+  int circuit_failures = 5;
+  int spike_queue_change = 10;
+};
+
+class AdaptivePollPolicy {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  AdaptivePollPolicy(AdaptivePollOptions options, std::chrono::milliseconds initial_interval);
+
+  AdaptivePollPolicy(const AdaptivePollPolicy&) = delete;
+  AdaptivePollPolicy& operator=(const AdaptivePollPolicy&) = delete;
+
+  void RecordSuccess(std::size_t changed_cities, int max_queue_length_change);
+  void RecordFailure();
+  Clock::time_point NextPollTime(Clock::time_point now);
+
+ private:
+  AdaptivePollOptions options_;
+  std::chrono::milliseconds interval_;
+  int consecutive_failures_ = 0;
+  std::optional<Clock::time_point> last_poll_;
+  mutable std::mutex mutex_;
+
+  std::chrono::milliseconds DelayLocked() const;
+  void PublishLocked() const;
+};
+
+}  // namespace duw
+
+#endif  // ADAPTIVE_POLL_POLICY_H
@@ -0,0 +1,102 @@
+#ifndef BOUNDED_QUEUE_H
+#define BOUNDED_QUEUE_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <optional>
+
+namespace duw {
+
+enum class OverflowPolicy : std::uint8_t {
+  BLOCK = 0,
+  DROP_OLDEST = 1,
+  DROP_NEWEST = 2
+};
+
+enum class PushResult : std::uint8_t {
+  ACCEPTED = 0,
+  ACCEPTED_DROPPED_OLDEST = 1,
+  REJECTED = 2,
+  CLOSED = 3
+};
+
+template <typename T>
+class BoundedQueue {
+ public:
+  BoundedQueue(std::size_t capacity, OverflowPolicy policy)
+      : capacity_(capacity > 0 ? capacity : 1), policy_(policy) {}
+
+  BoundedQueue(const BoundedQueue&) = delete;
+  BoundedQueue& operator=(const BoundedQueue&) = delete;
+
+  PushResult Push(T item) {
+    std::unique_lock lock(mutex_);
+    if (policy_ == OverflowPolicy::BLOCK) {
+      not_full_.wait(lock, [this] { return closed_ || items_.size() < capacity_; });
+    }
+
+    if (closed_) {
+      return PushResult::CLOSED;
+    }
+
+    auto result = PushResult::ACCEPTED;
+    if (items_.size() >= capacity_) {
+      if (policy_ == OverflowPolicy::DROP_NEWEST) {
+        return PushResult::REJECTED;
+      }
+      items_.pop_front();
+      result = PushResult::ACCEPTED_DROPPED_OLDEST;
+    }
+
+    items_.push_back(std::move(item));
+    lock.unlock();
+    not_empty_.notify_one();
+    return result;
+  }
+
+  std::optional<T> Pop() {
+    std::unique_lock lock(mutex_);
+    not_empty_.wait(lock, [this] { return closed_ || !items_.empty(); });
+    if (items_.empty()) {
+      return std::nullopt;
+    }
+
+    T item = std::move(items_.front());
+    items_.pop_front();
+    lock.unlock();
+    not_full_.notify_one();
+    return item;
+  }
+
+  void Close() {
+    {
+      std::lock_guard lock(mutex_);
+      closed_ = true;
+    }
+    not_empty_.notify_all();
+    not_full_.notify_all();
+  }
+
+  std::size_t Size() const {
+    std::lock_guard lock(mutex_);
+    return items_.size();
+  }
+
+  std::size_t Capacity() const { return capacity_; }
+
+ private:
+  const std::size_t capacity_;
+  const OverflowPolicy policy_;
+  mutable std::mutex mutex_;
+  std::condition_variable not_empty_;
+  std::condition_variable not_full_;
+  std::deque<T> items_;
+  bool closed_ = false;
+};
+
+}  // namespace duw
+
+#endif  // BOUNDED_QUEUE_H
@@ -0,0 +1,115 @@
+#include "collection_target.h"
+
+#include <algorithm>
+#include <charconv>
+#include <ranges>
+
+#include <spdlog/spdlog.h>
+
+namespace duw {
+
+namespace {
+
+constexpr char ENTRY_SEPARATORS[] = " ;\n\t";
+constexpr char FIELD_SEPARATOR = '|';
+
+std::vector<std::string_view> Split(std::string_view text, char separator) {
+  std::vector<std::string_view> parts;
+  for (auto part : std::views::split(text, separator)) {
+    parts.emplace_back(part.begin(), part.end());
+  }
+  return parts;
+}
+
+std::optional<std::chrono::milliseconds> ParseMilliseconds(std::string_view text) {
+  int value = 0;
+  auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+  if (ec != std::errc{} || ptr != text.data() + text.size() || value <= 0) {
+    return std::nullopt;
+  }
+  return std::chrono::milliseconds(value);
+}
+
+std::optional<CollectionTarget> ParseEntry(std::string_view entry,
+                                           const CollectionTarget& defaults) {
+  auto fields = Split(entry, FIELD_SEPARATOR);
+  if (fields.size() < 2 || fields.size() > 5 || fields[0].empty() || fields[1].empty()) {
+    return std::nullopt;
+  }
+
+  CollectionTarget target = defaults;
+  target.name = std::string(fields[0]);
+  target.url = std::string(fields[1]);
+  if (fields.size() > 4) {
+    target.failover_for = std::string(fields[4]);
+  }
+
+  if (fields.size() > 2 && !fields[2].empty()) {
+    auto interval = ParseMilliseconds(fields[2]);
+    if (!interval.has_value()) {
+      return std::nullopt;
+    }
+    target.interval = *interval;
+  }
+
+  if (fields.size() > 3 && !fields[3].empty()) {
+    auto timeout = ParseMilliseconds(fields[3]);
+    if (!timeout.has_value()) {
+      return std::nullopt;
+    }
+    target.timeout = *timeout;
+  }
+
+  return target;
+}
+
+}  // anonymous namespace
+
+std::optional<std::vector<CollectionTarget>> ParseCollectionTargets(
+    std::string_view spec, const CollectionTarget& primary) {
+  std::vector<CollectionTarget> targets;
+  if (spec.find_first_not_of(ENTRY_SEPARATORS) == std::string_view::npos) {
+    return targets;
+  }
+  targets.push_back(primary);
+
+  std::size_t position = 0;
+  while (position < spec.size()) {
+    auto begin = spec.find_first_not_of(ENTRY_SEPARATORS, position);
+    if (begin == std::string_view::npos) {
+      break;
+    }
+    auto end = spec.find_first_of(ENTRY_SEPARATORS, begin);
+    auto entry = spec.substr(begin, end == std::string_view::npos ? end : end - begin);
+    position = end == std::string_view::npos ? spec.size() : end;
+
+    auto target = ParseEntry(entry, primary);
+    if (!target.has_value()) {
+      spdlog::error("Invalid collection target: {}", entry);
+      return std::nullopt;
+    }
+
+    bool duplicate = std::ranges::any_of(
+        targets, [&target](const CollectionTarget& other) { return other.name == target->name; });
+    if (duplicate) {
+      spdlog::error("Duplicate collection target name: {}", target->name);
+      return std::nullopt;
+    }
+
+    bool has_primary = !target->IsMirror() ||
+                       std::ranges::any_of(targets, [&target](const CollectionTarget& other) {
+                         return !other.IsMirror() && other.name == target->failover_for;
+                       });
+    if (!has_primary) {
+      spdlog::error("Mirror {} must follow its primary target {}", target->name,
+                    target->failover_for);
+      return std::nullopt;
+    }
+
+    targets.push_back(std::move(*target));
+  }
+
+  return targets;
+}
+
+}  // namespace duw
@@ -0,0 +1,27 @@
+#ifndef COLLECTION_TARGET_H
+#define COLLECTION_TARGET_H
+
+#include <chrono>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace duw {
+
+struct CollectionTarget {
+  std::string name;
+  std::string url;
+  std::chrono::milliseconds interval{5000};
+  std::chrono::milliseconds timeout{15000};
+  std::string failover_for;
+
+  bool IsMirror() const { return !failover_for.empty(); }
+};
+
+std::optional<std::vector<CollectionTarget>> ParseCollectionTargets(
+    std::string_view spec, const CollectionTarget& primary);
+
+}  // namespace duw
+
+#endif  // COLLECTION_TARGET_H
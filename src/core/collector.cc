@@ -1,94 +1,188 @@
 #include "collector.h"
 
+#include <algorithm>
+#include <atomic>
 #include <chrono>
-#include <iomanip>
-#include <optional>
+#include <filesystem>
 #include <ranges>
-#include <sstream>
-#include <thread>
+#include <vector>
 
 #include <spdlog/spdlog.h>
-#include <nlohmann/json.hpp>
 
 #include "../services/database_service.h"
 #include "../services/env_service.h"
 #include "../services/github_service.h"
 #include "../services/http_client.h"
+#include "fetch_worker_pool.h"
+#include "incremental_sync.h"
+#include "../util/allocation_counter.h"
+#include "../util/metrics.h"
+
+namespace duw {
+
+const std::string DUW_SOURCE = "duw";
 
 namespace {
 
-std::string GetCurrentTimestamp() {
-  auto now = std::chrono::system_clock::now();
-  auto time_t = std::chrono::system_clock::to_time_t(now);
-  
-  std::ostringstream oss;
-  oss << std::put_time(std::localtime(&time_t), "%Y-%m-%d %H:%M:%S");
-  return oss.str();
+struct MirrorRun {
+  const CollectionTarget* target;
+  Counter* fetch_failures;
+  std::unique_ptr<HttpClient> client;
+};
+
+struct TargetRun {
+  const CollectionTarget* target;
+  Histogram* fetch_duration;
+  Counter* fetch_failures;
+  Counter* skipped_ticks;
+  std::unique_ptr<HttpClient> client;
+  std::vector<MirrorRun> mirrors;
+  TickSchedule schedule;
+  std::chrono::steady_clock::time_point next_fire;
+  std::atomic<bool> in_flight{false};
+};
+
+struct TargetFetch {
+  FetchResult result;
+  HttpClient* client;
+  const CollectionTarget* target;
+};
+
+Histogram& FetchDuration(const std::string& source) {
+  return MetricsRegistry::Get().GetHistogram("duw_fetch_duration_seconds",
+                                             "Time to fetch one payload", {{"source", source}});
 }
 
-}  // anonymous namespace
+Counter& FetchFailures(const std::string& source) {
+  return MetricsRegistry::Get().GetCounter("duw_fetch_failures_total", "Failed fetches",
+                                           {{"source", source}});
+}
 
-namespace duw {
+Counter& Failovers(const std::string& source) {
+  return MetricsRegistry::Get().GetCounter(
+      "duw_target_failovers_total", "Polls served by a mirror after the primary failed",
+      {{"source", source}});
+}
 
-const std::string DUW_URL =
-    "https://rezerwacje.duw.pl/status_kolejek/query.php?status";
+std::unique_ptr<HttpClient> CreateTargetClient(const CollectionTarget& target,
+                                               std::chrono::milliseconds connect_timeout) {
+  return std::make_unique<HttpClient>(HttpClientOptions{
+      .connect_timeout = std::min(connect_timeout, target.timeout),
+      .read_timeout = target.timeout,
+      .write_timeout = target.timeout,
+      .total_timeout = target.timeout});
+}
 
-std::optional<std::vector<TicketInfo>> ParseJsonResponse(
-    const std::string& json_data) {
-  if (json_data.empty()) {
-    return std::nullopt;
-  }
+bool IsUsableFetch(const FetchResult& result) {
+  return result.status == FetchStatus::FETCH_NOT_MODIFIED ||
+         (result.status == FetchStatus::FETCH_OK && !result.body.empty());
+}
 
-  auto json = nlohmann::json::parse(json_data, nullptr, false);
-  if (json.is_discarded() || !json.contains("result")) {
-    return std::nullopt;
+TargetFetch FetchWithFailover(TargetRun& run) {
+  TargetFetch fetch{.result = run.client->GetIfModified(run.target->url),
+                    .client = run.client.get(),
+                    .target = run.target};
+  if (IsUsableFetch(fetch.result)) {
+    return fetch;
   }
 
-  const auto& result_obj = json["result"];
-  if (!result_obj.is_object()) {
-    return std::nullopt;
+  run.fetch_failures->Increment();
+  spdlog::error("Failed to fetch target {} ({})", run.target->name, run.target->url);
+  for (auto& mirror : run.mirrors) {
+    fetch = TargetFetch{.result = mirror.client->GetIfModified(mirror.target->url),
+                        .client = mirror.client.get(),
+                        .target = mirror.target};
+    if (IsUsableFetch(fetch.result)) {
+      Failovers(run.target->name).Increment();
+      spdlog::warn("Fetched target {} from mirror {}", run.target->name, mirror.target->name);
+      return fetch;
+    }
+    mirror.fetch_failures->Increment();
+    spdlog::error("Failed to fetch mirror {} ({})", mirror.target->name, mirror.target->url);
   }
+  return fetch;
+}
 
-  std::string timestamp = GetCurrentTimestamp();
-  std::vector<TicketInfo> tickets;
+Histogram& ParseDuration() {
+  static Histogram& histogram = MetricsRegistry::Get().GetHistogram(
+      "duw_parse_duration_seconds", "Time to parse one payload into tickets");
+  return histogram;
+}
 
-  for (const auto& [city_name, city_data] : result_obj.items()) {
-    if (!city_data.is_array() || city_data.empty()) {
-      continue;
-    }
+Histogram& IngestAllocations() {
+  static Histogram& histogram = MetricsRegistry::Get().GetHistogram(
+      "duw_ingest_allocations", "Heap allocations made while ingesting one payload", {},
+      AllocationBuckets());
+  return histogram;
+}
 
-    const auto& first_service = city_data[0];
-    if (!first_service.is_object()) {
-      continue;
-    }
+Counter& UnchangedPayloads() {
+  static Counter& counter = MetricsRegistry::Get().GetCounter(
+      "duw_unchanged_payloads_total", "Payloads skipped because they matched the previous one");
+  return counter;
+}
 
-    auto operations_count = 0;
-    auto enabled_operations = 0;
+Counter& SpoolDrainFailures() {
+  static Counter& counter = MetricsRegistry::Get().GetCounter(
+      "duw_spool_drain_failures_total", "Failed attempts to store spooled change sets");
+  return counter;
+}
 
-    if (first_service.contains("operations") && first_service["operations"].is_array()) {
-      const auto& operations = first_service["operations"];
-      operations_count = static_cast<int>(operations.size());
-      
-      enabled_operations = std::ranges::count_if(operations, 
-        [](const auto& op) { return op.is_object() && op.value("enabled", false); });
-    }
+Gauge& BootstrapDuration() {
+  static Gauge& gauge = MetricsRegistry::Get().GetGauge(
+      "duw_bootstrap_duration_ms", "Time taken to fetch the GitHub database at startup");
+  return gauge;
+}
+
+Gauge& TimeToFirstSample() {
+  static Gauge& gauge = MetricsRegistry::Get().GetGauge(
+      "duw_time_to_first_sample_ms", "Time from startup until the first payload was stored");
+  return gauge;
+}
+
+Counter& FailedCycles() {
+  static Counter& counter = MetricsRegistry::Get().GetCounter(
+      "duw_poll_failed_cycles_total", "Poll cycles that failed to collect or store data");
+  return counter;
+}
+
+void RegisterDatabaseSizeMetrics(const std::string& db_path) {
+  auto& registry = MetricsRegistry::Get();
+  auto& db_bytes = registry.GetGauge("duw_db_file_bytes", "Size of the database files on disk",
+                                     {{"file", "db"}});
+  auto& wal_bytes = registry.GetGauge("duw_db_file_bytes", "Size of the database files on disk",
+                                      {{"file", "wal"}});
+  registry.AddScrapeHook([&db_bytes, &wal_bytes, db_path] {
+    std::error_code error;
+    auto size = std::filesystem::file_size(db_path, error);
+    db_bytes.Set(error ? 0 : static_cast<std::int64_t>(size));
+    size = std::filesystem::file_size(db_path + "-wal", error);
+    wal_bytes.Set(error ? 0 : static_cast<std::int64_t>(size));
+  });
+}
+
+std::string GitHubDatabasePath(const std::string& github_repo) {
+  return github_repo + "/main/duw_data.db";
+}
 
-    tickets.emplace_back(TicketInfo{
-      .id = 0,
-      .city = city_name,
-      .queue_status = "active",
-      .queue_length = static_cast<int>(city_data.size()),
-      .timestamp = timestamp,
-      .service_name = first_service.value("name", ""),
-      .service_id = first_service.value("id", -1),
-      .operations_count = operations_count,
-      .enabled_operations = enabled_operations
-    });
+std::string StagingDatabasePath(const std::string& db_path) {
+  return db_path + ".staging";
+}
+
+void RemoveDatabaseFiles(const std::string& path) {
+  std::error_code error;
+  for (const char* suffix : {"", "-wal", "-shm"}) {
+    std::filesystem::remove(path + suffix, error);
   }
+}
 
-  return tickets.empty() ? std::nullopt : std::make_optional(std::move(tickets));
+std::string GitHubCommitMessage() {
+  return "Update DUW data - " +
+         std::to_string(std::chrono::system_clock::now().time_since_epoch().count());
 }
 
+}  // anonymous namespace
+
 Collector::Collector(std::unique_ptr<HttpClient> http_client,
                      std::unique_ptr<DatabaseService> storage,
                      std::unique_ptr<EnvService> env_service,
@@ -101,136 +195,838 @@ Collector::Collector(std::unique_ptr<HttpClient> http_client,
 Collector::~Collector() = default;
 
 int Collector::Start(bool polling_mode) {
-  if (!Initialize()) {
+  std::lock_guard lock(run_mutex_);
+  if (!Initialize(polling_mode)) {
     spdlog::critical("Failed to initialize collector");
     return 1;
   }
 
-  if (running_) {
+  if (running_.exchange(true)) {
     spdlog::warn("Collector is already running");
     return 0;
   }
 
-  running_ = true;
-
   if (polling_mode) {
+    if (staging_path_.empty()) {
+      snapshot_job_.Start();
+    } else {
+      resume_snapshots_ = true;
+    }
     RunPollingLoop();
+    snapshot_job_.Stop();
+  } else if (!targets_.empty()) {
+    RunTargetLoop(true);
+    RunStorageMaintenance();
   } else {
     CollectData();
+    RunStorageMaintenance();
   }
 
+  running_ = false;
+  return 0;
+}
+
+int Collector::BackfillRollups() {
+  auto params = env_service_->GetParams();
+  auto profile = FindStorageProfile(params.storage_profile);
+  if (!profile.has_value()) {
+    spdlog::critical("Unknown storage profile: {}", params.storage_profile);
+    return 1;
+  }
+
+  if (!storage_->Initialize(params.db_path, *profile) || !storage_->BackfillRollups()) {
+    spdlog::critical("Failed to backfill rollups in {}", params.db_path);
+    return 1;
+  }
   return 0;
 }
 
+int Collector::Vacuum() {
+  auto params = env_service_->GetParams();
+  auto profile = FindStorageProfile(params.storage_profile);
+  if (!profile.has_value()) {
+    spdlog::critical("Unknown storage profile: {}", params.storage_profile);
+    return 1;
+  }
+
+  if (!storage_->Initialize(params.db_path, *profile) || !storage_->Vacuum()) {
+    spdlog::critical("Failed to vacuum {}", params.db_path);
+    return 1;
+  }
+  return 0;
+}
+
+std::optional<ReplayResult> Collector::Replay(const std::string& url,
+                                              std::span<const ReplayCycle> cycles) {
+  std::lock_guard lock(run_mutex_);
+  if (!env_service_->GetParams().github_repo.empty()) {
+    spdlog::critical("Replay does not sync with GitHub, unset GITHUB_REPO");
+    return std::nullopt;
+  }
+  if (!Initialize()) {
+    spdlog::critical("Failed to initialize collector");
+    return std::nullopt;
+  }
+  if (running_.exchange(true)) {
+    spdlog::warn("Collector is already running");
+    return std::nullopt;
+  }
+
+  duw_url_ = url;
+  last_wal_checkpoint_ = std::chrono::steady_clock::now();
+  ReplayResult result;
+  result.cycle_durations.reserve(cycles.size());
+  auto started_at = std::chrono::steady_clock::now();
+  for (const auto& cycle : cycles) {
+    if (cycle.offset > std::chrono::milliseconds::zero() &&
+        !scheduler_.WaitUntil(started_at + cycle.offset)) {
+      break;
+    }
+
+    replay_timestamp_ms_ = cycle.timestamp_ms;
+    auto cycle_started_at = std::chrono::steady_clock::now();
+    CollectData();
+    result.cycle_durations.push_back(std::chrono::steady_clock::now() - cycle_started_at);
+    if (!running_) {
+      break;
+    }
+
+    result.completed_cycles++;
+    RunStorageMaintenance();
+  }
+  result.elapsed = std::chrono::steady_clock::now() - started_at;
+
+  replay_timestamp_ms_.reset();
+  running_ = false;
+  return result;
+}
+
 void Collector::Stop() {
-  if (!running_) {
-    spdlog::warn("Collector is not running");
+  RequestStop();
+
+  std::lock_guard lock(run_mutex_);
+  if (!initialized_) {
+    spdlog::warn("Collector was never started");
     return;
   }
 
-  running_ = false;
+  FinishBootstrap(true);
+  DrainSpool();
+  ReleaseSpool();
   PushChangesToGitHub();
 }
 
+void Collector::RequestStop() {
+  running_ = false;
+  scheduler_.Stop();
+  snapshot_job_.Stop();
+}
+
 bool Collector::IsRunning() const {
   return running_;
 }
 
-bool Collector::Initialize() {
+bool Collector::Initialize(bool background_bootstrap) {
+  started_at_ = std::chrono::steady_clock::now();
+  first_sample_recorded_ = false;
   auto params = env_service_->GetParams();
-  polling_rate_seconds_ = params.polling_rate_seconds;
+  auto overrun_policy = ParseOverrunPolicy(params.polling_overrun_policy);
+  if (!overrun_policy.has_value()) {
+    spdlog::critical("Unknown polling overrun policy: {}", params.polling_overrun_policy);
+    return false;
+  }
+  auto polling_interval =
+      params.polling_interval_ms > 0
+          ? std::chrono::milliseconds(params.polling_interval_ms)
+          : std::chrono::milliseconds(std::chrono::seconds(params.polling_rate_seconds));
+  scheduler_.Configure(SchedulerOptions{
+      .interval = polling_interval,
+      .jitter = std::chrono::milliseconds(params.polling_jitter_ms),
+      .overrun_policy = *overrun_policy});
+  adaptive_poll_.reset();
+  if (params.polling_adaptive) {
+    adaptive_poll_ = std::make_unique<AdaptivePollPolicy>(
+        AdaptivePollOptions{
+            .min_interval = std::chrono::milliseconds(params.polling_min_interval_ms),
+            .max_interval = std::chrono::milliseconds(params.polling_max_interval_ms),
+            .max_backoff = std::chrono::milliseconds(params.polling_backoff_max_ms),
+            .circuit_failures = params.polling_circuit_failures,
+            .spike_queue_change = params.polling_spike_queue_change},
+        polling_interval);
+  }
+  wal_checkpoint_interval_ = std::chrono::seconds(params.wal_checkpoint_interval_seconds);
+  retention_months_ = params.retention_months;
+  archive_dir_ = params.archive_dir;
+
+  if (params.pipeline_enabled) {
+    auto overflow_policy = ParseOverflowPolicy(params.pipeline_overflow_policy);
+    if (!overflow_policy.has_value()) {
+      spdlog::critical("Unknown pipeline overflow policy: {}", params.pipeline_overflow_policy);
+      return false;
+    }
+    pipeline_options_ = PipelineOptions{
+        .queue_capacity = static_cast<std::size_t>(params.pipeline_queue_capacity),
+        .overflow_policy = *overflow_policy};
+  }
+
+  CollectionTarget primary_target;
+  primary_target.name = DUW_SOURCE;
+  primary_target.url = params.duw_url;
+  primary_target.interval = polling_interval;
+  primary_target.timeout = std::chrono::milliseconds(
+      params.http_total_timeout_ms > 0 ? params.http_total_timeout_ms : params.http_read_timeout_ms);
+  auto targets = ParseCollectionTargets(params.collection_targets, primary_target);
+  if (!targets.has_value()) {
+    spdlog::critical("Invalid COLLECTION_TARGETS");
+    return false;
+  }
+  targets_ = std::move(*targets);
+  fetch_workers_ = static_cast<std::size_t>(std::max(params.fetch_workers, 1));
+  duw_url_ = params.duw_url;
+
+  if (!params.capture_path.empty() && capture_ == nullptr) {
+    capture_ = std::make_unique<PayloadCapture>(params.capture_path);
+    if (!capture_->IsOpen()) {
+      capture_.reset();
+      return false;
+    }
+    spdlog::info("Capturing DUW payloads to {}", params.capture_path);
+  }
   
+  if (params.github_sync_mode == "incremental") {
+    incremental_sync_ = std::make_unique<IncrementalSync>(
+        *github_service_, *storage_, static_cast<std::size_t>(params.github_sync_max_segments));
+  } else if (params.github_sync_mode != "full") {
+    spdlog::critical("Unknown GitHub sync mode: {}", params.github_sync_mode);
+    return false;
+  }
+
+  staging_path_.clear();
   if (!params.github_repo.empty()) {
-    std::string github_db_path = params.github_repo + "/main/duw_data.db";
-    if (!github_service_->FetchDatabase(github_db_path, params.db_path)) {
-      spdlog::warn("Failed to fetch database from GitHub, using local database");
+    std::string github_db_path = GitHubDatabasePath(params.github_repo);
+    if (background_bootstrap && params.github_background_bootstrap) {
+      staging_path_ = StagingDatabasePath(params.db_path);
+      bootstrap_ = std::async(std::launch::async, &Collector::FetchRemoteDatabase, this,
+                              github_db_path, params.db_path);
+      spdlog::info("Collecting into {} while the GitHub database downloads", staging_path_);
     } else {
-      spdlog::info("Successfully fetched database from GitHub");
+      FetchRemoteDatabase(github_db_path, params.db_path);
+    }
+
+    if (incremental_sync_ == nullptr) {
+      snapshot_job_.Configure(
+          SnapshotJobOptions{
+              .db_path = params.db_path,
+              .snapshot_path = params.db_path + ".snapshot",
+              .interval = std::chrono::seconds(params.github_sync_interval_seconds),
+              .snapshot = {.pages_per_step = params.snapshot_pages_per_step,
+                           .step_pause = std::chrono::milliseconds(params.snapshot_step_pause_ms)}},
+          [this, github_db_path](const std::string& snapshot_path) {
+            return github_service_->PushDatabase(github_db_path, snapshot_path,
+                                                 GitHubCommitMessage());
+          });
     }
   }
+  github_sync_interval_ = std::chrono::seconds(params.github_sync_interval_seconds);
+  last_github_sync_ = std::chrono::steady_clock::now();
   
-  return storage_->Initialize(params.db_path);
+  auto profile = FindStorageProfile(params.storage_profile);
+  if (!profile.has_value()) {
+    spdlog::critical("Unknown storage profile: {}", params.storage_profile);
+    return false;
+  }
+
+  if (staging_path_.empty() && std::filesystem::exists(StagingDatabasePath(params.db_path))) {
+    staging_path_ = StagingDatabasePath(params.db_path);
+    spdlog::info("Found staged samples in {} from a previous run", staging_path_);
+  }
+
+  if (!storage_->Initialize(staging_path_.empty() ? params.db_path : staging_path_, *profile)) {
+    return false;
+  }
+
+  if (staging_path_.empty() && incremental_sync_ != nullptr &&
+      !incremental_sync_->ApplySegments()) {
+    spdlog::warn("Some GitHub sync segments could not be applied");
+  }
+
+  if (!OpenSpool(params)) {
+    return false;
+  }
+
+  ResetChangeTracker();
+  FinishBootstrap(false);
+  if (!initialized_) {
+    RegisterDatabaseSizeMetrics(params.db_path);
+  }
+  initialized_ = true;
+  return true;
+}
+
+bool Collector::FetchRemoteDatabase(const std::string& github_db_path,
+                                    const std::string& db_path) {
+  auto started_at = std::chrono::steady_clock::now();
+  bool fetched = incremental_sync_ != nullptr
+                     ? incremental_sync_->FetchBase(github_db_path, db_path)
+                     : github_service_->FetchDatabase(github_db_path, db_path);
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - started_at);
+  BootstrapDuration().Set(elapsed.count());
+  if (!fetched) {
+    spdlog::warn("Failed to fetch database from GitHub, using local database");
+  } else {
+    spdlog::info("Successfully fetched database from GitHub in {} ms", elapsed.count());
+  }
+  return fetched;
+}
+
+void Collector::FinishBootstrap(bool wait) {
+  if (bootstrap_.has_value()) {
+    if (!wait &&
+        bootstrap_->wait_for(std::chrono::seconds::zero()) != std::future_status::ready) {
+      return;
+    }
+    bootstrap_->get();
+    bootstrap_.reset();
+  }
+
+  if (staging_path_.empty() || !MergeStagingDatabase()) {
+    return;
+  }
+
+  if (resume_snapshots_) {
+    resume_snapshots_ = false;
+    snapshot_job_.Start();
+  }
+}
+
+bool Collector::MergeStagingDatabase() {
+  auto params = env_service_->GetParams();
+  auto profile = FindStorageProfile(params.storage_profile);
+  if (!profile.has_value() || !DrainSpool()) {
+    return false;
+  }
+
+  auto staged = storage_->ReadSamplesChangedSince(0);
+  if (!staged.has_value()) {
+    spdlog::error("Failed to read staged samples from {}", staging_path_);
+    return false;
+  }
+
+  bool merged = storage_->Initialize(params.db_path, *profile);
+  if (merged && incremental_sync_ != nullptr && !incremental_sync_->ApplySegments()) {
+    spdlog::warn("Some GitHub sync segments could not be applied");
+  }
+  merged = merged && storage_->MergeSampleRecords(*staged);
+  if (!merged) {
+    spdlog::error("Failed to merge staged samples into {}, collecting into {} until the next try",
+                  params.db_path, staging_path_);
+    storage_->Initialize(staging_path_, *profile);
+    return false;
+  }
+
+  RemoveDatabaseFiles(staging_path_);
+  spdlog::info("Merged {} staged samples into {}", staged->size(), params.db_path);
+  staging_path_.clear();
+  if (spool_ != nullptr) {
+    spool_->MarkStored(storage_->LoadChangeSetSequence());
+    ReleaseSpool();
+  }
+  ResetChangeTracker();
+  return true;
+}
+
+void Collector::ResetChangeTracker() {
+  auto open_tickets = storage_->LoadOpenTickets();
+  std::lock_guard lock(ingest_mutex_);
+  change_tracker_.Reset(open_tickets);
+  if (spool_ != nullptr) {
+    for (const auto& change_set : spool_->Pending()) {
+      change_tracker_.Apply(change_set.changed);
+      change_tracker_.Forget(change_set.vanished);
+    }
+  }
+  latest_state_.Publish(change_tracker_.Latest(), GetCurrentTimestamp());
+}
+
+void Collector::RecordFirstSample() {
+  if (first_sample_recorded_) {
+    return;
+  }
+
+  first_sample_recorded_ = true;
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - started_at_);
+  TimeToFirstSample().Set(elapsed.count());
+  spdlog::info("Stored the first sample {} ms after startup", elapsed.count());
 }
 
 void Collector::CollectData() {
-  std::string duwData = FetchDuwData();
-  if (duwData.empty() || !ValidateData(duwData)) {
+  auto fetch_result = FetchDuwData();
+  if (fetch_result.status == FetchStatus::FETCH_NOT_MODIFIED) {
+    spdlog::debug("DUW data not modified since last poll");
+    if (adaptive_poll_ != nullptr) {
+      adaptive_poll_->RecordSuccess(0, 0);
+    }
+    return;
+  }
+
+  if (fetch_result.status != FetchStatus::FETCH_OK || !ValidateData(fetch_result.body)) {
     spdlog::critical("Failed to collect DUW data");
-    running_ = false;
+    FailCycle();
     return;
   }
 
-  if (!ProcessAndSaveData(duwData)) {
+  if (!ProcessAndSaveData(DUW_SOURCE, fetch_result.body)) {
     spdlog::critical("Failed to process and save data");
-    running_ = false;
+    FailCycle();
     return;
   }
+  http_client_->CommitValidators(duw_url_, std::move(fetch_result.validators));
+}
 
-  running_ = false;
+void Collector::FailCycle() {
+  FailedCycles().Increment();
+  if (adaptive_poll_ != nullptr) {
+    adaptive_poll_->RecordFailure();
+  } else {
+    running_ = false;
+  }
 }
 
-std::string Collector::FetchDuwData() {
-  std::string response = http_client_->Get(DUW_URL);
-  if (response.empty()) {
+bool Collector::WaitForNextPoll() {
+  if (adaptive_poll_ == nullptr) {
+    return scheduler_.WaitForNextTick();
+  }
+  return scheduler_.WaitUntil(adaptive_poll_->NextPollTime(std::chrono::steady_clock::now()));
+}
+
+FetchResult Collector::FetchDuwData() {
+  static Histogram& fetch_duration = FetchDuration(DUW_SOURCE);
+  static Counter& fetch_failures = FetchFailures(DUW_SOURCE);
+
+  FetchResult result;
+  {
+    ScopedTimer timer(fetch_duration);
+    result = http_client_->GetIfModified(duw_url_);
+  }
+  if (result.status == FetchStatus::FETCH_FAILED) {
+    fetch_failures.Increment();
+  }
+  if (capture_ != nullptr && result.status == FetchStatus::FETCH_OK) {
+    capture_->Record(DUW_SOURCE, GetCurrentTimestamp(), result.body);
+  }
+  if (result.status == FetchStatus::FETCH_OK && result.body.empty()) {
     spdlog::critical("Empty response from DUW API");
   }
-  return response;
+  return result;
 }
 
+bool Collector::ProcessAndSaveData(const std::string& source, const std::string& json_data) {
+  ScopedAllocationCounter allocations(IngestAllocations());
+  std::lock_guard lock(ingest_mutex_);
+  if (change_tracker_.IsUnchangedPayload(source, json_data)) {
+    if (adaptive_poll_ != nullptr) {
+      adaptive_poll_->RecordSuccess(0, 0);
+    }
+    UnchangedPayloads().Increment();
+    spdlog::debug("DUW payload unchanged, skipping");
+    return true;
+  }
 
-bool Collector::ProcessAndSaveData(const std::string& json_data) {
-  auto tickets_opt = ParseJsonResponse(json_data);
+  auto timestamp_ms =
+      replay_timestamp_ms_.has_value() ? *replay_timestamp_ms_ : GetCurrentTimestamp();
+  bool parsed = false;
+  {
+    ScopedTimer timer(ParseDuration());
+    parsed = status_parser_.Parse(json_data, timestamp_ms, parsed_tickets_);
+  }
 
-  if (!tickets_opt.has_value()) {
-    spdlog::error("JSON parsing failed");
+  if (!parsed) {
+    spdlog::error("JSON parsing failed or found no tickets");
     return false;
   }
 
-  auto tickets = tickets_opt.value();
-  if (tickets.empty()) {
-    spdlog::warn("No tickets found in response");
-    return false;
+  const auto& tickets = parsed_tickets_;
+  change_tracker_.SelectChanged(tickets, change_set_.changed);
+  change_tracker_.SelectVanished(source, tickets, change_set_.vanished);
+  change_set_.timestamp_ms = timestamp_ms;
+  std::size_t changed_count = change_set_.changed.size();
+  int queue_length_change = change_tracker_.MaxQueueLengthChange(change_set_.changed);
+  bool has_changes = changed_count > 0 || !change_set_.vanished.empty();
+  bool stored_all = true;
+  if (has_changes && spool_ != nullptr) {
+    if (!spool_->Append(change_set_)) {
+      spdlog::error("Failed to spool {} changed tickets", changed_count);
+      return false;
+    }
+    change_tracker_.Apply(change_set_.changed);
+    change_tracker_.Forget(change_set_.vanished);
+  } else if (has_changes) {
+    auto stored = StoreChanges(change_set_);
+    if (!stored.has_value()) {
+      return false;
+    }
+    stored_all = *stored;
   }
 
-  int saved_count = 0;
-  for (const auto& ticket : tickets) {
-    if (storage_->SaveTicketInfo(ticket)) {
-      saved_count++;
-    } else {
-      spdlog::error("Failed to save ticket for city: {}", ticket.city);
+  change_tracker_.Observe(source, tickets);
+  if (has_changes) {
+    latest_state_.Publish(change_tracker_.Latest(), GetCurrentTimestamp());
+  } else {
+    latest_state_.Touch(GetCurrentTimestamp());
+  }
+  if (adaptive_poll_ != nullptr) {
+    adaptive_poll_->RecordSuccess(changed_count, queue_length_change);
+  }
+  if (stored_all) {
+    change_tracker_.RememberPayload(source, json_data);
+  }
+
+  RecordFirstSample();
+  spdlog::debug("Stored {} changed of {} cities", changed_count, tickets.size());
+  return true;
+}
+
+std::optional<bool> Collector::StoreChanges(TicketChangeSet& change_set) {
+  auto& changed = change_set.changed;
+  auto result = storage_->SaveTicketInfoBatch(changed);
+  if (!result.committed) {
+    spdlog::error("Failed to save {} changed tickets", changed.size());
+    return std::nullopt;
+  }
+
+  for (auto row : result.failed_rows | std::views::reverse) {
+    spdlog::error("Failed to save ticket for city: {}", changed[row].city);
+    changed.erase(changed.begin() + static_cast<std::ptrdiff_t>(row));
+  }
+  change_tracker_.Apply(changed);
+
+  bool intervals_closed =
+      storage_->CloseTicketIntervals(change_set.vanished, change_set.timestamp_ms);
+  if (intervals_closed) {
+    change_tracker_.Forget(change_set.vanished);
+  }
+  return result.failed_rows.empty() && intervals_closed;
+}
+
+bool Collector::OpenSpool(const EnvServiceParams& params) {
+  if (!params.spool_enabled) {
+    return true;
+  }
+
+  if (spool_ == nullptr) {
+    auto path = params.spool_path.empty() ? params.db_path + ".spool" : params.spool_path;
+    spool_ = std::make_unique<SampleSpool>(path);
+    if (!spool_->IsOpen()) {
+      spool_.reset();
+      return false;
     }
   }
 
-  return saved_count > 0;
+  spool_->MarkStored(storage_->LoadChangeSetSequence());
+  ReleaseSpool();
+  auto pending_count = spool_->Pending().size();
+  if (pending_count > 0) {
+    spdlog::info("Replaying {} spooled change sets", pending_count);
+  }
+  DrainSpool();
+  return true;
+}
+
+bool Collector::DrainSpool() {
+  if (spool_ == nullptr) {
+    return true;
+  }
+
+  auto pending = spool_->Pending();
+  if (pending.empty()) {
+    return true;
+  }
+
+  auto result = storage_->SaveChangeSets(pending);
+  if (!result.committed) {
+    SpoolDrainFailures().Increment();
+    spdlog::warn("Keeping {} change sets in the spool until the database accepts writes",
+                 pending.size());
+    return false;
+  }
+
+  if (!result.failed_rows.empty()) {
+    spdlog::warn("Kept {} rejected spooled tickets in rejected_samples", result.failed_rows.size());
+  }
+  spool_->MarkStored(pending.back().sequence);
+  if (spool_->SizeBytes() >= SPOOL_RELEASE_BYTES) {
+    ReleaseSpool();
+  }
+  return true;
+}
+
+void Collector::ReleaseSpool() {
+  if (spool_ == nullptr || spool_->SizeBytes() == 0) {
+    return;
+  }
+
+  if (!storage_->FlushToDisk()) {
+    spdlog::warn("Keeping the spool until stored change sets reach the disk");
+    return;
+  }
+  spool_->DiscardThrough(spool_->StoredSequence());
 }
 
 void Collector::RunPollingLoop() {
+  last_wal_checkpoint_ = std::chrono::steady_clock::now();
+  if (spool_ != nullptr) {
+    storage_worker_.Start([this] { RunStorageMaintenance(); });
+  }
+
+  if (!targets_.empty()) {
+    RunTargetLoop(false);
+  } else if (pipeline_options_.has_value()) {
+    RunPipelinedLoop();
+  } else {
+    while (WaitForNextPoll()) {
+      CollectData();
+
+      if (!running_) {
+        break;
+      }
+
+      ScheduleStorageMaintenance();
+    }
+  }
+  storage_worker_.Stop();
+}
+
+void Collector::RunPipelinedLoop() {
+  IngestPipeline pipeline(*pipeline_options_, [this](const RawPayload& payload) {
+    if (!ProcessAndSaveData(payload.source, payload.body)) {
+      spdlog::error("Failed to process and save data");
+      if (adaptive_poll_ != nullptr) {
+        adaptive_poll_->RecordFailure();
+      }
+    } else if (payload.on_ingested) {
+      payload.on_ingested();
+    }
+    ScheduleStorageMaintenance();
+  });
+
+  while (WaitForNextPoll()) {
+    auto fetch_started_at = std::chrono::steady_clock::now();
+    auto fetch_result = FetchDuwData();
+    auto fetched_at = std::chrono::steady_clock::now();
+    pipeline.RecordFetchLatency(
+        std::chrono::duration_cast<std::chrono::microseconds>(fetched_at - fetch_started_at));
+
+    if (fetch_result.status == FetchStatus::FETCH_FAILED ||
+        (fetch_result.status == FetchStatus::FETCH_OK && !ValidateData(fetch_result.body))) {
+      spdlog::critical("Failed to collect DUW data");
+      FailCycle();
+      if (!running_) {
+        break;
+      }
+      continue;
+    }
+
+    if (fetch_result.status == FetchStatus::FETCH_NOT_MODIFIED && adaptive_poll_ != nullptr) {
+      adaptive_poll_->RecordSuccess(0, 0);
+    }
+    if (fetch_result.status == FetchStatus::FETCH_OK) {
+      pipeline.Submit(RawPayload{
+          .source = DUW_SOURCE,
+          .body = std::move(fetch_result.body),
+          .fetched_at = fetched_at,
+          .on_ingested = [this, validators = std::move(fetch_result.validators)] {
+            http_client_->CommitValidators(duw_url_, validators);
+          }});
+    }
+  }
+
+  pipeline.Close();
+}
+
+void Collector::RunTargetLoop(bool single_pass) {
+  IngestPipeline pipeline(pipeline_options_.value_or(PipelineOptions{}),
+                          [this](const RawPayload& payload) {
+                            if (!ProcessAndSaveData(payload.source, payload.body)) {
+                              spdlog::error("Failed to process and save data from {}",
+                                            payload.source);
+                            } else if (payload.on_ingested) {
+                              payload.on_ingested();
+                            }
+                            ScheduleStorageMaintenance();
+                          });
+
+  auto params = env_service_->GetParams();
+  auto now = std::chrono::steady_clock::now();
+  std::vector<std::unique_ptr<TargetRun>> runs;
+  auto connect_timeout = std::chrono::milliseconds(params.http_connect_timeout_ms);
+  for (const auto& target : targets_) {
+    if (target.IsMirror()) {
+      auto primary = std::ranges::find_if(runs, [&target](const std::unique_ptr<TargetRun>& run) {
+        return run->target->name == target.failover_for;
+      });
+      (*primary)->mirrors.push_back(
+          MirrorRun{.target = &target,
+                    .fetch_failures = &FetchFailures(target.name),
+                    .client = CreateTargetClient(target, connect_timeout)});
+      continue;
+    }
+
+    auto run = std::make_unique<TargetRun>();
+    run->target = &target;
+    run->fetch_duration = &FetchDuration(target.name);
+    run->fetch_failures = &FetchFailures(target.name);
+    run->skipped_ticks = &MetricsRegistry::Get().GetCounter(
+        "duw_target_skipped_ticks_total", "Target ticks skipped because a fetch was still running",
+        {{"source", target.name}});
+    run->client = CreateTargetClient(target, connect_timeout);
+    run->schedule = TickSchedule(SchedulerOptions{.interval = target.interval});
+    run->next_fire = run->schedule.NextFireTime(now);
+    runs.push_back(std::move(run));
+  }
+
+  FetchWorkerPool pool(std::min(fetch_workers_, runs.size()), runs.size());
+  spdlog::info("Collecting {} targets with {} fetch workers", runs.size(),
+               std::min(fetch_workers_, runs.size()));
+
   while (running_) {
-    CollectData();
+    auto next = std::ranges::min_element(
+        runs, {}, [](const std::unique_ptr<TargetRun>& run) { return run->next_fire; });
+    if (!scheduler_.WaitUntil((*next)->next_fire)) {
+      break;
+    }
 
-    if (!running_) {
+    now = std::chrono::steady_clock::now();
+    for (auto& run : runs) {
+      if (run->next_fire > now) {
+        continue;
+      }
+
+      if (run->in_flight.exchange(true)) {
+        run->skipped_ticks->Increment();
+        spdlog::warn("Target {} is still fetching, skipping its tick", run->target->name);
+      } else {
+        pool.Post([&pipeline, run = run.get()] {
+          auto started_at = std::chrono::steady_clock::now();
+          auto fetch = FetchWithFailover(*run);
+          auto fetched_at = std::chrono::steady_clock::now();
+          run->fetch_duration->ObserveDuration(fetched_at - started_at);
+          pipeline.RecordFetchLatency(
+              std::chrono::duration_cast<std::chrono::microseconds>(fetched_at - started_at));
+
+          auto& result = fetch.result;
+          if (result.status == FetchStatus::FETCH_OK && !result.body.empty()) {
+            pipeline.Submit(RawPayload{
+                .source = run->target->name,
+                .body = std::move(result.body),
+                .fetched_at = fetched_at,
+                .on_ingested = [client = fetch.client, url = fetch.target->url,
+                                validators = std::move(result.validators)] {
+                  client->CommitValidators(url, validators);
+                }});
+          }
+          run->in_flight = false;
+        });
+      }
+      run->next_fire = run->schedule.NextFireTime(now);
+    }
+
+    if (single_pass) {
       break;
     }
+  }
 
-    std::this_thread::sleep_for(std::chrono::seconds(polling_rate_seconds_));
+  pool.Close();
+  pipeline.Close();
+}
+
+void Collector::ScheduleStorageMaintenance() {
+  if (storage_worker_.IsRunning()) {
+    storage_worker_.Wake();
+  } else {
+    RunStorageMaintenance();
+  }
+}
+
+void Collector::RunStorageMaintenance() {
+  FinishBootstrap(false);
+  DrainSpool();
+  if (storage_->HasPendingMigration()) {
+    storage_->MigrateLegacyRows(MIGRATION_BATCH_ROWS);
   }
+
+  CheckpointWalIfDue();
+  ApplyRetentionIfDue();
+  PushChangesIfDue();
+}
+
+void Collector::CheckpointWalIfDue() {
+  if (wal_checkpoint_interval_ <= std::chrono::seconds::zero()) {
+    return;
+  }
+
+  auto now = std::chrono::steady_clock::now();
+  if (now - last_wal_checkpoint_ < wal_checkpoint_interval_) {
+    return;
+  }
+
+  storage_->CheckpointWal(CheckpointMode::CHECKPOINT_PASSIVE);
+  ReleaseSpool();
+  last_wal_checkpoint_ = now;
+}
+
+void Collector::ApplyRetentionIfDue() {
+  if (retention_months_ <= 0) {
+    return;
+  }
+
+  auto now = std::chrono::steady_clock::now();
+  if (last_retention_run_.has_value() && now - *last_retention_run_ < RETENTION_CHECK_INTERVAL) {
+    return;
+  }
+
+  if (!storage_->ApplyRetention(retention_months_, archive_dir_)) {
+    spdlog::error("Failed to apply retention of {} months", retention_months_);
+  }
+  last_retention_run_ = now;
 }
 
 bool Collector::ValidateData(const std::string& data) {
   return !data.empty();
 }
 
+void Collector::PushChangesIfDue() {
+  if (incremental_sync_ == nullptr || github_sync_interval_ <= std::chrono::seconds::zero()) {
+    return;
+  }
+
+  auto now = std::chrono::steady_clock::now();
+  if (now - last_github_sync_ < github_sync_interval_) {
+    return;
+  }
+
+  PushChangesToGitHub();
+  last_github_sync_ = now;
+}
+
 void Collector::PushChangesToGitHub() {
   auto params = env_service_->GetParams();
   if (params.github_repo.empty()) {
     return;
   }
+  if (!staging_path_.empty()) {
+    spdlog::warn("Skipping GitHub push until staged samples are merged");
+    return;
+  }
   
-  std::string github_db_path = params.github_repo + "/main/duw_data.db";
-  std::string commit_message = "Update DUW data - " + 
-      std::to_string(std::chrono::system_clock::now().time_since_epoch().count());
-  
-  if (github_service_->PushDatabase(github_db_path, params.db_path, commit_message)) {
+  storage_->CheckpointWal(CheckpointMode::CHECKPOINT_TRUNCATE);
+
+  bool pushed = incremental_sync_ != nullptr
+                    ? incremental_sync_->Push(GitHubDatabasePath(params.github_repo),
+                                              params.db_path, GitHubCommitMessage())
+                    : snapshot_job_.RunOnce();
+  if (pushed) {
     spdlog::info("Successfully pushed changes to GitHub");
   } else {
     spdlog::error("Failed to push changes to GitHub");
@@ -1,19 +1,54 @@
 #ifndef COLLECTOR_H
 #define COLLECTOR_H
 
+#include <atomic>
+#include <chrono>
+#include <future>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
 #include <string>
+#include <vector>
+
+#include "adaptive_poll_policy.h"
+#include "collection_target.h"
+#include "ingest_pipeline.h"
+#include "latest_state_cache.h"
+#include "payload_recording.h"
+#include "poll_scheduler.h"
+#include "sample_spool.h"
+#include "snapshot_job.h"
+#include "status_parser.h"
+#include "storage_worker.h"
+#include "ticket_change_tracker.h"
 
 namespace duw {
 
 class HttpClient;
+struct FetchResult;
 class EnvService;
+struct EnvServiceParams;
 class DatabaseService;
 class GitHubService;
+class IncrementalSync;
+
+struct ReplayCycle {
+  std::chrono::milliseconds offset{0};
+  std::int64_t timestamp_ms = 0;
+};
+
+struct ReplayResult {
+  std::size_t completed_cycles = 0;
+  std::chrono::nanoseconds elapsed{0};
+  std::vector<std::chrono::nanoseconds> cycle_durations;
+};
 
 class Collector {
  public:
-  static constexpr int DEFAULT_POLLING_RATE = 5;
+  static constexpr int MIGRATION_BATCH_ROWS = 5000;
+  static constexpr std::chrono::hours RETENTION_CHECK_INTERVAL{1};
+  static constexpr std::size_t SPOOL_RELEASE_BYTES = 1 << 20;
 
   Collector(std::unique_ptr<HttpClient> http_client,
             std::unique_ptr<DatabaseService> storage,
@@ -21,23 +56,77 @@ class Collector {
             std::unique_ptr<GitHubService> github_service);
   ~Collector();
   int Start(bool polling_mode = false);
+  int BackfillRollups();
+  int Vacuum();
+  std::optional<ReplayResult> Replay(const std::string& url, std::span<const ReplayCycle> cycles);
   void Stop();
+  void RequestStop();
   bool IsRunning() const;
+  const LatestStateCache& LatestStates() const { return latest_state_; }
 
  private:
-  bool running_ = false;
+  std::atomic<bool> running_{false};
+  bool initialized_ = false;
+  std::mutex run_mutex_;
+  PollScheduler scheduler_;
+  std::unique_ptr<AdaptivePollPolicy> adaptive_poll_;
   std::unique_ptr<HttpClient> http_client_;
   std::unique_ptr<DatabaseService> storage_;
   std::unique_ptr<EnvService> env_service_;
   std::unique_ptr<GitHubService> github_service_;
-  int polling_rate_seconds_ = DEFAULT_POLLING_RATE;
-  bool Initialize();
+  std::unique_ptr<IncrementalSync> incremental_sync_;
+  std::unique_ptr<PayloadCapture> capture_;
+  std::unique_ptr<SampleSpool> spool_;
+  StorageWorker storage_worker_;
+  std::mutex ingest_mutex_;
+  std::optional<std::future<bool>> bootstrap_;
+  std::string staging_path_;
+  bool resume_snapshots_ = false;
+  std::chrono::steady_clock::time_point started_at_;
+  bool first_sample_recorded_ = false;
+  std::string duw_url_;
+  std::optional<std::int64_t> replay_timestamp_ms_;
+  SnapshotJob snapshot_job_;
+  std::chrono::seconds github_sync_interval_{0};
+  std::chrono::steady_clock::time_point last_github_sync_;
+  TicketChangeTracker change_tracker_;
+  StatusParser status_parser_;
+  std::vector<TicketInfo> parsed_tickets_;
+  TicketChangeSet change_set_;
+  LatestStateCache latest_state_;
+  std::chrono::seconds wal_checkpoint_interval_{0};
+  std::chrono::steady_clock::time_point last_wal_checkpoint_;
+  int retention_months_ = 0;
+  std::string archive_dir_;
+  std::optional<std::chrono::steady_clock::time_point> last_retention_run_;
+  std::optional<PipelineOptions> pipeline_options_;
+  std::vector<CollectionTarget> targets_;
+  std::size_t fetch_workers_ = 1;
+  bool Initialize(bool background_bootstrap = false);
+  bool FetchRemoteDatabase(const std::string& github_db_path, const std::string& db_path);
+  void FinishBootstrap(bool wait);
+  bool MergeStagingDatabase();
+  void RecordFirstSample();
+  void ResetChangeTracker();
   void CollectData();
+  void FailCycle();
+  bool WaitForNextPoll();
   static bool ValidateData(const std::string& data);
-  std::string FetchDuwData();
+  FetchResult FetchDuwData();
   void LoadConfiguration();
-  bool ProcessAndSaveData(const std::string& json_data);
+  bool ProcessAndSaveData(const std::string& source, const std::string& json_data);
+  std::optional<bool> StoreChanges(TicketChangeSet& change_set);
+  bool DrainSpool();
+  void ReleaseSpool();
+  bool OpenSpool(const EnvServiceParams& params);
   void RunPollingLoop();
+  void RunPipelinedLoop();
+  void RunTargetLoop(bool single_pass);
+  void ScheduleStorageMaintenance();
+  void RunStorageMaintenance();
+  void CheckpointWalIfDue();
+  void ApplyRetentionIfDue();
+  void PushChangesIfDue();
   void PushChangesToGitHub();
 };
 
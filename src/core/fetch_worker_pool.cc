@@ -0,0 +1,39 @@
+#include "fetch_worker_pool.h"
+
+#include <algorithm>
+
+namespace duw {
+
+FetchWorkerPool::FetchWorkerPool(std::size_t worker_count, std::size_t queue_capacity)
+    : jobs_(queue_capacity, OverflowPolicy::BLOCK) {
+  worker_count = std::max<std::size_t>(worker_count, 1);
+  workers_.reserve(worker_count);
+  for (std::size_t i = 0; i < worker_count; ++i) {
+    workers_.emplace_back(&FetchWorkerPool::RunWorker, this);
+  }
+}
+
+FetchWorkerPool::~FetchWorkerPool() {
+  Close();
+}
+
+bool FetchWorkerPool::Post(Job job) {
+  return jobs_.Push(std::move(job)) == PushResult::ACCEPTED;
+}
+
+void FetchWorkerPool::Close() {
+  jobs_.Close();
+  for (auto& worker : workers_) {
+    if (worker.joinable()) {
+      worker.join();
+    }
+  }
+}
+
+void FetchWorkerPool::RunWorker() {
+  while (auto job = jobs_.Pop()) {
+    (*job)();
+  }
+}
+
+}  // namespace duw
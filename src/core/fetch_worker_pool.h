@@ -0,0 +1,35 @@
+#ifndef FETCH_WORKER_POOL_H
+#define FETCH_WORKER_POOL_H
+
+#include <cstddef>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include "bounded_queue.h"
+
+namespace duw {
+
+class FetchWorkerPool {
+ public:
+  using Job = std::function<void()>;
+
+  FetchWorkerPool(std::size_t worker_count, std::size_t queue_capacity);
+  ~FetchWorkerPool();
+
+  FetchWorkerPool(const FetchWorkerPool&) = delete;
+  FetchWorkerPool& operator=(const FetchWorkerPool&) = delete;
+
+  bool Post(Job job);
+  void Close();
+
+ private:
+  BoundedQueue<Job> jobs_;
+  std::vector<std::thread> workers_;
+
+  void RunWorker();
+};
+
+}  // namespace duw
+
+#endif  // FETCH_WORKER_POOL_H
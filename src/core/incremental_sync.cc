@@ -0,0 +1,300 @@
+#include "incremental_sync.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+#include <vector>
+
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+
+#include "../services/database_service.h"
+#include "../services/github_service.h"
+#include "../util/gzip.h"
+
+namespace duw {
+
+namespace {
+
+constexpr int SYNC_FORMAT_VERSION = 1;
+constexpr const char* MANIFEST_KEY = "github_manifest";
+constexpr const char* WATERMARK_KEY = "github_change_sequence";
+constexpr const char* MANIFEST_NAME = "manifest.json";
+constexpr const char* SYNC_DIR_SUFFIX = ".sync/";
+
+enum class SegmentField : std::uint8_t {
+  FIELD_CITY = 0,
+  FIELD_QUEUE_STATUS = 1,
+  FIELD_QUEUE_LENGTH = 2,
+  FIELD_TIMESTAMP = 3,
+  FIELD_SERVICE_NAME = 4,
+  FIELD_SERVICE_ID = 5,
+  FIELD_OPERATIONS_COUNT = 6,
+  FIELD_ENABLED_OPERATIONS = 7,
+  FIELD_VALID_TO = 8
+};
+
+std::optional<nlohmann::json> ParseManifest(const std::string& text) {
+  auto manifest = nlohmann::json::parse(text, nullptr, false);
+  if (manifest.is_discarded() || !manifest.is_object() ||
+      manifest.value("version", 0) != SYNC_FORMAT_VERSION ||
+      !manifest.contains("watermark_ms") || !manifest.contains("segments") ||
+      !manifest["segments"].is_array()) {
+    return std::nullopt;
+  }
+  return manifest;
+}
+
+std::int64_t ChangeTimestamp(const SampleRecord& record) {
+  return std::max(record.ticket.timestamp_ms, record.valid_to_ms.value_or(0));
+}
+
+nlohmann::json EncodeRecord(const SampleRecord& record) {
+  const auto& ticket = record.ticket;
+  nlohmann::json valid_to = nullptr;
+  if (record.valid_to_ms.has_value()) {
+    valid_to = *record.valid_to_ms;
+  }
+  return nlohmann::json::array({ticket.city, ticket.queue_status, ticket.queue_length,
+                                ticket.timestamp_ms, ticket.service_name, ticket.service_id,
+                                ticket.operations_count, ticket.enabled_operations, valid_to});
+}
+
+std::optional<SampleRecord> DecodeRecord(const nlohmann::json& row) {
+  auto field = [&row](SegmentField index) -> const nlohmann::json& {
+    return row[static_cast<std::size_t>(index)];
+  };
+
+  if (!row.is_array() || row.size() != static_cast<std::size_t>(SegmentField::FIELD_VALID_TO) + 1) {
+    return std::nullopt;
+  }
+
+  SampleRecord record;
+  try {
+    record.ticket = TicketInfo{
+        .city = field(SegmentField::FIELD_CITY).get<std::string>(),
+        .queue_status = field(SegmentField::FIELD_QUEUE_STATUS).get<std::string>(),
+        .queue_length = field(SegmentField::FIELD_QUEUE_LENGTH).get<int>(),
+        .timestamp_ms = field(SegmentField::FIELD_TIMESTAMP).get<std::int64_t>(),
+        .service_name = field(SegmentField::FIELD_SERVICE_NAME).get<std::string>(),
+        .service_id = field(SegmentField::FIELD_SERVICE_ID).get<int>(),
+        .operations_count = field(SegmentField::FIELD_OPERATIONS_COUNT).get<int>(),
+        .enabled_operations = field(SegmentField::FIELD_ENABLED_OPERATIONS).get<int>()};
+    if (!field(SegmentField::FIELD_VALID_TO).is_null()) {
+      record.valid_to_ms = field(SegmentField::FIELD_VALID_TO).get<std::int64_t>();
+    }
+  } catch (const nlohmann::json::exception&) {
+    return std::nullopt;
+  }
+  return record;
+}
+
+std::optional<std::vector<SampleRecord>> DecodeSegment(const std::string& compressed) {
+  auto text = GzipDecompress(compressed);
+  if (!text.has_value()) {
+    return std::nullopt;
+  }
+
+  auto segment = nlohmann::json::parse(*text, nullptr, false);
+  if (segment.is_discarded() || !segment.is_object() ||
+      segment.value("version", 0) != SYNC_FORMAT_VERSION || !segment.contains("rows") ||
+      !segment["rows"].is_array()) {
+    return std::nullopt;
+  }
+
+  std::vector<SampleRecord> records;
+  records.reserve(segment["rows"].size());
+  for (const auto& row : segment["rows"]) {
+    auto record = DecodeRecord(row);
+    if (!record.has_value()) {
+      return std::nullopt;
+    }
+    records.push_back(std::move(*record));
+  }
+  return records;
+}
+
+}  // anonymous namespace
+
+IncrementalSync::IncrementalSync(GitHubService& github,
+                                 DatabaseService& storage,
+                                 std::size_t max_segments)
+    : github_(github), storage_(storage), max_segments_(max_segments) {}
+
+bool IncrementalSync::FetchBase(const std::string& repo_db_path, const std::string& local_path) {
+  repo_db_path_ = repo_db_path;
+  fetched_manifest_.clear();
+  applied_segments_ = 0;
+
+  auto manifest = github_.FetchFile(SyncPath(MANIFEST_NAME));
+  if (!manifest.has_value() || !ParseManifest(*manifest).has_value()) {
+    spdlog::info("No incremental sync manifest on GitHub, fetching full database");
+    return github_.FetchDatabase(repo_db_path, local_path);
+  }
+
+  if (!github_.FetchDatabase(repo_db_path, local_path)) {
+    return false;
+  }
+
+  fetched_manifest_ = std::move(*manifest);
+  return true;
+}
+
+bool IncrementalSync::ApplySegments() {
+  if (fetched_manifest_.empty()) {
+    return true;
+  }
+
+  auto manifest = ParseManifest(fetched_manifest_);
+  auto& segments = (*manifest)["segments"];
+  std::size_t applied_rows = 0;
+  for (; applied_segments_ < segments.size(); ++applied_segments_) {
+    auto path = segments[applied_segments_].value("path", std::string());
+    auto compressed = github_.FetchFile(SyncPath(path));
+    auto records = compressed.has_value() ? DecodeSegment(*compressed) : std::nullopt;
+    if (!records.has_value() || !storage_.ApplySampleRecords(*records)) {
+      spdlog::error("Failed to apply sync segment {}, stopping at it", path);
+      break;
+    }
+    applied_rows += records->size();
+  }
+
+  std::size_t segment_count = segments.size();
+  bool applied_all = applied_segments_ == segment_count;
+  std::string applied_manifest = fetched_manifest_;
+  if (!applied_all) {
+    (*manifest)["watermark_ms"] =
+        applied_segments_ > 0
+            ? segments[applied_segments_ - 1].value("to_ms", std::int64_t{0})
+            : manifest->value("base_watermark_ms", std::int64_t{0});
+    segments.erase(segments.begin() + static_cast<std::ptrdiff_t>(applied_segments_),
+                   segments.end());
+    applied_manifest = manifest->dump(2);
+  }
+
+  auto change_sequence = storage_.LatestChangeSequence();
+  if (!change_sequence.has_value() || !storage_.SaveSyncValue(MANIFEST_KEY, applied_manifest) ||
+      !SaveWatermark(*change_sequence)) {
+    return false;
+  }
+
+  spdlog::info("Applied {} of {} sync segments ({} rows) on top of the base snapshot",
+               applied_segments_, segment_count, applied_rows);
+  if (applied_all) {
+    fetched_manifest_.clear();
+  }
+  return applied_all;
+}
+
+bool IncrementalSync::Push(const std::string& repo_db_path,
+                           const std::string& local_path,
+                           const std::string& commit_message) {
+  repo_db_path_ = repo_db_path;
+  if (!fetched_manifest_.empty() && !ApplySegments()) {
+    spdlog::warn("Not pushing to GitHub until all fetched sync segments are applied");
+    return false;
+  }
+
+  auto previous_manifest = storage_.LoadSyncValue(MANIFEST_KEY).value_or("");
+  auto manifest = ParseManifest(previous_manifest);
+  auto watermark = storage_.LoadSyncValue(WATERMARK_KEY);
+  if (!manifest.has_value() || !watermark.has_value() ||
+      (*manifest)["segments"].size() >= max_segments_ || storage_.HasPendingMigration()) {
+    return PushBase(local_path, commit_message, previous_manifest);
+  }
+
+  auto watermark_ms = (*manifest)["watermark_ms"].get<std::int64_t>();
+  auto changes = storage_.ReadSampleChanges(std::strtoll(watermark->c_str(), nullptr, 10));
+  if (!changes.has_value()) {
+    return false;
+  }
+  const auto& records = changes->records;
+  if (records.empty()) {
+    spdlog::info("No new samples since the last GitHub push");
+    return true;
+  }
+
+  std::int64_t segment_end_ms = watermark_ms;
+  nlohmann::json rows = nlohmann::json::array();
+  for (const auto& record : records) {
+    rows.push_back(EncodeRecord(record));
+    segment_end_ms = std::max(segment_end_ms, ChangeTimestamp(record));
+  }
+
+  nlohmann::json segment = {{"version", SYNC_FORMAT_VERSION},
+                            {"from_ms", watermark_ms},
+                            {"to_ms", segment_end_ms},
+                            {"rows", std::move(rows)}};
+  auto compressed = GzipCompress(segment.dump());
+  if (!compressed.has_value()) {
+    spdlog::error("Failed to compress sync segment");
+    return false;
+  }
+
+  std::string segment_name = "segment-" + std::to_string(segment_end_ms) + "-" +
+                             std::to_string(changes->last_sequence) + ".json.gz";
+  if (!github_.PushFile(SyncPath(segment_name), *compressed, commit_message, "")) {
+    return false;
+  }
+
+  (*manifest)["watermark_ms"] = segment_end_ms;
+  (*manifest)["segments"].push_back({{"path", segment_name},
+                                     {"from_ms", watermark_ms},
+                                     {"to_ms", segment_end_ms},
+                                     {"rows", records.size()},
+                                     {"bytes", compressed->size()}});
+  if (!PushManifest(manifest->dump(2), commit_message, previous_manifest) ||
+      !SaveWatermark(changes->last_sequence)) {
+    return false;
+  }
+
+  spdlog::info("Pushed sync segment with {} rows ({} bytes compressed)", records.size(),
+               compressed->size());
+  return true;
+}
+
+bool IncrementalSync::SaveWatermark(std::int64_t change_sequence) {
+  return storage_.SaveSyncValue(WATERMARK_KEY, std::to_string(change_sequence)) &&
+         storage_.PruneSampleChanges(change_sequence);
+}
+
+bool IncrementalSync::PushBase(const std::string& local_path,
+                               const std::string& commit_message,
+                               const std::string& previous_manifest) {
+  auto watermark_ms = storage_.LatestChangeTimestamp();
+  auto change_sequence = storage_.LatestChangeSequence();
+  if (!watermark_ms.has_value() || !change_sequence.has_value() ||
+      !github_.PushDatabase(repo_db_path_, local_path, commit_message)) {
+    return false;
+  }
+
+  nlohmann::json manifest = {{"version", SYNC_FORMAT_VERSION},
+                             {"base_watermark_ms", *watermark_ms},
+                             {"watermark_ms", *watermark_ms},
+                             {"segments", nlohmann::json::array()}};
+  return PushManifest(manifest.dump(2), commit_message, previous_manifest) &&
+         SaveWatermark(*change_sequence);
+}
+
+bool IncrementalSync::PushManifest(const std::string& manifest,
+                                   const std::string& commit_message,
+                                   const std::string& previous_manifest) {
+  auto remote_manifest = previous_manifest;
+  if (remote_manifest.empty()) {
+    remote_manifest = github_.FetchFile(SyncPath(MANIFEST_NAME)).value_or("");
+  }
+
+  auto previous_sha = remote_manifest.empty() ? std::string() : GitBlobSha(remote_manifest);
+  if (!github_.PushFile(SyncPath(MANIFEST_NAME), manifest, commit_message, previous_sha)) {
+    return false;
+  }
+  return storage_.SaveSyncValue(MANIFEST_KEY, manifest);
+}
+
+std::string IncrementalSync::SyncPath(const std::string& name) const {
+  return repo_db_path_ + SYNC_DIR_SUFFIX + name;
+}
+
+}  // namespace duw
@@ -0,0 +1,42 @@
+#ifndef INCREMENTAL_SYNC_H
+#define INCREMENTAL_SYNC_H
+
+#include <cstddef>
+#include <string>
+
+namespace duw {
+
+class DatabaseService;
+class GitHubService;
+
+class IncrementalSync {
+ public:
+  IncrementalSync(GitHubService& github, DatabaseService& storage, std::size_t max_segments);
+
+  bool FetchBase(const std::string& repo_db_path, const std::string& local_path);
+  bool ApplySegments();
+  bool Push(const std::string& repo_db_path,
+            const std::string& local_path,
+            const std::string& commit_message);
+
+ private:
+  GitHubService& github_;
+  DatabaseService& storage_;
+  std::size_t max_segments_;
+  std::string repo_db_path_;
+  std::string fetched_manifest_;
+  std::size_t applied_segments_ = 0;
+
+  bool SaveWatermark(std::int64_t change_sequence);
+  bool PushBase(const std::string& local_path,
+                const std::string& commit_message,
+                const std::string& previous_manifest);
+  bool PushManifest(const std::string& manifest,
+                    const std::string& commit_message,
+                    const std::string& previous_manifest);
+  std::string SyncPath(const std::string& name) const;
+};
+
+}  // namespace duw
+
+#endif  // INCREMENTAL_SYNC_H
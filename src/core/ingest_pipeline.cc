@@ -0,0 +1,121 @@
+#include "ingest_pipeline.h"
+
+#include <spdlog/spdlog.h>
+
+#include "../util/metrics.h"
+
+namespace duw {
+
+namespace {
+
+std::int64_t ElapsedMicroseconds(std::chrono::steady_clock::time_point since) {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - since)
+      .count();
+}
+
+Counter& DroppedPayloads() {
+  static Counter& counter = MetricsRegistry::Get().GetCounter(
+      "duw_ingest_dropped_payloads_total", "Payloads dropped because the ingest queue was full");
+  return counter;
+}
+
+Histogram& QueueWait() {
+  static Histogram& histogram = MetricsRegistry::Get().GetHistogram(
+      "duw_ingest_queue_wait_seconds", "Time from fetch completion until the writer picks up a payload");
+  return histogram;
+}
+
+}  // anonymous namespace
+
+std::optional<OverflowPolicy> ParseOverflowPolicy(const std::string& name) {
+  if (name == "block") {
+    return OverflowPolicy::BLOCK;
+  }
+  if (name == "drop_oldest") {
+    return OverflowPolicy::DROP_OLDEST;
+  }
+  if (name == "drop_newest") {
+    return OverflowPolicy::DROP_NEWEST;
+  }
+  return std::nullopt;
+}
+
+IngestPipeline::IngestPipeline(PipelineOptions options, Consumer consumer)
+    : queue_(options.queue_capacity, options.overflow_policy),
+      consumer_(std::move(consumer)),
+      writer_(&IngestPipeline::RunWriter, this) {}
+
+IngestPipeline::~IngestPipeline() {
+  Close();
+}
+
+bool IngestPipeline::Submit(RawPayload payload) {
+  auto result = queue_.Push(std::move(payload));
+  if (result == PushResult::CLOSED) {
+    return false;
+  }
+
+  submitted_++;
+  if (result == PushResult::REJECTED || result == PushResult::ACCEPTED_DROPPED_OLDEST) {
+    dropped_++;
+    DroppedPayloads().Increment();
+    spdlog::warn("Ingest queue full ({} payloads), dropped one payload", queue_.Capacity());
+  }
+
+  auto depth = queue_.Size();
+  auto max_depth = max_queue_depth_.load(std::memory_order_relaxed);
+  while (depth > max_depth &&
+         !max_queue_depth_.compare_exchange_weak(max_depth, depth, std::memory_order_relaxed)) {
+  }
+
+  return result != PushResult::REJECTED;
+}
+
+void IngestPipeline::RecordFetchLatency(std::chrono::microseconds latency) {
+  last_fetch_latency_us_.store(latency.count(), std::memory_order_relaxed);
+}
+
+void IngestPipeline::Close() {
+  queue_.Close();
+  if (writer_.joinable()) {
+    writer_.join();
+    auto stats = Stats();
+    spdlog::info("Ingest pipeline stopped: submitted {}, processed {}, dropped {}, max depth {}",
+                 stats.submitted, stats.processed, stats.dropped, stats.max_queue_depth);
+  }
+}
+
+PipelineStats IngestPipeline::Stats() const {
+  return PipelineStats{
+      .submitted = submitted_.load(std::memory_order_relaxed),
+      .dropped = dropped_.load(std::memory_order_relaxed),
+      .processed = processed_.load(std::memory_order_relaxed),
+      .queue_depth = queue_.Size(),
+      .max_queue_depth = max_queue_depth_.load(std::memory_order_relaxed),
+      .last_fetch_latency =
+          std::chrono::microseconds(last_fetch_latency_us_.load(std::memory_order_relaxed)),
+      .last_queue_wait =
+          std::chrono::microseconds(last_queue_wait_us_.load(std::memory_order_relaxed)),
+      .last_process_latency =
+          std::chrono::microseconds(last_process_latency_us_.load(std::memory_order_relaxed))};
+}
+
+void IngestPipeline::RunWriter() {
+  while (auto payload = queue_.Pop()) {
+    last_queue_wait_us_.store(ElapsedMicroseconds(payload->fetched_at),
+                              std::memory_order_relaxed);
+    QueueWait().ObserveDuration(std::chrono::steady_clock::now() - payload->fetched_at);
+
+    auto started_at = std::chrono::steady_clock::now();
+    consumer_(*payload);
+    last_process_latency_us_.store(ElapsedMicroseconds(started_at), std::memory_order_relaxed);
+    processed_++;
+
+    spdlog::debug("Ingest pipeline: depth {}, queue wait {} us, process {} us",
+                  queue_.Size(), last_queue_wait_us_.load(std::memory_order_relaxed),
+                  last_process_latency_us_.load(std::memory_order_relaxed));
+  }
+}
+
+}  // namespace duw
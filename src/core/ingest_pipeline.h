@@ -0,0 +1,74 @@
+#ifndef INGEST_PIPELINE_H
+#define INGEST_PIPELINE_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <string>
+#include <thread>
+
+#include "bounded_queue.h"
+
+namespace duw {
+
+struct RawPayload {
+  std::string source;
+  std::string body;
+  std::chrono::steady_clock::time_point fetched_at;
+  std::function<void()> on_ingested;
+};
+
+struct PipelineOptions {
+  std::size_t queue_capacity = 16;
+  OverflowPolicy overflow_policy = OverflowPolicy::DROP_OLDEST;
+};
+
+struct PipelineStats {
+  std::uint64_t submitted = 0;
+  std::uint64_t dropped = 0;
+  std::uint64_t processed = 0;
+  std::size_t queue_depth = 0;
+  std::size_t max_queue_depth = 0;
+  std::chrono::microseconds last_fetch_latency{0};
+  std::chrono::microseconds last_queue_wait{0};
+  std::chrono::microseconds last_process_latency{0};
+};
+
+std::optional<OverflowPolicy> ParseOverflowPolicy(const std::string& name);
+
+class IngestPipeline {
+ public:
+  using Consumer = std::function<void(const RawPayload&)>;
+
+  IngestPipeline(PipelineOptions options, Consumer consumer);
+  ~IngestPipeline();
+
+  IngestPipeline(const IngestPipeline&) = delete;
+  IngestPipeline& operator=(const IngestPipeline&) = delete;
+
+  bool Submit(RawPayload payload);
+  void RecordFetchLatency(std::chrono::microseconds latency);
+  void Close();
+  PipelineStats Stats() const;
+
+ private:
+  BoundedQueue<RawPayload> queue_;
+  Consumer consumer_;
+  std::atomic<std::uint64_t> submitted_{0};
+  std::atomic<std::uint64_t> dropped_{0};
+  std::atomic<std::uint64_t> processed_{0};
+  std::atomic<std::size_t> max_queue_depth_{0};
+  std::atomic<std::int64_t> last_fetch_latency_us_{0};
+  std::atomic<std::int64_t> last_queue_wait_us_{0};
+  std::atomic<std::int64_t> last_process_latency_us_{0};
+  std::thread writer_;
+
+  void RunWriter();
+};
+
+}  // namespace duw
+
+#endif  // INGEST_PIPELINE_H
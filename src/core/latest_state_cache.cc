@@ -0,0 +1,60 @@
+#include "latest_state_cache.h"
+
+#include <nlohmann/json.hpp>
+
+namespace duw {
+
+namespace {
+
+nlohmann::json TicketJson(const TicketInfo& ticket) {
+  return {{"city", ticket.city},
+          {"queue_status", ticket.queue_status},
+          {"queue_length", ticket.queue_length},
+          {"service_name", ticket.service_name},
+          {"service_id", ticket.service_id},
+          {"operations_count", ticket.operations_count},
+          {"enabled_operations", ticket.enabled_operations},
+          {"since_ms", ticket.timestamp_ms}};
+}
+
+}  // anonymous namespace
+
+LatestStateCache::LatestStateCache() : state_(std::make_shared<const LatestState>()) {}
+
+void LatestStateCache::Publish(std::span<const TicketInfo> tickets, std::int64_t updated_at_ms) {
+  auto state = std::make_shared<LatestState>();
+  state->city_json.reserve(tickets.size());
+
+  nlohmann::json cities = nlohmann::json::array();
+  for (const auto& ticket : tickets) {
+    auto city = TicketJson(ticket);
+    state->city_json.emplace(ticket.city, city.dump());
+    cities.push_back(std::move(city));
+  }
+  state->cities_json = cities.dump();
+
+  std::shared_ptr<const LatestState> published = std::move(state);
+  {
+    std::lock_guard lock(mutex_);
+    state_.swap(published);
+  }
+  Touch(updated_at_ms);
+}
+
+void LatestStateCache::Touch(std::int64_t updated_at_ms) {
+  updated_at_ms_.store(updated_at_ms, std::memory_order_relaxed);
+}
+
+std::shared_ptr<const LatestState> LatestStateCache::Load() const {
+  std::lock_guard lock(mutex_);
+  return state_;
+}
+
+std::string LatestStateCache::AllCitiesJson() const {
+  auto state = Load();
+  return "{\"cities\":" + state->cities_json +
+         ",\"updated_at_ms\":" + std::to_string(updated_at_ms_.load(std::memory_order_relaxed)) +
+         "}";
+}
+
+}  // namespace duw
@@ -0,0 +1,41 @@
+#ifndef LATEST_STATE_CACHE_H
+#define LATEST_STATE_CACHE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <unordered_map>
+
+#include "../services/database_service.h"
+
+namespace duw {
+
+struct LatestState {
+  std::string cities_json = "[]";
+  std::unordered_map<std::string, std::string> city_json;
+};
+
+class LatestStateCache {
+ public:
+  LatestStateCache();
+
+  LatestStateCache(const LatestStateCache&) = delete;
+  LatestStateCache& operator=(const LatestStateCache&) = delete;
+
+  void Publish(std::span<const TicketInfo> tickets, std::int64_t updated_at_ms);
+  void Touch(std::int64_t updated_at_ms);
+  std::shared_ptr<const LatestState> Load() const;
+  std::string AllCitiesJson() const;
+
+ private:
+  mutable std::mutex mutex_;
+  std::shared_ptr<const LatestState> state_;
+  std::atomic<std::int64_t> updated_at_ms_{0};
+};
+
+}  // namespace duw
+
+#endif  // LATEST_STATE_CACHE_H
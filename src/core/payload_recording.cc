@@ -0,0 +1,103 @@
+#include "payload_recording.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <sstream>
+
+#include <nlohmann/json.hpp>
+#include <spdlog/spdlog.h>
+
+#include "status_parser.h"
+
+namespace duw {
+
+namespace {
+
+constexpr const char* RECORDED_SOURCE = "duw";
+
+std::optional<std::vector<RecordedPayload>> LoadCapture(const std::string& path) {
+  std::ifstream file(path);
+  if (!file) {
+    spdlog::error("Failed to open capture {}", path);
+    return std::nullopt;
+  }
+
+  std::vector<RecordedPayload> payloads;
+  std::string line;
+  for (std::size_t line_number = 1; std::getline(file, line); ++line_number) {
+    if (line.empty()) {
+      continue;
+    }
+
+    auto entry = nlohmann::json::parse(line, nullptr, false);
+    if (entry.is_discarded() || !entry.contains("captured_at_ms") || !entry.contains("body") ||
+        !entry["captured_at_ms"].is_number_integer() || !entry["body"].is_string()) {
+      spdlog::error("Invalid capture entry at {}:{}", path, line_number);
+      return std::nullopt;
+    }
+    payloads.push_back(RecordedPayload{
+        .captured_at_ms = entry["captured_at_ms"].get<std::int64_t>(),
+        .source = entry.value("source", RECORDED_SOURCE),
+        .body = entry["body"].get<std::string>()});
+  }
+  return payloads;
+}
+
+std::optional<std::vector<RecordedPayload>> LoadDirectory(const std::string& path,
+                                                          std::chrono::milliseconds spacing) {
+  std::vector<std::filesystem::path> files;
+  std::error_code error;
+  for (const auto& entry : std::filesystem::directory_iterator(path, error)) {
+    if (entry.is_regular_file()) {
+      files.push_back(entry.path());
+    }
+  }
+  if (error) {
+    spdlog::error("Failed to list {}: {}", path, error.message());
+    return std::nullopt;
+  }
+  std::ranges::sort(files);
+
+  auto first_captured_at_ms =
+      GetCurrentTimestamp() - static_cast<std::int64_t>(files.size()) * spacing.count();
+  std::vector<RecordedPayload> payloads;
+  for (std::size_t i = 0; i < files.size(); ++i) {
+    std::ifstream file(files[i], std::ios::binary);
+    std::ostringstream body;
+    if (!file || !(body << file.rdbuf())) {
+      spdlog::error("Failed to read recorded response {}", files[i].string());
+      return std::nullopt;
+    }
+    payloads.push_back(RecordedPayload{
+        .captured_at_ms = first_captured_at_ms + static_cast<std::int64_t>(i) * spacing.count(),
+        .source = RECORDED_SOURCE,
+        .body = body.str()});
+  }
+  return payloads;
+}
+
+}  // anonymous namespace
+
+PayloadCapture::PayloadCapture(const std::string& path) : file_(path, std::ios::app) {
+  if (!file_) {
+    spdlog::error("Failed to open capture file {}", path);
+  }
+}
+
+void PayloadCapture::Record(const std::string& source, std::int64_t captured_at_ms,
+                            const std::string& body) {
+  nlohmann::json entry = {{"captured_at_ms", captured_at_ms}, {"source", source}, {"body", body}};
+  file_ << entry.dump(-1, ' ', false, nlohmann::json::error_handler_t::replace) << '\n';
+  file_.flush();
+  if (!file_) {
+    spdlog::error("Failed to append captured payload");
+    file_.clear();
+  }
+}
+
+std::optional<std::vector<RecordedPayload>> LoadRecording(const std::string& path,
+                                                          std::chrono::milliseconds spacing) {
+  return std::filesystem::is_directory(path) ? LoadDirectory(path, spacing) : LoadCapture(path);
+}
+
+}  // namespace duw
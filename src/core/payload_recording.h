@@ -0,0 +1,38 @@
+#ifndef PAYLOAD_RECORDING_H
+#define PAYLOAD_RECORDING_H
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace duw {
+
+struct RecordedPayload {
+  std::int64_t captured_at_ms = 0;
+  std::string source;
+  std::string body;
+};
+
+class PayloadCapture {
+ public:
+  explicit PayloadCapture(const std::string& path);
+
+  PayloadCapture(const PayloadCapture&) = delete;
+  PayloadCapture& operator=(const PayloadCapture&) = delete;
+
+  bool IsOpen() const { return file_.is_open(); }
+  void Record(const std::string& source, std::int64_t captured_at_ms, const std::string& body);
+
+ private:
+  std::ofstream file_;
+};
+
+std::optional<std::vector<RecordedPayload>> LoadRecording(const std::string& path,
+                                                          std::chrono::milliseconds spacing);
+
+}  // namespace duw
+
+#endif  // PAYLOAD_RECORDING_H
@@ -0,0 +1,57 @@
+#include "poll_scheduler.h"
+
+#include "../util/metrics.h"
+
+namespace duw {
+
+namespace {
+
+Counter& SkippedTickCounter() {
+  static Counter& counter = MetricsRegistry::Get().GetCounter(
+      "duw_poll_skipped_ticks_total", "Poll ticks skipped because a cycle overran");
+  return counter;
+}
+
+}  // anonymous namespace
+
+void PollScheduler::Configure(SchedulerOptions options) {
+  std::lock_guard lock(mutex_);
+  schedule_ = TickSchedule(options);
+}
+
+bool PollScheduler::WaitForNextTick() {
+  std::unique_lock lock(mutex_);
+  if (stopped_) {
+    return false;
+  }
+
+  auto skipped_before = schedule_.SkippedTicks();
+  auto fire_at = schedule_.NextFireTime(std::chrono::steady_clock::now());
+  SkippedTickCounter().Increment(schedule_.SkippedTicks() - skipped_before);
+  return !stop_requested_.wait_until(lock, fire_at, [this] { return stopped_; });
+}
+
+bool PollScheduler::WaitUntil(std::chrono::steady_clock::time_point deadline) {
+  std::unique_lock lock(mutex_);
+  return !stop_requested_.wait_until(lock, deadline, [this] { return stopped_; });
+}
+
+void PollScheduler::Stop() {
+  {
+    std::lock_guard lock(mutex_);
+    stopped_ = true;
+  }
+  stop_requested_.notify_all();
+}
+
+bool PollScheduler::IsStopped() const {
+  std::lock_guard lock(mutex_);
+  return stopped_;
+}
+
+std::uint64_t PollScheduler::SkippedTicks() const {
+  std::lock_guard lock(mutex_);
+  return schedule_.SkippedTicks();
+}
+
+}  // namespace duw
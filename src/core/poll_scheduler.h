@@ -0,0 +1,36 @@
+#ifndef POLL_SCHEDULER_H
+#define POLL_SCHEDULER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+#include "tick_schedule.h"
+
+namespace duw {
+
+class PollScheduler {
+ public:
+  PollScheduler() = default;
+
+  PollScheduler(const PollScheduler&) = delete;
+  PollScheduler& operator=(const PollScheduler&) = delete;
+
+  void Configure(SchedulerOptions options);
+  bool WaitForNextTick();
+  bool WaitUntil(std::chrono::steady_clock::time_point deadline);
+  void Stop();
+  bool IsStopped() const;
+  std::uint64_t SkippedTicks() const;
+
+ private:
+  TickSchedule schedule_;
+  bool stopped_ = false;
+  mutable std::mutex mutex_;
+  std::condition_variable stop_requested_;
+};
+
+}  // namespace duw
+
+#endif  // POLL_SCHEDULER_H
@@ -0,0 +1,311 @@
+#include "sample_spool.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <optional>
+#include <string_view>
+
+#include <spdlog/spdlog.h>
+#include <zlib.h>
+
+#include "../util/metrics.h"
+
+namespace duw {
+
+namespace {
+
+constexpr std::uint32_t RECORD_MAGIC = 0x4C4F5053;
+constexpr std::size_t RECORD_HEADER_BYTES = 20;
+constexpr std::size_t INITIAL_CAPACITY = 1 << 20;
+
+Gauge& PendingRecords() {
+  static Gauge& gauge = MetricsRegistry::Get().GetGauge(
+      "duw_spool_pending_records", "Change sets spooled but not yet stored in SQLite");
+  return gauge;
+}
+
+template <typename T>
+void Put(std::string& out, T value) {
+  out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+void PutString(std::string& out, const std::string& value) {
+  Put(out, static_cast<std::uint32_t>(value.size()));
+  out += value;
+}
+
+class SpoolReader {
+ public:
+  explicit SpoolReader(std::string_view data) : data_(data) {}
+
+  bool IsValid() const { return valid_; }
+  bool AtEnd() const { return data_.empty(); }
+
+  template <typename T>
+  T Get() {
+    T value{};
+    if (data_.size() < sizeof(value)) {
+      valid_ = false;
+      return value;
+    }
+    std::memcpy(&value, data_.data(), sizeof(value));
+    data_.remove_prefix(sizeof(value));
+    return value;
+  }
+
+  std::string GetString() {
+    auto size = Get<std::uint32_t>();
+    if (data_.size() < size) {
+      valid_ = false;
+      return {};
+    }
+    std::string value(data_.substr(0, size));
+    data_.remove_prefix(size);
+    return value;
+  }
+
+ private:
+  std::string_view data_;
+  bool valid_ = true;
+};
+
+std::string Encode(const TicketChangeSet& change_set) {
+  std::string out;
+  Put(out, change_set.timestamp_ms);
+  Put(out, static_cast<std::uint32_t>(change_set.changed.size()));
+  for (const auto& ticket : change_set.changed) {
+    PutString(out, ticket.city);
+    PutString(out, ticket.queue_status);
+    Put(out, ticket.queue_length);
+    Put(out, ticket.timestamp_ms);
+    PutString(out, ticket.service_name);
+    Put(out, ticket.service_id);
+    Put(out, ticket.operations_count);
+    Put(out, ticket.enabled_operations);
+  }
+  Put(out, static_cast<std::uint32_t>(change_set.vanished.size()));
+  for (const auto& city : change_set.vanished) {
+    PutString(out, city);
+  }
+  return out;
+}
+
+std::optional<TicketChangeSet> Decode(std::string_view payload, std::uint64_t sequence) {
+  SpoolReader reader(payload);
+  TicketChangeSet change_set;
+  change_set.timestamp_ms = reader.Get<std::int64_t>();
+  change_set.sequence = sequence;
+  for (auto count = reader.Get<std::uint32_t>(); reader.IsValid() && count > 0; --count) {
+    TicketInfo ticket;
+    ticket.city = reader.GetString();
+    ticket.queue_status = reader.GetString();
+    ticket.queue_length = reader.Get<int>();
+    ticket.timestamp_ms = reader.Get<std::int64_t>();
+    ticket.service_name = reader.GetString();
+    ticket.service_id = reader.Get<int>();
+    ticket.operations_count = reader.Get<int>();
+    ticket.enabled_operations = reader.Get<int>();
+    change_set.changed.push_back(std::move(ticket));
+  }
+  for (auto count = reader.Get<std::uint32_t>(); reader.IsValid() && count > 0; --count) {
+    change_set.vanished.push_back(reader.GetString());
+  }
+  if (!reader.IsValid() || !reader.AtEnd()) {
+    return std::nullopt;
+  }
+  return change_set;
+}
+
+std::uint32_t Checksum(std::uint64_t sequence, std::string_view payload) {
+  uLong crc = crc32(0L, reinterpret_cast<const Bytef*>(&sequence), sizeof(sequence));
+  crc = crc32(crc, reinterpret_cast<const Bytef*>(payload.data()),
+              static_cast<uInt>(payload.size()));
+  return static_cast<std::uint32_t>(crc);
+}
+
+}  // anonymous namespace
+
+SampleSpool::SampleSpool(const std::string& path) : path_(path) {
+  fd_ = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+  struct stat file_stat {};
+  if (fd_ < 0 || ::fstat(fd_, &file_stat) != 0) {
+    spdlog::error("Failed to open spool {}: {}", path, std::strerror(errno));
+    return;
+  }
+
+  auto capacity = std::max(static_cast<std::size_t>(file_stat.st_size), INITIAL_CAPACITY);
+  if (Map(capacity)) {
+    Recover();
+  }
+}
+
+SampleSpool::~SampleSpool() {
+  Unmap();
+  if (fd_ >= 0) {
+    ::close(fd_);
+  }
+}
+
+bool SampleSpool::IsOpen() const {
+  std::lock_guard lock(mutex_);
+  return !mapping_.empty();
+}
+
+bool SampleSpool::Append(TicketChangeSet change_set) {
+  std::lock_guard lock(mutex_);
+  if (mapping_.empty()) {
+    return false;
+  }
+
+  change_set.sequence = next_sequence_;
+  std::string payload = Encode(change_set);
+  std::size_t record_bytes = RECORD_HEADER_BYTES + payload.size();
+  if (write_offset_ + record_bytes > mapping_.size() &&
+      !Map(std::max(mapping_.size() * 2, write_offset_ + record_bytes))) {
+    return false;
+  }
+
+  std::string header;
+  Put(header, RECORD_MAGIC);
+  Put(header, static_cast<std::uint32_t>(payload.size()));
+  Put(header, change_set.sequence);
+  Put(header, Checksum(change_set.sequence, payload));
+  auto record = mapping_.subspan(write_offset_, record_bytes);
+  std::memcpy(record.data() + RECORD_HEADER_BYTES, payload.data(), payload.size());
+  std::memcpy(record.data(), header.data(), header.size());
+
+  auto page_size = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+  std::size_t page_start = write_offset_ / page_size * page_size;
+  if (::msync(mapping_.data() + page_start, write_offset_ + record_bytes - page_start,
+                MS_SYNC) != 0) {
+    spdlog::error("Failed to sync spool {}: {}", path_, std::strerror(errno));
+    return false;
+  }
+
+  write_offset_ += record_bytes;
+  next_sequence_++;
+  pending_.push_back(std::move(change_set));
+  PendingRecords().Set(static_cast<std::int64_t>(pending_.size()));
+  return true;
+}
+
+std::vector<TicketChangeSet> SampleSpool::Pending() const {
+  std::lock_guard lock(mutex_);
+  return pending_;
+}
+
+std::size_t SampleSpool::SizeBytes() const {
+  std::lock_guard lock(mutex_);
+  return write_offset_;
+}
+
+std::uint64_t SampleSpool::StoredSequence() const {
+  std::lock_guard lock(mutex_);
+  return stored_sequence_;
+}
+
+void SampleSpool::MarkStored(std::uint64_t sequence) {
+  std::lock_guard lock(mutex_);
+  ForgetThrough(sequence);
+}
+
+void SampleSpool::DiscardThrough(std::uint64_t sequence) {
+  std::lock_guard lock(mutex_);
+  ForgetThrough(sequence);
+  if (pending_.empty() && write_offset_ > 0) {
+    Truncate();
+  }
+}
+
+void SampleSpool::Clear() {
+  std::lock_guard lock(mutex_);
+  Truncate();
+}
+
+bool SampleSpool::Map(std::size_t capacity) {
+  Unmap();
+  if (::ftruncate(fd_, static_cast<off_t>(capacity)) != 0 || ::fdatasync(fd_) != 0) {
+    spdlog::error("Failed to resize spool {}: {}", path_, std::strerror(errno));
+    return false;
+  }
+
+  void* data = ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+  if (data == MAP_FAILED) {
+    spdlog::error("Failed to map spool {}: {}", path_, std::strerror(errno));
+    return false;
+  }
+  mapping_ = std::span(static_cast<std::byte*>(data), capacity);
+  return true;
+}
+
+void SampleSpool::Unmap() {
+  if (!mapping_.empty()) {
+    ::munmap(mapping_.data(), mapping_.size());
+    mapping_ = {};
+  }
+}
+
+void SampleSpool::ForgetThrough(std::uint64_t sequence) {
+  std::erase_if(pending_, [sequence](const TicketChangeSet& change_set) {
+    return change_set.sequence <= sequence;
+  });
+  next_sequence_ = std::max(next_sequence_, sequence + 1);
+  stored_sequence_ = std::max(stored_sequence_, sequence);
+  PendingRecords().Set(static_cast<std::int64_t>(pending_.size()));
+}
+
+void SampleSpool::Truncate() {
+  pending_.clear();
+  PendingRecords().Set(0);
+  if (mapping_.empty()) {
+    return;
+  }
+
+  Unmap();
+  if (::ftruncate(fd_, 0) != 0 || !Map(INITIAL_CAPACITY)) {
+    spdlog::error("Failed to truncate spool {}: {}", path_, std::strerror(errno));
+    return;
+  }
+  write_offset_ = 0;
+}
+
+void SampleSpool::Recover() {
+  while (write_offset_ + RECORD_HEADER_BYTES <= mapping_.size()) {
+    SpoolReader header(std::string_view(
+        reinterpret_cast<const char*>(mapping_.data() + write_offset_), RECORD_HEADER_BYTES));
+    auto magic = header.Get<std::uint32_t>();
+    auto length = header.Get<std::uint32_t>();
+    auto sequence = header.Get<std::uint64_t>();
+    auto checksum = header.Get<std::uint32_t>();
+    if (magic != RECORD_MAGIC || sequence < next_sequence_ ||
+        length > mapping_.size() - write_offset_ - RECORD_HEADER_BYTES) {
+      break;
+    }
+
+    std::string_view payload(
+        reinterpret_cast<const char*>(mapping_.data() + write_offset_ + RECORD_HEADER_BYTES),
+        length);
+    auto change_set = Checksum(sequence, payload) == checksum ? Decode(payload, sequence)
+                                                              : std::nullopt;
+    if (!change_set.has_value()) {
+      spdlog::warn("Ignoring torn spool record {} at offset {}", sequence, write_offset_);
+      break;
+    }
+
+    pending_.push_back(std::move(*change_set));
+    write_offset_ += RECORD_HEADER_BYTES + length;
+    next_sequence_ = sequence + 1;
+  }
+
+  if (!pending_.empty()) {
+    spdlog::info("Recovered {} change sets from spool {}", pending_.size(), path_);
+  }
+  PendingRecords().Set(static_cast<std::int64_t>(pending_.size()));
+}
+
+}  // namespace duw
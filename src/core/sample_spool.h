@@ -0,0 +1,51 @@
+#ifndef SAMPLE_SPOOL_H
+#define SAMPLE_SPOOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "../services/database_service.h"
+
+namespace duw {
+
+class SampleSpool {
+ public:
+  explicit SampleSpool(const std::string& path);
+  ~SampleSpool();
+
+  SampleSpool(const SampleSpool&) = delete;
+  SampleSpool& operator=(const SampleSpool&) = delete;
+
+  bool IsOpen() const;
+  bool Append(TicketChangeSet change_set);
+  std::vector<TicketChangeSet> Pending() const;
+  std::size_t SizeBytes() const;
+  std::uint64_t StoredSequence() const;
+  void MarkStored(std::uint64_t sequence);
+  void DiscardThrough(std::uint64_t sequence);
+  void Clear();
+
+ private:
+  mutable std::mutex mutex_;
+  std::string path_;
+  int fd_ = -1;
+  std::span<std::byte> mapping_;
+  std::size_t write_offset_ = 0;
+  std::uint64_t next_sequence_ = 1;
+  std::uint64_t stored_sequence_ = 0;
+  std::vector<TicketChangeSet> pending_;
+
+  bool Map(std::size_t capacity);
+  void Unmap();
+  void Recover();
+  void ForgetThrough(std::uint64_t sequence);
+  void Truncate();
+};
+
+}  // namespace duw
+
+#endif  // SAMPLE_SPOOL_H
@@ -0,0 +1,130 @@
+#include "snapshot_job.h"
+
+#include <algorithm>
+
+#include <spdlog/spdlog.h>
+
+#include "../util/metrics.h"
+
+namespace duw {
+
+namespace {
+
+Histogram& SnapshotDuration() {
+  static Histogram& histogram = MetricsRegistry::Get().GetHistogram(
+      "duw_snapshot_duration_seconds", "Time to copy the database with the backup API");
+  return histogram;
+}
+
+Histogram& SnapshotLongestStep() {
+  static Histogram& histogram = MetricsRegistry::Get().GetHistogram(
+      "duw_snapshot_longest_step_seconds", "Longest single backup step of each snapshot");
+  return histogram;
+}
+
+Counter& SnapshotFailures() {
+  static Counter& counter = MetricsRegistry::Get().GetCounter(
+      "duw_snapshot_failures_total", "Snapshots that could not be created");
+  return counter;
+}
+
+}  // anonymous namespace
+
+SnapshotJob::~SnapshotJob() {
+  Stop();
+}
+
+void SnapshotJob::Configure(SnapshotJobOptions options, Uploader uploader) {
+  std::lock_guard lock(mutex_);
+  options_ = std::move(options);
+  uploader_ = std::move(uploader);
+}
+
+bool SnapshotJob::IsConfigured() const {
+  std::lock_guard lock(mutex_);
+  return uploader_ != nullptr;
+}
+
+void SnapshotJob::Start() {
+  std::lock_guard thread_lock(thread_mutex_);
+  std::lock_guard lock(mutex_);
+  if (stopped_ || thread_.joinable() || uploader_ == nullptr ||
+      options_.interval <= std::chrono::seconds::zero()) {
+    return;
+  }
+
+  spdlog::info("Pushing database snapshots every {} s", options_.interval.count());
+  thread_ = std::thread(&SnapshotJob::Run, this);
+}
+
+void SnapshotJob::Stop() {
+  std::lock_guard thread_lock(thread_mutex_);
+  {
+    std::lock_guard lock(mutex_);
+    stopped_ = true;
+  }
+  stop_requested_.notify_all();
+
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+bool SnapshotJob::RunOnce() {
+  std::lock_guard run_lock(run_mutex_);
+  SnapshotJobOptions options;
+  Uploader uploader;
+  {
+    std::lock_guard lock(mutex_);
+    options = options_;
+    uploader = uploader_;
+  }
+  if (uploader == nullptr) {
+    return false;
+  }
+
+  auto report = CreateSnapshot(options.db_path, options.snapshot_path, options.snapshot);
+  {
+    std::lock_guard lock(mutex_);
+    if (!report.has_value()) {
+      ++stats_.failures;
+      SnapshotFailures().Increment();
+    } else {
+      SnapshotDuration().ObserveDuration(report->duration);
+      SnapshotLongestStep().ObserveDuration(report->longest_step);
+      ++stats_.snapshots;
+      stats_.last_duration = report->duration;
+      stats_.last_longest_step = report->longest_step;
+      stats_.max_longest_step = std::max(stats_.max_longest_step, report->longest_step);
+      stats_.last_pages = report->pages;
+    }
+  }
+
+  if (!report.has_value()) {
+    spdlog::error("Failed to snapshot {}", options.db_path);
+    return false;
+  }
+
+  spdlog::info("Snapshot of {} pages took {} ms in {} steps, longest step {} us",
+               report->pages, report->duration.count(), report->steps,
+               report->longest_step.count());
+  return uploader(options.snapshot_path);
+}
+
+SnapshotJobStats SnapshotJob::Stats() const {
+  std::lock_guard lock(mutex_);
+  return stats_;
+}
+
+void SnapshotJob::Run() {
+  std::unique_lock lock(mutex_);
+  while (!stop_requested_.wait_for(lock, options_.interval, [this] { return stopped_; })) {
+    lock.unlock();
+    if (!RunOnce()) {
+      spdlog::error("Periodic database sync failed");
+    }
+    lock.lock();
+  }
+}
+
+}  // namespace duw
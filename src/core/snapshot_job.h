@@ -0,0 +1,65 @@
+#ifndef SNAPSHOT_JOB_H
+#define SNAPSHOT_JOB_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "../data/db_snapshot.h"
+
+namespace duw {
+
+struct SnapshotJobOptions {
+  std::string db_path;
+  std::string snapshot_path;
+  std::chrono::seconds interval{0};
+  SnapshotOptions snapshot;
+};
+
+struct SnapshotJobStats {
+  std::uint64_t snapshots = 0;
+  std::uint64_t failures = 0;
+  std::chrono::milliseconds last_duration{0};
+  std::chrono::microseconds last_longest_step{0};
+  std::chrono::microseconds max_longest_step{0};
+  std::int64_t last_pages = 0;
+};
+
+class SnapshotJob {
+ public:
+  using Uploader = std::function<bool(const std::string& snapshot_path)>;
+
+  SnapshotJob() = default;
+  ~SnapshotJob();
+
+  SnapshotJob(const SnapshotJob&) = delete;
+  SnapshotJob& operator=(const SnapshotJob&) = delete;
+
+  void Configure(SnapshotJobOptions options, Uploader uploader);
+  bool IsConfigured() const;
+  void Start();
+  void Stop();
+  bool RunOnce();
+  SnapshotJobStats Stats() const;
+
+ private:
+  SnapshotJobOptions options_;
+  Uploader uploader_;
+  SnapshotJobStats stats_;
+  bool stopped_ = false;
+  mutable std::mutex mutex_;
+  std::mutex run_mutex_;
+  std::mutex thread_mutex_;
+  std::condition_variable stop_requested_;
+  std::thread thread_;
+
+  void Run();
+};
+
+}  // namespace duw
+
+#endif  // SNAPSHOT_JOB_H
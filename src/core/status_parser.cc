@@ -0,0 +1,356 @@
+#include "status_parser.h"
+
+#include <algorithm>
+#include <chrono>
+#include <ranges>
+#include <string>
+
+#include <nlohmann/json.hpp>
+
+namespace duw {
+
+namespace {
+
+constexpr const char* QUEUE_STATUS_ACTIVE = "active";
+
+void KeepLastPerCity(std::vector<TicketInfo>& tickets) {
+  std::size_t kept = 0;
+  for (std::size_t i = 0; i < tickets.size(); ++i) {
+    if (i + 1 < tickets.size() && tickets[i + 1].city == tickets[i].city) {
+      continue;
+    }
+    if (kept != i) {
+      std::swap(tickets[kept], tickets[i]);
+    }
+    kept++;
+  }
+  tickets.resize(kept);
+}
+
+}  // anonymous namespace
+
+class StatusSaxHandler : public nlohmann::json_sax<nlohmann::json> {
+ public:
+  void Reset(std::int64_t timestamp_ms, std::vector<TicketInfo>& tickets) {
+    timestamp_ms_ = timestamp_ms;
+    tickets_ = &tickets;
+    emitted_ = 0;
+    frames_.clear();
+    key_ = Key::OTHER;
+    result_is_object_ = false;
+  }
+
+  bool null() override {
+    OnValueStart();
+    return true;
+  }
+
+  bool boolean(bool value) override {
+    OnValueStart();
+    if (Top() == Frame::OPERATION && key_ == Key::ENABLED) {
+      operation_enabled_ = value;
+    } else if (Top() == Frame::FIRST_SERVICE && key_ == Key::ID) {
+      ticket_.service_id = value ? 1 : 0;
+    }
+    return true;
+  }
+
+  bool number_integer(number_integer_t value) override { return OnNumber(value); }
+  bool number_unsigned(number_unsigned_t value) override { return OnNumber(value); }
+  bool number_float(number_float_t value, const string_t&) override { return OnNumber(value); }
+
+  bool string(string_t& value) override {
+    OnValueStart();
+    if (Top() == Frame::FIRST_SERVICE && key_ == Key::NAME) {
+      ticket_.service_name = value;
+    }
+    return true;
+  }
+
+  bool binary(binary_t&) override {
+    OnValueStart();
+    return true;
+  }
+
+  bool start_object(std::size_t) override {
+    Frame parent = Top();
+    OnValueStart();
+    frames_.push_back(ChildFrame(parent, true));
+    if (Top() == Frame::RESULT) {
+      result_is_object_ = true;
+      emitted_ = 0;
+    } else if (Top() == Frame::FIRST_SERVICE) {
+      ResetService();
+    } else if (Top() == Frame::OPERATION) {
+      operation_enabled_ = false;
+    }
+    key_ = Key::OTHER;
+    return true;
+  }
+
+  bool key(string_t& value) override {
+    key_ = ClassifyKey(Top(), value);
+    if (Top() == Frame::RESULT) {
+      city_ = value;
+    }
+    return true;
+  }
+
+  bool end_object() override {
+    Frame frame = Top();
+    frames_.pop_back();
+    if (frame == Frame::OPERATION && operation_enabled_) {
+      ticket_.enabled_operations++;
+    } else if (frame == Frame::FIRST_SERVICE) {
+      first_service_parsed_ = true;
+    }
+    key_ = Key::OTHER;
+    return true;
+  }
+
+  bool start_array(std::size_t) override {
+    Frame parent = Top();
+    OnValueStart();
+    frames_.push_back(ChildFrame(parent, false));
+    if (Top() == Frame::CITY) {
+      city_services_ = 0;
+      first_service_parsed_ = false;
+      ticket_.city = city_;
+    } else if (Top() == Frame::OPERATIONS) {
+      ticket_.operations_count = 0;
+      ticket_.enabled_operations = 0;
+    }
+    return true;
+  }
+
+  bool end_array() override {
+    Frame frame = Top();
+    frames_.pop_back();
+    if (frame == Frame::CITY && city_services_ > 0 && first_service_parsed_) {
+      ticket_.queue_length = city_services_;
+      EmitTicket();
+    }
+    key_ = Key::OTHER;
+    return true;
+  }
+
+  bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception&) override {
+    return false;
+  }
+
+  bool Finish() {
+    auto& tickets = *tickets_;
+    tickets.resize(result_is_object_ ? emitted_ : 0);
+    std::ranges::stable_sort(tickets, {}, &TicketInfo::city);
+    KeepLastPerCity(tickets);
+    return !tickets.empty();
+  }
+
+ private:
+  enum class Frame : std::uint8_t {
+    NONE,
+    ROOT,
+    RESULT,
+    CITY,
+    FIRST_SERVICE,
+    OPERATIONS,
+    OPERATION,
+    SKIPPED
+  };
+
+  enum class Key : std::uint8_t { OTHER, RESULT, NAME, ID, OPERATIONS, ENABLED };
+
+  std::int64_t timestamp_ms_ = 0;
+  std::vector<TicketInfo>* tickets_ = nullptr;
+  std::size_t emitted_ = 0;
+  std::vector<Frame> frames_;
+  Key key_ = Key::OTHER;
+  std::string city_;
+  TicketInfo ticket_{};
+  int city_services_ = 0;
+  bool first_service_parsed_ = false;
+  bool operation_enabled_ = false;
+  bool result_is_object_ = false;
+
+  Frame Top() const { return frames_.empty() ? Frame::NONE : frames_.back(); }
+
+  Frame ChildFrame(Frame parent, bool is_object) const {
+    switch (parent) {
+      case Frame::NONE:
+        return is_object ? Frame::ROOT : Frame::SKIPPED;
+      case Frame::ROOT:
+        return key_ == Key::RESULT && is_object ? Frame::RESULT : Frame::SKIPPED;
+      case Frame::RESULT:
+        return is_object ? Frame::SKIPPED : Frame::CITY;
+      case Frame::CITY:
+        return city_services_ == 1 && is_object ? Frame::FIRST_SERVICE : Frame::SKIPPED;
+      case Frame::FIRST_SERVICE:
+        return key_ == Key::OPERATIONS && !is_object ? Frame::OPERATIONS : Frame::SKIPPED;
+      case Frame::OPERATIONS:
+        return is_object ? Frame::OPERATION : Frame::SKIPPED;
+      default:
+        return Frame::SKIPPED;
+    }
+  }
+
+  static Key ClassifyKey(Frame frame, const std::string& key) {
+    if (frame == Frame::ROOT && key == "result") {
+      return Key::RESULT;
+    }
+    if (frame == Frame::FIRST_SERVICE) {
+      if (key == "name") {
+        return Key::NAME;
+      }
+      if (key == "id") {
+        return Key::ID;
+      }
+      if (key == "operations") {
+        return Key::OPERATIONS;
+      }
+    }
+    if (frame == Frame::OPERATION && key == "enabled") {
+      return Key::ENABLED;
+    }
+    return Key::OTHER;
+  }
+
+  void OnValueStart() {
+    Frame frame = Top();
+    if (frame == Frame::CITY) {
+      city_services_++;
+    } else if (frame == Frame::OPERATIONS) {
+      ticket_.operations_count++;
+    } else if (frame == Frame::ROOT && key_ == Key::RESULT) {
+      result_is_object_ = false;
+    } else if (frame == Frame::FIRST_SERVICE) {
+      ClearServiceField();
+    } else if (frame == Frame::OPERATION && key_ == Key::ENABLED) {
+      operation_enabled_ = false;
+    }
+  }
+
+  template <typename Number>
+  bool OnNumber(Number value) {
+    OnValueStart();
+    if (Top() == Frame::FIRST_SERVICE && key_ == Key::ID) {
+      ticket_.service_id = static_cast<int>(value);
+    }
+    return true;
+  }
+
+  void ClearServiceField() {
+    if (key_ == Key::NAME) {
+      ticket_.service_name.clear();
+    } else if (key_ == Key::ID) {
+      ticket_.service_id = -1;
+    } else if (key_ == Key::OPERATIONS) {
+      ticket_.operations_count = 0;
+      ticket_.enabled_operations = 0;
+    }
+  }
+
+  void EmitTicket() {
+    auto& tickets = *tickets_;
+    if (emitted_ < tickets.size()) {
+      tickets[emitted_] = ticket_;
+    } else {
+      tickets.push_back(ticket_);
+    }
+    emitted_++;
+  }
+
+  void ResetService() {
+    ticket_.queue_status = QUEUE_STATUS_ACTIVE;
+    ticket_.timestamp_ms = timestamp_ms_;
+    ticket_.service_name.clear();
+    ticket_.service_id = -1;
+    ticket_.operations_count = 0;
+    ticket_.enabled_operations = 0;
+  }
+};
+
+StatusParser::StatusParser() : handler_(std::make_unique<StatusSaxHandler>()) {}
+
+StatusParser::~StatusParser() = default;
+
+bool StatusParser::Parse(std::string_view json_data, std::int64_t timestamp_ms,
+                         std::vector<TicketInfo>& tickets) {
+  handler_->Reset(timestamp_ms, tickets);
+  if (json_data.empty() ||
+      !nlohmann::json::sax_parse(json_data.begin(), json_data.end(), handler_.get())) {
+    tickets.clear();
+    return false;
+  }
+  return handler_->Finish();
+}
+
+std::int64_t GetCurrentTimestamp() {
+  auto now = std::chrono::system_clock::now();
+  return std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()).count();
+}
+
+std::optional<std::vector<TicketInfo>> ParseJsonResponse(std::string_view json_data,
+                                                         std::int64_t timestamp_ms) {
+  if (json_data.empty()) {
+    return std::nullopt;
+  }
+
+  auto json = nlohmann::json::parse(json_data, nullptr, false);
+  if (json.is_discarded() || !json.contains("result")) {
+    return std::nullopt;
+  }
+
+  const auto& result_obj = json["result"];
+  if (!result_obj.is_object()) {
+    return std::nullopt;
+  }
+
+  std::vector<TicketInfo> tickets;
+
+  for (const auto& [city_name, city_data] : result_obj.items()) {
+    if (!city_data.is_array() || city_data.empty()) {
+      continue;
+    }
+
+    const auto& first_service = city_data[0];
+    if (!first_service.is_object()) {
+      continue;
+    }
+
+    auto operations_count = 0;
+    auto enabled_operations = 0;
+
+    if (first_service.contains("operations") && first_service["operations"].is_array()) {
+      const auto& operations = first_service["operations"];
+      operations_count = static_cast<int>(operations.size());
+      
+      enabled_operations = std::ranges::count_if(operations, 
+        [](const auto& op) { return op.is_object() && op.value("enabled", false); });
+    }
+
+    tickets.emplace_back(TicketInfo{
+      .city = city_name,
+      .queue_status = QUEUE_STATUS_ACTIVE,
+      .queue_length = static_cast<int>(city_data.size()),
+      .timestamp_ms = timestamp_ms,
+      .service_name = first_service.value("name", ""),
+      .service_id = first_service.value("id", -1),
+      .operations_count = operations_count,
+      .enabled_operations = enabled_operations
+    });
+  }
+
+  return tickets.empty() ? std::nullopt : std::make_optional(std::move(tickets));
+}
+
+std::optional<std::vector<TicketInfo>> StreamParseJsonResponse(std::string_view json_data,
+                                                               std::int64_t timestamp_ms) {
+  StatusParser parser;
+  std::vector<TicketInfo> tickets;
+  if (!parser.Parse(json_data, timestamp_ms, tickets)) {
+    return std::nullopt;
+  }
+  return tickets;
+}
+
+}  // namespace duw
@@ -0,0 +1,41 @@
+#ifndef STATUS_PARSER_H
+#define STATUS_PARSER_H
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+#include "../services/database_service.h"
+
+namespace duw {
+
+class StatusSaxHandler;
+
+class StatusParser {
+ public:
+  StatusParser();
+  ~StatusParser();
+
+  StatusParser(const StatusParser&) = delete;
+  StatusParser& operator=(const StatusParser&) = delete;
+
+  bool Parse(std::string_view json_data, std::int64_t timestamp_ms,
+             std::vector<TicketInfo>& tickets);
+
+ private:
+  std::unique_ptr<StatusSaxHandler> handler_;
+};
+
+std::int64_t GetCurrentTimestamp();
+
+std::optional<std::vector<TicketInfo>> ParseJsonResponse(std::string_view json_data,
+                                                         std::int64_t timestamp_ms);
+
+std::optional<std::vector<TicketInfo>> StreamParseJsonResponse(std::string_view json_data,
+                                                               std::int64_t timestamp_ms);
+
+}  // namespace duw
+
+#endif  // STATUS_PARSER_H
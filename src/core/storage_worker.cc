@@ -0,0 +1,65 @@
+#include "storage_worker.h"
+
+#include <utility>
+
+namespace duw {
+
+StorageWorker::~StorageWorker() {
+  Stop();
+}
+
+void StorageWorker::Start(Task task) {
+  std::lock_guard lock(mutex_);
+  if (thread_.joinable()) {
+    return;
+  }
+
+  task_ = std::move(task);
+  wake_requested_ = false;
+  stopped_ = false;
+  thread_ = std::thread(&StorageWorker::Run, this);
+}
+
+void StorageWorker::Wake() {
+  {
+    std::lock_guard lock(mutex_);
+    wake_requested_ = true;
+  }
+  wake_.notify_one();
+}
+
+void StorageWorker::Stop() {
+  std::thread thread;
+  {
+    std::lock_guard lock(mutex_);
+    stopped_ = true;
+    thread = std::move(thread_);
+  }
+  wake_.notify_one();
+
+  if (thread.joinable()) {
+    thread.join();
+  }
+}
+
+bool StorageWorker::IsRunning() const {
+  std::lock_guard lock(mutex_);
+  return thread_.joinable();
+}
+
+void StorageWorker::Run() {
+  std::unique_lock lock(mutex_);
+  while (true) {
+    wake_.wait(lock, [this] { return wake_requested_ || stopped_; });
+    if (stopped_) {
+      return;
+    }
+
+    wake_requested_ = false;
+    lock.unlock();
+    task_();
+    lock.lock();
+  }
+}
+
+}  // namespace duw
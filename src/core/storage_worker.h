@@ -0,0 +1,39 @@
+#ifndef STORAGE_WORKER_H
+#define STORAGE_WORKER_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace duw {
+
+class StorageWorker {
+ public:
+  using Task = std::function<void()>;
+
+  StorageWorker() = default;
+  ~StorageWorker();
+
+  StorageWorker(const StorageWorker&) = delete;
+  StorageWorker& operator=(const StorageWorker&) = delete;
+
+  void Start(Task task);
+  void Wake();
+  void Stop();
+  bool IsRunning() const;
+
+ private:
+  Task task_;
+  bool wake_requested_ = false;
+  bool stopped_ = false;
+  mutable std::mutex mutex_;
+  std::condition_variable wake_;
+  std::thread thread_;
+
+  void Run();
+};
+
+}  // namespace duw
+
+#endif  // STORAGE_WORKER_H
@@ -0,0 +1,73 @@
+#include "tick_schedule.h"
+
+#include <spdlog/spdlog.h>
+
+namespace duw {
+
+std::optional<OverrunPolicy> ParseOverrunPolicy(const std::string& name) {
+  if (name == "skip") {
+    return OverrunPolicy::SKIP;
+  }
+  if (name == "coalesce") {
+    return OverrunPolicy::COALESCE;
+  }
+  return std::nullopt;
+}
+
+TickSchedule::TickSchedule() : TickSchedule(SchedulerOptions{}) {}
+
+TickSchedule::TickSchedule(SchedulerOptions options)
+    : options_(options), jitter_engine_(std::random_device{}()) {
+  if (options_.interval <= std::chrono::milliseconds::zero()) {
+    options_.interval = std::chrono::milliseconds(1);
+  }
+  if (options_.jitter < std::chrono::milliseconds::zero()) {
+    options_.jitter = std::chrono::milliseconds::zero();
+  }
+}
+
+TickSchedule::Clock::time_point TickSchedule::NextFireTime(Clock::time_point now) {
+  if (first_tick_) {
+    first_tick_ = false;
+    next_deadline_ = now;
+    return now;
+  }
+
+  return AdvanceDeadline(now) + NextJitter();
+}
+
+std::uint64_t TickSchedule::SkippedTicks() const {
+  return skipped_ticks_;
+}
+
+TickSchedule::Clock::time_point TickSchedule::AdvanceDeadline(Clock::time_point now) {
+  next_deadline_ += options_.interval;
+  if (next_deadline_ > now) {
+    return next_deadline_;
+  }
+
+  auto missed = (now - next_deadline_) / options_.interval;
+  next_deadline_ += missed * options_.interval;
+
+  if (options_.overrun_policy == OverrunPolicy::COALESCE) {
+    skipped_ticks_ += missed;
+    spdlog::warn("Polling cycle overran its interval, coalescing {} missed ticks", missed + 1);
+    return now;
+  }
+
+  next_deadline_ += options_.interval;
+  skipped_ticks_ += missed + 1;
+  spdlog::warn("Polling cycle overran its interval, skipping {} ticks", missed + 1);
+  return next_deadline_;
+}
+
+TickSchedule::Clock::duration TickSchedule::NextJitter() {
+  if (options_.jitter == std::chrono::milliseconds::zero()) {
+    return Clock::duration::zero();
+  }
+
+  std::uniform_int_distribution<std::int64_t> distribution(0, options_.jitter.count());
+  return std::chrono::milliseconds(distribution(jitter_engine_));
+}
+
+}  // namespace duw
@@ -0,0 +1,48 @@
+#ifndef TICK_SCHEDULE_H
+#define TICK_SCHEDULE_H
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <random>
+#include <string>
+
+namespace duw {
+
+enum class OverrunPolicy : std::uint8_t {
+  SKIP = 0,
+  COALESCE = 1
+};
+
+struct SchedulerOptions {
+  std::chrono::milliseconds interval{5000};
+  std::chrono::milliseconds jitter{0};
+  OverrunPolicy overrun_policy = OverrunPolicy::SKIP;
+};
+
+std::optional<OverrunPolicy> ParseOverrunPolicy(const std::string& name);
+
+class TickSchedule {
+ public:
+  using Clock = std::chrono::steady_clock;
+
+  TickSchedule();
+  explicit TickSchedule(SchedulerOptions options);
+
+  Clock::time_point NextFireTime(Clock::time_point now);
+  std::uint64_t SkippedTicks() const;
+
+ private:
+  SchedulerOptions options_;
+  Clock::time_point next_deadline_;
+  bool first_tick_ = true;
+  std::uint64_t skipped_ticks_ = 0;
+  std::minstd_rand jitter_engine_;
+
+  Clock::time_point AdvanceDeadline(Clock::time_point now);
+  Clock::duration NextJitter();
+};
+
+}  // namespace duw
+
+#endif  // TICK_SCHEDULE_H
@@ -0,0 +1,137 @@
+#include "ticket_change_tracker.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <functional>
+#include <tuple>
+
+namespace duw {
+
+void TicketChangeTracker::Reset(std::span<const TicketInfo> stored_tickets) {
+  last_payload_by_source_.clear();
+  latest_by_city_.clear();
+  cities_by_source_.clear();
+  Apply(stored_tickets);
+}
+
+bool TicketChangeTracker::IsUnchangedPayload(const std::string& source,
+                                             std::string_view payload) const {
+  auto it = last_payload_by_source_.find(source);
+  if (it == last_payload_by_source_.end()) {
+    return false;
+  }
+
+  auto fingerprint = Fingerprint(payload);
+  return fingerprint.size == it->second.size && fingerprint.hash == it->second.hash;
+}
+
+void TicketChangeTracker::RememberPayload(const std::string& source, std::string_view payload) {
+  last_payload_by_source_.insert_or_assign(source, Fingerprint(payload));
+}
+
+void TicketChangeTracker::SelectChanged(std::span<const TicketInfo> tickets,
+                                        std::vector<TicketInfo>& changed) const {
+  changed.clear();
+  for (const auto& ticket : tickets) {
+    auto it = latest_by_city_.find(ticket.city);
+    if (it == latest_by_city_.end() || !HasSameValues(it->second, ticket)) {
+      changed.push_back(ticket);
+    }
+  }
+}
+
+int TicketChangeTracker::MaxQueueLengthChange(std::span<const TicketInfo> tickets) const {
+  int max_change = 0;
+  for (const auto& ticket : tickets) {
+    auto it = latest_by_city_.find(ticket.city);
+    if (it != latest_by_city_.end()) {
+      max_change = std::max(max_change, std::abs(ticket.queue_length - it->second.queue_length));
+    }
+  }
+  return max_change;
+}
+
+void TicketChangeTracker::SelectVanished(const std::string& source,
+                                         std::span<const TicketInfo> tickets,
+                                         std::vector<std::string>& vanished) const {
+  auto owned = cities_by_source_.find(source);
+  vanished.clear();
+  for (const auto& [city, ticket] : latest_by_city_) {
+    bool present = std::ranges::any_of(
+        tickets, [&city](const TicketInfo& current) { return current.city == city; });
+    if (present || IsReportedByOtherSource(source, city)) {
+      continue;
+    }
+
+    bool owned_by_source = owned != cities_by_source_.end() && owned->second.contains(city);
+    if (owned_by_source || !IsOwnedByAnySource(city)) {
+      vanished.push_back(city);
+    }
+  }
+}
+
+void TicketChangeTracker::Apply(std::span<const TicketInfo> saved_tickets) {
+  for (const auto& ticket : saved_tickets) {
+    latest_by_city_.insert_or_assign(ticket.city, ticket);
+  }
+}
+
+void TicketChangeTracker::Observe(const std::string& source,
+                                  std::span<const TicketInfo> tickets) {
+  auto& cities = cities_by_source_[source];
+  bool unchanged = cities.size() == tickets.size() &&
+                   std::ranges::all_of(tickets, [&cities](const TicketInfo& ticket) {
+                     return cities.contains(ticket.city);
+                   });
+  if (unchanged) {
+    return;
+  }
+
+  cities.clear();
+  for (const auto& ticket : tickets) {
+    cities.insert(ticket.city);
+  }
+}
+
+void TicketChangeTracker::Forget(std::span<const std::string> cities) {
+  for (const auto& city : cities) {
+    latest_by_city_.erase(city);
+  }
+}
+
+std::vector<TicketInfo> TicketChangeTracker::Latest() const {
+  std::vector<TicketInfo> tickets;
+  tickets.reserve(latest_by_city_.size());
+  for (const auto& [city, ticket] : latest_by_city_) {
+    tickets.push_back(ticket);
+  }
+  std::ranges::sort(tickets, {}, &TicketInfo::city);
+  return tickets;
+}
+
+bool TicketChangeTracker::IsReportedByOtherSource(const std::string& source,
+                                                  const std::string& city) const {
+  return std::ranges::any_of(cities_by_source_, [&](const auto& entry) {
+    return entry.first != source && entry.second.contains(city);
+  });
+}
+
+bool TicketChangeTracker::IsOwnedByAnySource(const std::string& city) const {
+  return std::ranges::any_of(cities_by_source_,
+                             [&city](const auto& entry) { return entry.second.contains(city); });
+}
+
+TicketChangeTracker::PayloadFingerprint TicketChangeTracker::Fingerprint(
+    std::string_view payload) {
+  return PayloadFingerprint{.hash = std::hash<std::string_view>{}(payload),
+                            .size = payload.size()};
+}
+
+bool TicketChangeTracker::HasSameValues(const TicketInfo& lhs, const TicketInfo& rhs) {
+  return std::tie(lhs.queue_status, lhs.queue_length, lhs.service_name, lhs.service_id,
+                  lhs.operations_count, lhs.enabled_operations) ==
+         std::tie(rhs.queue_status, rhs.queue_length, rhs.service_name, rhs.service_id,
+                  rhs.operations_count, rhs.enabled_operations);
+}
+
+}  // namespace duw
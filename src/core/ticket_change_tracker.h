@@ -0,0 +1,52 @@
+#ifndef TICKET_CHANGE_TRACKER_H
+#define TICKET_CHANGE_TRACKER_H
+
+#include <cstddef>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "../services/database_service.h"
+
+namespace duw {
+
+class TicketChangeTracker {
+ public:
+  void Reset(std::span<const TicketInfo> stored_tickets);
+
+  bool IsUnchangedPayload(const std::string& source, std::string_view payload) const;
+  void RememberPayload(const std::string& source, std::string_view payload);
+
+  void SelectChanged(std::span<const TicketInfo> tickets, std::vector<TicketInfo>& changed) const;
+  int MaxQueueLengthChange(std::span<const TicketInfo> tickets) const;
+  void SelectVanished(const std::string& source, std::span<const TicketInfo> tickets,
+                      std::vector<std::string>& vanished) const;
+
+  void Apply(std::span<const TicketInfo> saved_tickets);
+  void Observe(const std::string& source, std::span<const TicketInfo> tickets);
+  void Forget(std::span<const std::string> cities);
+  std::vector<TicketInfo> Latest() const;
+
+ private:
+  struct PayloadFingerprint {
+    std::size_t hash;
+    std::size_t size;
+  };
+
+  std::unordered_map<std::string, PayloadFingerprint> last_payload_by_source_;
+  std::unordered_map<std::string, TicketInfo> latest_by_city_;
+  std::unordered_map<std::string, std::unordered_set<std::string>> cities_by_source_;
+
+  bool IsReportedByOtherSource(const std::string& source, const std::string& city) const;
+  bool IsOwnedByAnySource(const std::string& city) const;
+
+  static PayloadFingerprint Fingerprint(std::string_view payload);
+  static bool HasSameValues(const TicketInfo& lhs, const TicketInfo& rhs);
+};
+
+}  // namespace duw
+
+#endif  // TICKET_CHANGE_TRACKER_H
@@ -1,16 +1,31 @@
 #include "db_connection.h"
 
+#include <filesystem>
 #include <memory>
 
 #include <spdlog/spdlog.h>
 #include <sqlite3.h>
 
+#include "../util/file_sync.h"
+#include "db_statement.h"
+
 namespace duw {
 
+namespace {
+
+constexpr int SYNCHRONOUS_FULL = 2;
+
+}  // anonymous namespace
+
 DBConnection::DBConnection(const std::string& db_path) 
+    : DBConnection(db_path, OpenMode::OPEN_READ_WRITE) {}
+
+DBConnection::DBConnection(const std::string& db_path, OpenMode mode)
     : db_(nullptr, sqlite3_close) {
+  int flags = mode == OpenMode::OPEN_READ_ONLY ? SQLITE_OPEN_READONLY
+                                               : SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE;
   sqlite3* raw_db = nullptr;
-  int result_code = sqlite3_open(db_path.c_str(), &raw_db);
+  int result_code = sqlite3_open_v2(db_path.c_str(), &raw_db, flags, nullptr);
   if (result_code != SQLITE_OK) {
     spdlog::error("Cannot open database: {}", sqlite3_errmsg(raw_db));
     sqlite3_close(raw_db);
@@ -20,4 +35,90 @@ DBConnection::DBConnection(const std::string& db_path)
   }
 }
 
+DBConnection::DBConnection(const std::string& db_path, const StorageProfile& profile)
+    : DBConnection(db_path) {
+  if (IsValid()) {
+    ApplyProfile(profile);
+  }
+}
+
+bool DBConnection::CheckpointWal(CheckpointMode mode) {
+  int sqlite_mode = mode == CheckpointMode::CHECKPOINT_TRUNCATE
+                        ? SQLITE_CHECKPOINT_TRUNCATE
+                        : SQLITE_CHECKPOINT_PASSIVE;
+  int wal_frames = 0;
+  int checkpointed_frames = 0;
+  int result_code = sqlite3_wal_checkpoint_v2(db_.get(), nullptr, sqlite_mode,
+                                              &wal_frames, &checkpointed_frames);
+  if (result_code != SQLITE_OK) {
+    spdlog::warn("WAL checkpoint failed: {}", sqlite3_errmsg(db_.get()));
+    return false;
+  }
+
+  spdlog::debug("WAL checkpoint: {}/{} frames", checkpointed_frames, wal_frames);
+  return true;
+}
+
+bool DBConnection::FlushToDisk() {
+  if (HasDurableCommits()) {
+    return true;
+  }
+
+  const char* db_file = sqlite3_db_filename(db_.get(), "main");
+  if (db_file == nullptr || *db_file == '\0') {
+    return true;
+  }
+
+  std::filesystem::path wal_path = std::string(db_file) + "-wal";
+  std::error_code error;
+  bool synced = SyncToDisk(db_file) &&
+                (!std::filesystem::exists(wal_path, error) || SyncToDisk(wal_path));
+  if (!synced) {
+    spdlog::warn("Failed to flush database {} to disk", db_file);
+  }
+  return synced;
+}
+
+bool DBConnection::HasDurableCommits() {
+  DBStatement stmt(db_.get(), "PRAGMA synchronous;");
+  return stmt.IsValid() && sqlite3_step(stmt.Get()) == SQLITE_ROW &&
+         sqlite3_column_int(stmt.Get(), 0) >= SYNCHRONOUS_FULL;
+}
+
+void DBConnection::ApplyProfile(const StorageProfile& profile) {
+  sqlite3_busy_timeout(db_.get(), profile.busy_timeout_ms);
+
+  SetJournalMode(profile.journal_mode);
+  ExecutePragma("synchronous = " + profile.synchronous);
+  ExecutePragma("mmap_size = " + std::to_string(profile.mmap_size_bytes));
+  ExecutePragma("cache_size = -" + std::to_string(profile.cache_size_kib));
+  ExecutePragma("temp_store = " + profile.temp_store);
+  ExecutePragma("wal_autocheckpoint = " + std::to_string(profile.wal_autocheckpoint_pages));
+
+  spdlog::info("Using '{}' storage profile", profile.name);
+}
+
+void DBConnection::SetJournalMode(const std::string& journal_mode) {
+  DBStatement stmt(db_.get(), "PRAGMA journal_mode = " + journal_mode + ";");
+  if (!stmt.IsValid() || sqlite3_step(stmt.Get()) != SQLITE_ROW) {
+    spdlog::warn("Failed to set journal mode: {}", sqlite3_errmsg(db_.get()));
+    return;
+  }
+
+  const auto* active_mode = reinterpret_cast<const char*>(sqlite3_column_text(stmt.Get(), 0));
+  if (active_mode == nullptr || sqlite3_stricmp(active_mode, journal_mode.c_str()) != 0) {
+    spdlog::warn("Journal mode '{}' is not available, using '{}'", journal_mode,
+                 active_mode != nullptr ? active_mode : "unknown");
+  }
+}
+
+bool DBConnection::ExecutePragma(const std::string& pragma) {
+  std::string sql = "PRAGMA " + pragma + ";";
+  if (sqlite3_exec(db_.get(), sql.c_str(), nullptr, nullptr, nullptr) != SQLITE_OK) {
+    spdlog::warn("Failed to apply '{}': {}", sql, sqlite3_errmsg(db_.get()));
+    return false;
+  }
+  return true;
+}
+
 }  // namespace duw
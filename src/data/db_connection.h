@@ -1,16 +1,31 @@
 #ifndef DB_CONNECTION_H
 #define DB_CONNECTION_H
 
+#include <cstdint>
 #include <memory>
 #include <string>
 
+#include "storage_profile.h"
+
 struct sqlite3;
 
 namespace duw {
 
+enum class CheckpointMode : std::uint8_t {
+  CHECKPOINT_PASSIVE = 0,
+  CHECKPOINT_TRUNCATE = 1
+};
+
+enum class OpenMode : std::uint8_t {
+  OPEN_READ_WRITE = 0,
+  OPEN_READ_ONLY = 1
+};
+
 class DBConnection {
  public:
   explicit DBConnection(const std::string& db_path);
+  DBConnection(const std::string& db_path, OpenMode mode);
+  DBConnection(const std::string& db_path, const StorageProfile& profile);
   ~DBConnection() = default;
 
   DBConnection(const DBConnection&) = delete;
@@ -21,9 +36,16 @@ class DBConnection {
 
   sqlite3* Get() const { return db_.get(); }
   bool IsValid() const { return db_ != nullptr; }
+  bool CheckpointWal(CheckpointMode mode);
+  bool FlushToDisk();
 
  private:
   std::unique_ptr<sqlite3, int(*)(sqlite3*)> db_;
+
+  void ApplyProfile(const StorageProfile& profile);
+  void SetJournalMode(const std::string& journal_mode);
+  bool ExecutePragma(const std::string& pragma);
+  bool HasDurableCommits();
 };
 
 }  // namespace duw
@@ -0,0 +1,91 @@
+#include "db_snapshot.h"
+
+#include <filesystem>
+#include <memory>
+#include <thread>
+
+#include <spdlog/spdlog.h>
+#include <sqlite3.h>
+
+#include "db_connection.h"
+
+namespace duw {
+
+namespace {
+
+constexpr int SNAPSHOT_BUSY_TIMEOUT_MS = 5000;
+
+bool BeginReadSnapshot(sqlite3* db) {
+  return sqlite3_exec(db, "BEGIN; SELECT COUNT(*) FROM sqlite_schema;", nullptr, nullptr,
+                      nullptr) == SQLITE_OK;
+}
+
+}  // anonymous namespace
+
+std::optional<SnapshotReport> CreateSnapshot(const std::string& source_path,
+                                             const std::string& dest_path,
+                                             const SnapshotOptions& options) {
+  auto started_at = std::chrono::steady_clock::now();
+  DBConnection source(source_path, OpenMode::OPEN_READ_ONLY);
+  if (!source.IsValid()) {
+    return std::nullopt;
+  }
+  sqlite3_busy_timeout(source.Get(), SNAPSHOT_BUSY_TIMEOUT_MS);
+
+  if (!BeginReadSnapshot(source.Get())) {
+    spdlog::error("Failed to open snapshot read transaction: {}", sqlite3_errmsg(source.Get()));
+    return std::nullopt;
+  }
+
+  std::string temp_path = dest_path + ".tmp";
+  std::error_code error;
+  std::filesystem::remove(temp_path, error);
+
+  SnapshotReport report;
+  {
+    DBConnection dest(temp_path);
+    if (!dest.IsValid()) {
+      return std::nullopt;
+    }
+
+    std::unique_ptr<sqlite3_backup, int (*)(sqlite3_backup*)> backup(
+        sqlite3_backup_init(dest.Get(), "main", source.Get(), "main"), sqlite3_backup_finish);
+    if (backup == nullptr) {
+      spdlog::error("Failed to start snapshot: {}", sqlite3_errmsg(dest.Get()));
+      return std::nullopt;
+    }
+
+    int result_code = SQLITE_OK;
+    while (result_code == SQLITE_OK || result_code == SQLITE_BUSY || result_code == SQLITE_LOCKED) {
+      auto step_started_at = std::chrono::steady_clock::now();
+      result_code = sqlite3_backup_step(backup.get(), options.pages_per_step);
+      report.longest_step = std::max(
+          report.longest_step, std::chrono::duration_cast<std::chrono::microseconds>(
+                                   std::chrono::steady_clock::now() - step_started_at));
+      ++report.steps;
+
+      if (result_code != SQLITE_DONE) {
+        std::this_thread::sleep_for(options.step_pause);
+      }
+    }
+    report.pages = sqlite3_backup_pagecount(backup.get());
+
+    if (sqlite3_backup_finish(backup.release()) != SQLITE_OK || result_code != SQLITE_DONE) {
+      spdlog::error("Snapshot of {} failed: {}", source_path, sqlite3_errmsg(dest.Get()));
+      return std::nullopt;
+    }
+  }
+
+  sqlite3_exec(source.Get(), "ROLLBACK;", nullptr, nullptr, nullptr);
+  std::filesystem::rename(temp_path, dest_path, error);
+  if (error) {
+    spdlog::error("Failed to move snapshot into place: {}", error.message());
+    return std::nullopt;
+  }
+
+  report.duration = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - started_at);
+  return report;
+}
+
+}  // namespace duw
@@ -0,0 +1,29 @@
+#ifndef DB_SNAPSHOT_H
+#define DB_SNAPSHOT_H
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace duw {
+
+struct SnapshotOptions {
+  int pages_per_step = 256;
+  std::chrono::milliseconds step_pause{10};
+};
+
+struct SnapshotReport {
+  std::chrono::milliseconds duration{0};
+  std::chrono::microseconds longest_step{0};
+  int steps = 0;
+  std::int64_t pages = 0;
+};
+
+std::optional<SnapshotReport> CreateSnapshot(const std::string& source_path,
+                                             const std::string& dest_path,
+                                             const SnapshotOptions& options);
+
+}  // namespace duw
+
+#endif  // DB_SNAPSHOT_H
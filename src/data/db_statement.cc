@@ -0,0 +1,25 @@
+#include "db_statement.h"
+
+#include <spdlog/spdlog.h>
+#include <sqlite3.h>
+
+namespace duw {
+
+DBStatement::DBStatement(sqlite3* db, const std::string& sql)
+    : stmt_(nullptr, sqlite3_finalize) {
+  sqlite3_stmt* raw_stmt = nullptr;
+  int result_code = sqlite3_prepare_v2(db, sql.c_str(), -1, &raw_stmt, nullptr);
+  if (result_code != SQLITE_OK) {
+    spdlog::error("Failed to prepare statement: {}", sqlite3_errmsg(db));
+    sqlite3_finalize(raw_stmt);
+    return;
+  }
+  stmt_.reset(raw_stmt);
+}
+
+void DBStatement::Reset() {
+  sqlite3_reset(stmt_.get());
+  sqlite3_clear_bindings(stmt_.get());
+}
+
+}  // namespace duw
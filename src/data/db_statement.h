@@ -0,0 +1,33 @@
+#ifndef DB_STATEMENT_H
+#define DB_STATEMENT_H
+
+#include <memory>
+#include <string>
+
+struct sqlite3;
+struct sqlite3_stmt;
+
+namespace duw {
+
+class DBStatement {
+ public:
+  DBStatement(sqlite3* db, const std::string& sql);
+  ~DBStatement() = default;
+
+  DBStatement(const DBStatement&) = delete;
+  DBStatement& operator=(const DBStatement&) = delete;
+
+  DBStatement(DBStatement&& other) noexcept = default;
+  DBStatement& operator=(DBStatement&& other) noexcept = default;
+
+  sqlite3_stmt* Get() const { return stmt_.get(); }
+  bool IsValid() const { return stmt_ != nullptr; }
+  void Reset();
+
+ private:
+  std::unique_ptr<sqlite3_stmt, int(*)(sqlite3_stmt*)> stmt_;
+};
+
+}  // namespace duw
+
+#endif  // DB_STATEMENT_H
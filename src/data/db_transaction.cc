@@ -0,0 +1,50 @@
+#include "db_transaction.h"
+
+#include <spdlog/spdlog.h>
+#include <sqlite3.h>
+
+namespace duw {
+
+DBTransaction::DBTransaction(sqlite3* db) : db_(db) {
+  if (sqlite3_exec(db_, "BEGIN IMMEDIATE;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+    spdlog::error("Failed to begin transaction: {}", sqlite3_errmsg(db_));
+    return;
+  }
+  active_ = true;
+}
+
+DBTransaction::~DBTransaction() {
+  Rollback();
+}
+
+bool DBTransaction::Commit() {
+  if (!active_) {
+    return false;
+  }
+
+  if (sqlite3_exec(db_, "COMMIT;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+    spdlog::error("Failed to commit transaction: {}", sqlite3_errmsg(db_));
+    Rollback();
+    return false;
+  }
+
+  active_ = false;
+  return true;
+}
+
+void DBTransaction::Rollback() {
+  if (!active_) {
+    return;
+  }
+
+  active_ = false;
+  if (sqlite3_get_autocommit(db_) != 0) {
+    return;
+  }
+
+  if (sqlite3_exec(db_, "ROLLBACK;", nullptr, nullptr, nullptr) != SQLITE_OK) {
+    spdlog::error("Failed to roll back transaction: {}", sqlite3_errmsg(db_));
+  }
+}
+
+}  // namespace duw
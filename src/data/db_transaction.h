@@ -0,0 +1,27 @@
+#ifndef DB_TRANSACTION_H
+#define DB_TRANSACTION_H
+
+struct sqlite3;
+
+namespace duw {
+
+class DBTransaction {
+ public:
+  explicit DBTransaction(sqlite3* db);
+  ~DBTransaction();
+
+  DBTransaction(const DBTransaction&) = delete;
+  DBTransaction& operator=(const DBTransaction&) = delete;
+
+  bool IsActive() const { return active_; }
+  bool Commit();
+  void Rollback();
+
+ private:
+  sqlite3* db_;
+  bool active_ = false;
+};
+
+}  // namespace duw
+
+#endif  // DB_TRANSACTION_H
@@ -0,0 +1,88 @@
+#include "dimension_table.h"
+
+#include <spdlog/spdlog.h>
+#include <sqlite3.h>
+
+namespace duw {
+
+DimensionTable::DimensionTable(std::string table, std::string external_id_column)
+    : table_(std::move(table)), external_id_column_(std::move(external_id_column)) {}
+
+std::optional<std::int64_t> DimensionTable::Intern(sqlite3* db, const std::string& name,
+                                                   std::int64_t external_id) {
+  auto key = CacheKey(name, external_id);
+  if (auto it = ids_.find(key); it != ids_.end()) {
+    return it->second;
+  }
+
+  if (!PrepareStatements(db)) {
+    return std::nullopt;
+  }
+
+  std::optional<std::int64_t> id;
+  BindKey(*select_statement_, name, external_id);
+  if (sqlite3_step(select_statement_->Get()) == SQLITE_ROW) {
+    id = sqlite3_column_int64(select_statement_->Get(), 0);
+  }
+  select_statement_->Reset();
+
+  if (!id.has_value()) {
+    BindKey(*insert_statement_, name, external_id);
+    int result_code = sqlite3_step(insert_statement_->Get());
+    insert_statement_->Reset();
+    if (result_code != SQLITE_DONE) {
+      spdlog::error("Failed to insert into {}: {}", table_, sqlite3_errmsg(db));
+      return std::nullopt;
+    }
+    id = sqlite3_last_insert_rowid(db);
+  }
+
+  ids_.emplace(std::move(key), *id);
+  return id;
+}
+
+void DimensionTable::Clear() {
+  ids_.clear();
+  select_statement_.reset();
+  insert_statement_.reset();
+}
+
+bool DimensionTable::PrepareStatements(sqlite3* db) {
+  if (select_statement_ != nullptr && insert_statement_ != nullptr) {
+    return true;
+  }
+
+  std::string select_sql = "SELECT id FROM " + table_ + " WHERE name = ?1";
+  std::string insert_sql = "INSERT INTO " + table_ + " (name) VALUES (?1)";
+  if (!external_id_column_.empty()) {
+    select_sql += " AND " + external_id_column_ + " = ?2";
+    insert_sql = "INSERT INTO " + table_ + " (name, " + external_id_column_ + ") VALUES (?1, ?2)";
+  }
+
+  auto select_stmt = std::make_unique<DBStatement>(db, select_sql + ";");
+  auto insert_stmt = std::make_unique<DBStatement>(db, insert_sql + ";");
+  if (!select_stmt->IsValid() || !insert_stmt->IsValid()) {
+    return false;
+  }
+
+  select_statement_ = std::move(select_stmt);
+  insert_statement_ = std::move(insert_stmt);
+  return true;
+}
+
+void DimensionTable::BindKey(DBStatement& stmt, const std::string& name,
+                             std::int64_t external_id) const {
+  sqlite3_bind_text(stmt.Get(), 1, name.c_str(), -1, SQLITE_STATIC);
+  if (!external_id_column_.empty()) {
+    sqlite3_bind_int64(stmt.Get(), 2, external_id);
+  }
+}
+
+std::string DimensionTable::CacheKey(const std::string& name, std::int64_t external_id) const {
+  if (external_id_column_.empty()) {
+    return name;
+  }
+  return std::to_string(external_id) + '\x1f' + name;
+}
+
+}  // namespace duw
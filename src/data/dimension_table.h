@@ -0,0 +1,42 @@
+#ifndef DIMENSION_TABLE_H
+#define DIMENSION_TABLE_H
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+#include "db_statement.h"
+
+struct sqlite3;
+
+namespace duw {
+
+class DimensionTable {
+ public:
+  explicit DimensionTable(std::string table, std::string external_id_column = "");
+  ~DimensionTable() = default;
+
+  DimensionTable(const DimensionTable&) = delete;
+  DimensionTable& operator=(const DimensionTable&) = delete;
+
+  std::optional<std::int64_t> Intern(sqlite3* db, const std::string& name,
+                                     std::int64_t external_id = 0);
+  void Clear();
+
+ private:
+  std::string table_;
+  std::string external_id_column_;
+  std::unordered_map<std::string, std::int64_t> ids_;
+  std::unique_ptr<DBStatement> select_statement_;
+  std::unique_ptr<DBStatement> insert_statement_;
+
+  bool PrepareStatements(sqlite3* db);
+  void BindKey(DBStatement& stmt, const std::string& name, std::int64_t external_id) const;
+  std::string CacheKey(const std::string& name, std::int64_t external_id) const;
+};
+
+}  // namespace duw
+
+#endif  // DIMENSION_TABLE_H
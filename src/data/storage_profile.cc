@@ -0,0 +1,52 @@
+#include "storage_profile.h"
+
+#include <array>
+
+namespace duw {
+
+namespace {
+
+constexpr std::int64_t BYTES_PER_MIB = 1024 * 1024;
+
+const std::array<StorageProfile, 3>& StorageProfiles() {
+  static const std::array<StorageProfile, 3> profiles = {{
+      {.name = "durable",
+       .journal_mode = "WAL",
+       .synchronous = "FULL",
+       .mmap_size_bytes = 0,
+       .cache_size_kib = 2048,
+       .temp_store = "DEFAULT",
+       .busy_timeout_ms = 5000,
+       .wal_autocheckpoint_pages = 1000},
+      {.name = "balanced",
+       .journal_mode = "WAL",
+       .synchronous = "NORMAL",
+       .mmap_size_bytes = 64 * BYTES_PER_MIB,
+       .cache_size_kib = 8192,
+       .temp_store = "MEMORY",
+       .busy_timeout_ms = 5000,
+       .wal_autocheckpoint_pages = 4000},
+      {.name = "throughput",
+       .journal_mode = "WAL",
+       .synchronous = "OFF",
+       .mmap_size_bytes = 256 * BYTES_PER_MIB,
+       .cache_size_kib = 32768,
+       .temp_store = "MEMORY",
+       .busy_timeout_ms = 5000,
+       .wal_autocheckpoint_pages = 10000},
+  }};
+  return profiles;
+}
+
+}  // anonymous namespace
+
+std::optional<StorageProfile> FindStorageProfile(const std::string& name) {
+  for (const auto& profile : StorageProfiles()) {
+    if (profile.name == name) {
+      return profile;
+    }
+  }
+  return std::nullopt;
+}
+
+}  // namespace duw
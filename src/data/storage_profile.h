@@ -0,0 +1,25 @@
+#ifndef STORAGE_PROFILE_H
+#define STORAGE_PROFILE_H
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace duw {
+
+struct StorageProfile {
+  std::string name;
+  std::string journal_mode;
+  std::string synchronous;
+  std::int64_t mmap_size_bytes;
+  int cache_size_kib;
+  std::string temp_store;
+  int busy_timeout_ms;
+  int wal_autocheckpoint_pages;
+};
+
+std::optional<StorageProfile> FindStorageProfile(const std::string& name);
+
+}  // namespace duw
+
+#endif  // STORAGE_PROFILE_H
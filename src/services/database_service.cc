@@ -1,49 +1,511 @@
 #include "database_service.h"
 
+#include <algorithm>
+#include <chrono>
 #include <cstdint>
 #include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <numeric>
+#include <ranges>
 
 #include <spdlog/spdlog.h>
 #include <sqlite3.h>
 
 #include "../data/db_connection.h"
+#include "../data/db_transaction.h"
+#include "../util/file_sync.h"
+#include "../util/gzip.h"
+#include "../util/metrics.h"
 
 namespace duw {
 
 enum class BindIndex : std::uint8_t {
-  BIND_CITY = 1,
-  BIND_QUEUE_STATUS = 2,
-  BIND_QUEUE_LENGTH = 3,
-  BIND_TIMESTAMP = 4,
-  BIND_SERVICE_NAME = 5,
-  BIND_SERVICE_ID = 6,
-  BIND_OPERATIONS_COUNT = 7,
-  BIND_ENABLED_OPERATIONS = 8
+  BIND_CITY_ID = 1,
+  BIND_TIMESTAMP = 2,
+  BIND_SERVICE_REF = 3,
+  BIND_STATUS_ID = 4,
+  BIND_QUEUE_LENGTH = 5,
+  BIND_OPERATIONS_COUNT = 6,
+  BIND_ENABLED_OPERATIONS = 7,
+  BIND_VALID_TO = 8
 };
 
 enum class ColumnIndex : std::uint8_t {
-  COL_ID = 0,
-  COL_CITY = 1,
-  COL_QUEUE_STATUS = 2,
-  COL_QUEUE_LENGTH = 3,
-  COL_TIMESTAMP = 4,
-  COL_SERVICE_NAME = 5,
-  COL_SERVICE_ID = 6,
-  COL_OPERATIONS_COUNT = 7,
-  COL_ENABLED_OPERATIONS = 8
+  COL_CITY = 0,
+  COL_QUEUE_STATUS = 1,
+  COL_QUEUE_LENGTH = 2,
+  COL_TIMESTAMP = 3,
+  COL_SERVICE_NAME = 4,
+  COL_SERVICE_ID = 5,
+  COL_OPERATIONS_COUNT = 6,
+  COL_ENABLED_OPERATIONS = 7,
+  COL_VALID_TO = 8,
+  COL_CHANGE_SEQUENCE = 9
 };
 
-DatabaseService::DatabaseService() = default;
+namespace {
+
+constexpr const char* PARTITION_PREFIX = "queue_samples_p";
+constexpr const char* ARCHIVED_BEFORE_KEY = "archived_before_month";
+constexpr const char* ARCHIVED_MONTH_ERROR = "the partition of this month was archived";
+constexpr const char* CHANGE_SET_SEQUENCE_KEY = "change_set_sequence";
+constexpr int AUTO_VACUUM_INCREMENTAL = 2;
+constexpr int SCHEMA_VERSION_UNVERSIONED = 0;
+constexpr int SCHEMA_VERSION_LEGACY_ROWS_PENDING = 1;
+constexpr int SCHEMA_VERSION_WITHOUT_CHANGE_LOG = 2;
+constexpr int SCHEMA_VERSION_COUNTED_ROLLUPS = 3;
+constexpr int SCHEMA_VERSION_DECIMAL_VIEW_IDS = 4;
+constexpr int SCHEMA_VERSION = 5;
+constexpr int CITY_ID_BITS = 20;
+constexpr const char* SAMPLE_COLUMNS =
+    "city_id, ts, valid_to, service_ref, status_id, queue_length, operations_count, "
+    "enabled_operations";
+
+constexpr const char* CHANGE_LOG_SCHEMA_SQL = R"(
+  CREATE TABLE IF NOT EXISTS sample_changes (
+    seq INTEGER PRIMARY KEY AUTOINCREMENT,
+    city_id INTEGER NOT NULL,
+    ts INTEGER NOT NULL,
+    UNIQUE (city_id, ts)
+  );
+)";
+
+constexpr const char* REJECTED_SAMPLES_SCHEMA_SQL = R"(
+  CREATE TABLE IF NOT EXISTS rejected_samples (
+    id INTEGER PRIMARY KEY,
+    change_set_sequence INTEGER NOT NULL,
+    city TEXT,
+    queue_status TEXT,
+    queue_length INTEGER,
+    ts INTEGER,
+    service_name TEXT,
+    service_id INTEGER,
+    operations_count INTEGER,
+    enabled_operations INTEGER,
+    error TEXT NOT NULL,
+    rejected_at INTEGER NOT NULL
+  );
+)";
+
+constexpr const char* REJECT_SAMPLE_SQL = R"(
+  INSERT INTO rejected_samples (change_set_sequence, city, queue_status, queue_length, ts,
+                                service_name, service_id, operations_count, enabled_operations,
+                                error, rejected_at)
+  VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8, ?9, ?10, CAST(strftime('%s', 'now') AS INTEGER) * 1000);
+)";
+
+constexpr const char* CLOSE_LEGACY_INTERVAL_SQL = R"(
+  UPDATE ticket_info_v1
+  SET valid_to = strftime('%Y-%m-%d %H:%M:%S', ?2 / 1000, 'unixepoch', 'localtime')
+  WHERE city = ?1 AND valid_to IS NULL
+    AND id = (SELECT MAX(id) FROM ticket_info_v1 WHERE city = ?1);
+)";
+
+constexpr const char* LEGACY_INTERVAL_END_SQL = R"(
+  COALESCE(t.valid_to, (
+    SELECT n.timestamp FROM ticket_info_v1 n
+    WHERE n.city = t.city AND n.id > t.id
+    ORDER BY n.id LIMIT 1))
+)";
+
+struct LegacyColumn {
+  const char* name;
+  const char* definition;
+};
+
+constexpr LegacyColumn LEGACY_COLUMNS[] = {
+    {"service_name", "TEXT DEFAULT 'legacy_service'"},
+    {"service_id", "INTEGER DEFAULT 0"},
+    {"operations_count", "INTEGER DEFAULT 0"},
+    {"enabled_operations", "INTEGER DEFAULT 0"},
+    {"valid_to", "TEXT"}};
+
+std::string InsertSampleSql(const std::string& table) {
+  return "INSERT INTO " + table + R"( (city_id, ts, service_ref, status_id, queue_length, operations_count, enabled_operations)
+    VALUES (?, ?, ?, ?, ?, ?, ?);
+  )";
+}
+
+std::string ApplySampleSql(const std::string& table) {
+  return "INSERT INTO " + table + R"(
+      (city_id, ts, service_ref, status_id, queue_length, operations_count, enabled_operations, valid_to)
+    VALUES (?, ?, ?, ?, ?, ?, ?, ?)
+    ON CONFLICT (city_id, ts) DO UPDATE SET
+      valid_to = excluded.valid_to,
+      service_ref = excluded.service_ref,
+      status_id = excluded.status_id,
+      queue_length = excluded.queue_length,
+      operations_count = excluded.operations_count,
+      enabled_operations = excluded.enabled_operations;
+  )";
+}
+
+std::string LatestSampleBeforeSql(const std::string& table) {
+  return "SELECT MAX(ts) FROM " + table + " WHERE city_id = ?1 AND ts < ?2;";
+}
+
+std::string CloseIntervalSql(const std::string& table) {
+  return "UPDATE " + table +
+         " SET valid_to = ?3 WHERE city_id = ?1 AND ts = ?2 AND valid_to IS NULL;";
+}
+
+int MonthKey(std::int64_t timestamp_ms) {
+  std::chrono::year_month_day date(std::chrono::floor<std::chrono::days>(
+      std::chrono::sys_time<std::chrono::milliseconds>(std::chrono::milliseconds(timestamp_ms))));
+  return static_cast<int>(date.year()) * 100 +
+         static_cast<int>(static_cast<unsigned>(date.month()));
+}
+
+int AddMonths(int month, int delta) {
+  auto year_month = std::chrono::year(month / 100) / std::chrono::month(month % 100) +
+                    std::chrono::months(delta);
+  return static_cast<int>(year_month.year()) * 100 +
+         static_cast<int>(static_cast<unsigned>(year_month.month()));
+}
+
+std::int64_t MonthStartMs(int month) {
+  std::chrono::sys_days start = std::chrono::year(month / 100) / std::chrono::month(month % 100) /
+                                std::chrono::day(1);
+  return std::chrono::duration_cast<std::chrono::milliseconds>(start.time_since_epoch()).count();
+}
+
+int CurrentMonth() {
+  return MonthKey(std::chrono::duration_cast<std::chrono::milliseconds>(
+                      std::chrono::system_clock::now().time_since_epoch())
+                      .count());
+}
+
+std::string PartitionTable(int month) {
+  return PARTITION_PREFIX + std::to_string(month);
+}
+
+struct RollupResolution {
+  const char* name;
+  std::int64_t width_ms;
+};
+
+constexpr RollupResolution ROLLUP_RESOLUTIONS[] = {
+    {"minute", 60LL * 1000}, {"hour", 60LL * 60 * 1000}, {"day", 24LL * 60 * 60 * 1000}};
+
+constexpr const char* ROLLUP_COLUMNS =
+    "city_id, bucket_start, change_count, covered_ms, queue_length_min, queue_length_max, "
+    "queue_length_weighted_sum, enabled_operations_min, enabled_operations_max, "
+    "enabled_operations_weighted_sum";
+
+std::string RollupTable(const RollupResolution& resolution) {
+  return std::string("queue_rollup_") + resolution.name;
+}
+
+std::string RollupBucket(const std::string& ts, const RollupResolution& resolution) {
+  return "(" + ts + " - " + ts + " % " + std::to_string(resolution.width_ms) + ")";
+}
+
+std::string IntervalBucketsSql(const RollupResolution& resolution, const std::string& intervals,
+                               const std::string& first_bucket) {
+  std::string next_bucket = "bucket_start + " + std::to_string(resolution.width_ms);
+  return R"(
+    WITH RECURSIVE interval_buckets
+        (city_id, bucket_start, ts, end_ts, queue_length, enabled_operations) AS (
+      SELECT city_id, )" + first_bucket + R"(, ts, end_ts, queue_length, enabled_operations
+      FROM ()" + intervals + R"() WHERE end_ts > ts
+      UNION ALL
+      SELECT city_id, )" + next_bucket + R"(, ts, end_ts, queue_length, enabled_operations
+      FROM interval_buckets WHERE )" + next_bucket + R"( < end_ts
+    )
+    SELECT city_id, bucket_start, ts >= bucket_start AS change_count,
+           MIN(end_ts, )" + next_bucket + R"() - MAX(ts, bucket_start) AS covered_ms,
+           queue_length, enabled_operations
+    FROM interval_buckets
+  )";
+}
+
+std::string ClosedIntervalsSql(const std::string& where) {
+  return "SELECT city_id, ts, valid_to AS end_ts, queue_length, enabled_operations "
+         "FROM queue_samples WHERE valid_to IS NOT NULL AND " + where;
+}
+
+std::string RollupMergeSql(const RollupResolution& resolution, const std::string& buckets,
+                           const std::string& where) {
+  return "INSERT INTO " + RollupTable(resolution) + " (" + ROLLUP_COLUMNS + R"()
+    SELECT city_id, bucket_start, SUM(change_count), SUM(covered_ms),
+           MIN(queue_length), MAX(queue_length), SUM(queue_length * covered_ms),
+           MIN(enabled_operations), MAX(enabled_operations), SUM(enabled_operations * covered_ms)
+    FROM ()" + buckets + ") WHERE " + where + R"( GROUP BY city_id, bucket_start
+    ON CONFLICT (city_id, bucket_start) DO UPDATE SET
+      change_count = change_count + excluded.change_count,
+      covered_ms = covered_ms + excluded.covered_ms,
+      queue_length_min = MIN(queue_length_min, excluded.queue_length_min),
+      queue_length_max = MAX(queue_length_max, excluded.queue_length_max),
+      queue_length_weighted_sum = queue_length_weighted_sum + excluded.queue_length_weighted_sum,
+      enabled_operations_min = MIN(enabled_operations_min, excluded.enabled_operations_min),
+      enabled_operations_max = MAX(enabled_operations_max, excluded.enabled_operations_max),
+      enabled_operations_weighted_sum =
+          enabled_operations_weighted_sum + excluded.enabled_operations_weighted_sum;
+  )";
+}
+
+std::string RollupSchemaSql() {
+  std::string sql;
+  for (const auto& resolution : ROLLUP_RESOLUTIONS) {
+    std::string table = RollupTable(resolution);
+    sql += "CREATE TABLE IF NOT EXISTS " + table + R"( (
+      city_id INTEGER NOT NULL REFERENCES cities(id),
+      bucket_start INTEGER NOT NULL,
+      change_count INTEGER NOT NULL,
+      covered_ms INTEGER NOT NULL,
+      queue_length_min INTEGER NOT NULL,
+      queue_length_max INTEGER NOT NULL,
+      queue_length_weighted_sum INTEGER NOT NULL,
+      queue_length_avg REAL GENERATED ALWAYS AS
+          (CAST(queue_length_weighted_sum AS REAL) / covered_ms),
+      enabled_operations_min INTEGER NOT NULL,
+      enabled_operations_max INTEGER NOT NULL,
+      enabled_operations_weighted_sum INTEGER NOT NULL,
+      enabled_operations_avg REAL GENERATED ALWAYS AS
+          (CAST(enabled_operations_weighted_sum AS REAL) / covered_ms),
+      PRIMARY KEY (city_id, bucket_start)
+    ) WITHOUT ROWID;
+    CREATE INDEX IF NOT EXISTS idx_)" + table + "_bucket ON " + table + "(bucket_start);\n";
+  }
+  return sql;
+}
+
+std::string MonthFilter(const std::string& ts, int month) {
+  return ts + " >= " + std::to_string(MonthStartMs(month)) + " AND " + ts + " < " +
+         std::to_string(MonthStartMs(AddMonths(month, 1)));
+}
+
+std::string SampleTableSql(const std::string& table) {
+  return "CREATE TABLE IF NOT EXISTS " + table + R"( (
+      city_id INTEGER NOT NULL REFERENCES cities(id),
+      ts INTEGER NOT NULL,
+      valid_to INTEGER,
+      service_ref INTEGER NOT NULL REFERENCES services(id),
+      status_id INTEGER NOT NULL REFERENCES queue_statuses(id),
+      queue_length INTEGER NOT NULL,
+      operations_count INTEGER NOT NULL DEFAULT 0,
+      enabled_operations INTEGER NOT NULL DEFAULT 0,
+      PRIMARY KEY (city_id, ts)
+    ) WITHOUT ROWID;
+  )";
+}
+
+std::string PartitionSchemaSql(const std::string& table) {
+  return SampleTableSql(table) + "CREATE INDEX IF NOT EXISTS idx_" + table + "_open ON " +
+         table + "(city_id) WHERE valid_to IS NULL;\n";
+}
+
+std::string ChangeLogTriggerSql(const std::string& table) {
+  std::string log_change = R"(
+    BEGIN
+      DELETE FROM sample_changes WHERE city_id = NEW.city_id AND ts = NEW.ts;
+      INSERT INTO sample_changes (city_id, ts) VALUES (NEW.city_id, NEW.ts);
+    END;
+  )";
+  return "CREATE TRIGGER IF NOT EXISTS " + table + "_change_insert AFTER INSERT ON " + table +
+         log_change + "CREATE TRIGGER IF NOT EXISTS " + table + "_change_update AFTER UPDATE ON " +
+         table + log_change;
+}
+
+std::string RollupTriggerSql(const std::string& table) {
+  std::string new_interval = "SELECT NEW.city_id AS city_id, NEW.ts AS ts, NEW.valid_to AS end_ts, "
+                             "NEW.queue_length AS queue_length, "
+                             "NEW.enabled_operations AS enabled_operations";
+  std::string changed_end = "MAX(OLD.valid_to, COALESCE(NEW.valid_to, OLD.valid_to))";
+  std::string add_interval;
+  std::string recompute_buckets;
+  for (const auto& resolution : ROLLUP_RESOLUTIONS) {
+    std::string changed_start = RollupBucket("NEW.ts", resolution);
+    add_interval += RollupMergeSql(
+        resolution, IntervalBucketsSql(resolution, new_interval, RollupBucket("ts", resolution)),
+        "covered_ms > 0");
+    std::string changed_intervals = ClosedIntervalsSql(
+        "city_id = NEW.city_id AND ts < " + changed_end + " AND valid_to > " + changed_start);
+    std::string changed_buckets = IntervalBucketsSql(
+        resolution, changed_intervals, RollupBucket("MAX(ts, " + changed_start + ")", resolution));
+    recompute_buckets += "DELETE FROM " + RollupTable(resolution) +
+                         " WHERE city_id = NEW.city_id AND bucket_start >= " + changed_start +
+                         " AND bucket_start < " + changed_end + ";\n" +
+                         RollupMergeSql(resolution, changed_buckets,
+                                        "covered_ms > 0 AND bucket_start < " + changed_end);
+  }
+
+  std::string insert_trigger = "CREATE TRIGGER IF NOT EXISTS " + table +
+                               "_rollup_insert AFTER INSERT ON " + table +
+                               " WHEN NEW.valid_to IS NOT NULL\nBEGIN\n";
+  std::string close_trigger = "CREATE TRIGGER IF NOT EXISTS " + table +
+                              "_rollup_close AFTER UPDATE OF valid_to ON " + table +
+                              " WHEN OLD.valid_to IS NULL AND NEW.valid_to IS NOT NULL\nBEGIN\n";
+  std::string update_trigger = "CREATE TRIGGER IF NOT EXISTS " + table +
+                               "_rollup_update AFTER UPDATE OF valid_to, queue_length, "
+                               "enabled_operations ON " + table + R"(
+    WHEN OLD.valid_to IS NOT NULL AND (NEW.valid_to IS NOT OLD.valid_to OR
+      OLD.queue_length != NEW.queue_length OR OLD.enabled_operations != NEW.enabled_operations)
+    BEGIN
+  )";
+  return insert_trigger + add_interval + "END;\n" + close_trigger + add_interval + "END;\n" +
+         update_trigger + recompute_buckets + "END;\n";
+}
+
+std::string PartitionTriggerSql(const std::string& table) {
+  return RollupTriggerSql(table) + ChangeLogTriggerSql(table);
+}
+
+Histogram& SaveDuration() {
+  static Histogram& histogram = MetricsRegistry::Get().GetHistogram(
+      "duw_db_save_duration_seconds", "Time to save one batch of samples");
+  return histogram;
+}
+
+Counter& SavedRows() {
+  static Counter& counter = MetricsRegistry::Get().GetCounter(
+      "duw_db_saved_rows_total", "Samples written to queue_samples");
+  return counter;
+}
+
+Counter& FailedRows() {
+  static Counter& counter = MetricsRegistry::Get().GetCounter(
+      "duw_db_failed_rows_total", "Samples that could not be written");
+  return counter;
+}
+
+Gauge& MigrationRemainingRows() {
+  static Gauge& gauge = MetricsRegistry::Get().GetGauge(
+      "duw_db_migration_remaining_rows", "Legacy rows still waiting to be moved to queue_samples");
+  return gauge;
+}
+
+std::string SchemaVersionSql(int version) {
+  return "PRAGMA user_version = " + std::to_string(version) + ";";
+}
+
+bool IsRowLevelError(int result_code) {
+  int primary_code = result_code & 0xFF;
+  return primary_code == SQLITE_CONSTRAINT || primary_code == SQLITE_MISMATCH ||
+         primary_code == SQLITE_TOOBIG || primary_code == SQLITE_RANGE;
+}
+
+BatchSaveResult FailedBatch(std::size_t row_count) {
+  FailedRows().Increment(row_count);
+  BatchSaveResult result;
+  result.failed_rows.resize(row_count);
+  std::iota(result.failed_rows.begin(), result.failed_rows.end(), 0);
+  return result;
+}
+
+std::string LegacyTimestampMs(const std::string& column) {
+  return "(CAST(strftime('%s', " + column + ", 'utc') AS INTEGER) * 1000)";
+}
+
+std::string LocalTimeText(const std::string& column) {
+  return "strftime('%Y-%m-%d %H:%M:%S', " + column + " / 1000, 'unixepoch', 'localtime')";
+}
+
+std::string CityIdLimitSql() {
+  return "CREATE TRIGGER IF NOT EXISTS cities_id_limit AFTER INSERT ON cities WHEN NEW.id >= " +
+         std::to_string(1 << CITY_ID_BITS) +
+         " BEGIN SELECT RAISE(ABORT, 'city id exceeds the ticket_info id range'); END;\n";
+}
+
+std::string CompatibilityViewSql(bool include_legacy_rows) {
+  std::string sql = R"(
+    CREATE VIEW ticket_info AS
+    SELECT
+      (s.ts << )" + std::to_string(CITY_ID_BITS) + R"() | s.city_id AS id,
+      c.name AS city,
+      st.name AS queue_status,
+      s.queue_length AS queue_length,
+      )" + LocalTimeText("s.ts") + R"( AS timestamp,
+      sv.name AS service_name,
+      sv.duw_id AS service_id,
+      s.operations_count AS operations_count,
+      s.enabled_operations AS enabled_operations,
+      datetime(s.ts / 1000, 'unixepoch') AS created_at,
+      )" + LocalTimeText("s.valid_to") + R"( AS valid_to
+    FROM queue_samples s
+    JOIN cities c ON c.id = s.city_id
+    JOIN services sv ON sv.id = s.service_ref
+    JOIN queue_statuses st ON st.id = s.status_id
+  )";
+
+  if (include_legacy_rows) {
+    sql += R"(
+      UNION ALL
+      SELECT id, city, queue_status, queue_length, timestamp, service_name, service_id,
+             operations_count, enabled_operations, created_at, )" +
+           std::string(LEGACY_INTERVAL_END_SQL) + R"( AS valid_to
+      FROM ticket_info_v1 t
+    )";
+  }
+
+  return sql + ";";
+}
+
+}  // anonymous namespace
+
+std::optional<std::string> RollupHistorySql(const std::string& resolution_name) {
+  const auto* resolution = std::ranges::find(ROLLUP_RESOLUTIONS, resolution_name,
+                                             &RollupResolution::name);
+  if (resolution == std::ranges::end(ROLLUP_RESOLUTIONS)) {
+    return std::nullopt;
+  }
+
+  std::string open_end = "MIN(CAST(strftime('%s', 'now') AS INTEGER) * 1000, ?3 + " +
+                         std::to_string(resolution->width_ms) + ")";
+  std::string open_intervals = "SELECT city_id, ts, " + open_end +
+                               " AS end_ts, queue_length, enabled_operations FROM queue_samples "
+                               "WHERE valid_to IS NULL AND city_id = (SELECT id FROM city)";
+  std::string open_buckets =
+      IntervalBucketsSql(*resolution, open_intervals, RollupBucket("MAX(ts, ?2)", *resolution));
+  return R"(
+    WITH city AS (SELECT id FROM cities WHERE name = ?1)
+    SELECT bucket_start, SUM(change_count), SUM(covered_ms), MIN(queue_length_min),
+           MAX(queue_length_max), CAST(SUM(queue_length_weighted_sum) AS REAL) / SUM(covered_ms),
+           MIN(enabled_operations_min), MAX(enabled_operations_max),
+           CAST(SUM(enabled_operations_weighted_sum) AS REAL) / SUM(covered_ms)
+    FROM (
+      SELECT )" + std::string(ROLLUP_COLUMNS) + " FROM " + RollupTable(*resolution) + R"(
+      WHERE city_id = (SELECT id FROM city) AND bucket_start >= ?2 AND bucket_start < ?3
+      UNION ALL
+      SELECT city_id, bucket_start, change_count, covered_ms, queue_length, queue_length,
+             queue_length * covered_ms, enabled_operations, enabled_operations,
+             enabled_operations * covered_ms
+      FROM ()" + open_buckets + R"()
+      WHERE covered_ms > 0 AND bucket_start >= ?2 AND bucket_start < ?3
+    )
+    GROUP BY bucket_start
+    ORDER BY bucket_start
+    LIMIT ?4;
+  )";
+}
+
+DatabaseService::DatabaseService()
+    : cities_("cities"), services_("services", "duw_id"), statuses_("queue_statuses") {}
 
 bool DatabaseService::Initialize(const std::string& db_path) {
+  ResetCachedStatements();
   connection_ = std::make_unique<DBConnection>(db_path);
-  
-  if (!connection_->IsValid()) {
-    return false;
-  }
+  return PrepareSchema();
+}
+
+bool DatabaseService::Initialize(const std::string& db_path, const StorageProfile& profile) {
+  ResetCachedStatements();
+  connection_ = std::make_unique<DBConnection>(db_path, profile);
+  return PrepareSchema();
+}
+
+bool DatabaseService::CheckpointWal(CheckpointMode mode) {
+  return connection_ != nullptr && connection_->IsValid() && connection_->CheckpointWal(mode);
+}
+
+bool DatabaseService::FlushToDisk() {
+  return connection_ != nullptr && connection_->IsValid() && connection_->FlushToDisk();
+}
 
-  if (!CreateTables()) {
-    spdlog::error("Failed to create database tables");
+bool DatabaseService::PrepareSchema() {
+  if (!connection_->IsValid()) {
     return false;
   }
 
@@ -56,69 +518,834 @@ bool DatabaseService::Initialize(const std::string& db_path) {
 }
 
 bool DatabaseService::SaveTicketInfo(const TicketInfo& ticket) {
+  return SaveTicketInfoBatch(std::span<const TicketInfo>(&ticket, 1)).saved_count == 1;
+}
+
+BatchSaveResult DatabaseService::SaveTicketInfoBatch(std::span<const TicketInfo> tickets) {
+  BatchSaveResult result;
+  if (tickets.empty()) {
+    result.committed = true;
+    return result;
+  }
+
+  ScopedTimer timer(SaveDuration());
+  DBTransaction transaction(connection_->Get());
+  if (!transaction.IsActive() || !SaveTicketRows(tickets, 0, result)) {
+    transaction.Rollback();
+    ResetAfterRollback();
+    return FailedBatch(tickets.size());
+  }
+  return CommitBatch(transaction, std::move(result), tickets.size());
+}
+
+BatchSaveResult DatabaseService::SaveChangeSets(std::span<const TicketChangeSet> change_sets) {
+  std::size_t row_count = 0;
+  for (const auto& change_set : change_sets) {
+    row_count += change_set.changed.size();
+  }
+
+  BatchSaveResult result;
+  if (change_sets.empty()) {
+    result.committed = true;
+    return result;
+  }
+
+  ScopedTimer timer(SaveDuration());
+  DBTransaction transaction(connection_->Get());
+  bool saved = transaction.IsActive();
+  for (std::size_t i = 0; saved && i < change_sets.size(); ++i) {
+    std::size_t first_row = result.saved_count + result.failed_rows.size();
+    saved = SaveTicketRows(change_sets[i].changed, first_row, result,
+                           change_sets[i].sequence) &&
+            CloseOpenIntervals(change_sets[i].vanished, change_sets[i].timestamp_ms);
+  }
+
+  if (!saved || !SaveSyncValue(CHANGE_SET_SEQUENCE_KEY,
+                               std::to_string(change_sets.back().sequence))) {
+    transaction.Rollback();
+    ResetAfterRollback();
+    return FailedBatch(row_count);
+  }
+  return CommitBatch(transaction, std::move(result), row_count);
+}
+
+std::uint64_t DatabaseService::LoadChangeSetSequence() {
+  return std::strtoull(LoadSyncValue(CHANGE_SET_SEQUENCE_KEY).value_or("0").c_str(), nullptr, 10);
+}
+
+bool DatabaseService::SaveTicketRows(std::span<const TicketInfo> tickets, std::size_t first_row,
+                                     BatchSaveResult& result,
+                                     std::optional<std::uint64_t> reject_sequence) {
+  for (std::size_t row = 0; row < tickets.size(); ++row) {
+    bool archived = IsArchivedMonth(tickets[row].timestamp_ms);
+    int result_code = archived ? SQLITE_CONSTRAINT : SaveTicketRow(tickets[row]);
+    if (result_code == SQLITE_DONE) {
+      result.saved_count++;
+      continue;
+    }
+
+    std::string error = archived ? ARCHIVED_MONTH_ERROR : sqlite3_errmsg(connection_->Get());
+    spdlog::error("Failed to insert ticket for city {}: {}", tickets[row].city, error);
+    result.failed_rows.push_back(first_row + row);
+    if (!IsRowLevelError(result_code) ||
+        (reject_sequence.has_value() && !RejectTicketRow(*reject_sequence, tickets[row], error))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool DatabaseService::RejectTicketRow(std::uint64_t sequence, const TicketInfo& ticket,
+                                      const std::string& error) {
+  if (reject_sample_statement_ == nullptr && !ExecuteQuery(REJECTED_SAMPLES_SCHEMA_SQL)) {
+    return false;
+  }
+  DBStatement* stmt = GetCachedStatement(reject_sample_statement_, REJECT_SAMPLE_SQL);
+  if (stmt == nullptr) {
+    return false;
+  }
+
+  sqlite3_stmt* raw_stmt = stmt->Get();
+  sqlite3_bind_int64(raw_stmt, 1, static_cast<sqlite3_int64>(sequence));
+  sqlite3_bind_text(raw_stmt, 2, ticket.city.c_str(), -1, SQLITE_STATIC);
+  sqlite3_bind_text(raw_stmt, 3, ticket.queue_status.c_str(), -1, SQLITE_STATIC);
+  sqlite3_bind_int(raw_stmt, 4, ticket.queue_length);
+  sqlite3_bind_int64(raw_stmt, 5, ticket.timestamp_ms);
+  sqlite3_bind_text(raw_stmt, 6, ticket.service_name.c_str(), -1, SQLITE_STATIC);
+  sqlite3_bind_int(raw_stmt, 7, ticket.service_id);
+  sqlite3_bind_int(raw_stmt, 8, ticket.operations_count);
+  sqlite3_bind_int(raw_stmt, 9, ticket.enabled_operations);
+  sqlite3_bind_text(raw_stmt, 10, error.c_str(), -1, SQLITE_STATIC);
+  int result_code = sqlite3_step(raw_stmt);
+  stmt->Reset();
+  if (result_code != SQLITE_DONE) {
+    spdlog::error("Failed to keep rejected ticket for city {}: {}", ticket.city,
+                  sqlite3_errmsg(connection_->Get()));
+    return false;
+  }
+  return true;
+}
+
+BatchSaveResult DatabaseService::CommitBatch(DBTransaction& transaction, BatchSaveResult result,
+                                             std::size_t row_count) {
+  if (!transaction.Commit()) {
+    ResetAfterRollback();
+    return FailedBatch(row_count);
+  }
+
+  SavedRows().Increment(result.saved_count);
+  FailedRows().Increment(result.failed_rows.size());
+  result.committed = true;
+  return result;
+}
+
+bool DatabaseService::CloseOpenIntervals(std::span<const std::string> cities,
+                                         std::int64_t timestamp_ms) {
+  for (const auto& city : cities) {
+    if (CloseOpenInterval(city, timestamp_ms) != SQLITE_DONE) {
+      spdlog::error("Failed to close interval for city {}: {}", city,
+                    sqlite3_errmsg(connection_->Get()));
+      return false;
+    }
+  }
+  return true;
+}
+
+int DatabaseService::SaveTicketRow(const TicketInfo& ticket) {
+  int month = WritePartition(ticket.timestamp_ms);
+  DBStatement* insert_stmt =
+      month != 0 ? PartitionStatement(month, &PartitionStatements::insert, InsertSampleSql)
+                 : nullptr;
+  if (insert_stmt == nullptr) {
+    return SQLITE_ERROR;
+  }
+
+  int result_code = InsertSample(insert_stmt, ticket);
+  return result_code == SQLITE_DONE ? CloseOpenInterval(ticket.city, ticket.timestamp_ms)
+                                    : result_code;
+}
+
+bool DatabaseService::CloseTicketIntervals(std::span<const std::string> cities,
+                                           std::int64_t timestamp_ms) {
+  if (cities.empty()) {
+    return true;
+  }
+
+  DBTransaction transaction(connection_->Get());
+  if (!transaction.IsActive()) {
+    return false;
+  }
+
+  if (!CloseOpenIntervals(cities, timestamp_ms)) {
+    transaction.Rollback();
+    ResetAfterRollback();
+    return false;
+  }
+
+  if (!transaction.Commit()) {
+    ResetAfterRollback();
+    return false;
+  }
+  return true;
+}
+
+std::vector<TicketInfo> DatabaseService::LoadOpenTickets() {
+  std::vector<TicketInfo> tickets;
+
+  if (legacy_rows_pending_) {
+    std::string legacy_sql = R"(
+      SELECT city, queue_status, queue_length, )" + LegacyTimestampMs("timestamp") + R"(,
+             COALESCE(service_name, ''), COALESCE(service_id, 0),
+             COALESCE(operations_count, 0), COALESCE(enabled_operations, 0)
+      FROM ticket_info_v1 t
+      WHERE valid_to IS NULL AND id = (SELECT MAX(id) FROM ticket_info_v1 WHERE city = t.city);
+    )";
+    ReadTickets(legacy_sql, tickets);
+  }
+
   const char* sql = R"(
-    INSERT INTO ticket_info (city, queue_status, queue_length, timestamp, service_name, service_id, operations_count, enabled_operations)
-    VALUES (?, ?, ?, ?, ?, ?, ?, ?);
+    SELECT c.name, st.name, s.queue_length, s.ts, sv.name, sv.duw_id, s.operations_count, s.enabled_operations
+    FROM (
+      SELECT *, ROW_NUMBER() OVER (PARTITION BY city_id ORDER BY ts DESC) AS open_rank
+      FROM queue_samples
+      WHERE valid_to IS NULL
+    ) s
+    JOIN cities c ON c.id = s.city_id
+    JOIN services sv ON sv.id = s.service_ref
+    JOIN queue_statuses st ON st.id = s.status_id
+    WHERE s.open_rank = 1;
   )";
+  ReadTickets(sql, tickets);
 
-  sqlite3_stmt* stmt;
-  int result_code = sqlite3_prepare_v2(connection_->Get(), sql, -1, &stmt, nullptr);
-  if (result_code != SQLITE_OK) {
-    spdlog::error("Failed to prepare statement: {}", sqlite3_errmsg(connection_->Get()));
+  return tickets;
+}
+
+bool DatabaseService::MigrateLegacyRows(int max_rows) {
+  if (!legacy_rows_pending_) {
+    return true;
+  }
+
+  auto started_at = std::chrono::steady_clock::now();
+  if (!legacy_rows_remaining_.has_value()) {
+    legacy_rows_remaining_ = CountRows("ticket_info_v1");
+  }
+
+  std::string batch_sql = R"(
+    DROP TABLE IF EXISTS temp.legacy_batch;
+    CREATE TEMP TABLE legacy_batch AS
+      SELECT *, COALESCE()" + LegacyTimestampMs("t.timestamp") + ", " +
+                          LegacyTimestampMs("t.created_at") + R"() AS sample_ts,
+             )" + LEGACY_INTERVAL_END_SQL + R"( AS interval_end
+      FROM ticket_info_v1 t ORDER BY t.id LIMIT )" + std::to_string(max_rows) + R"(;
+    DROP TABLE IF EXISTS temp.legacy_copied;
+    CREATE TEMP TABLE legacy_copied (id INTEGER PRIMARY KEY);
+
+    INSERT OR IGNORE INTO cities (name) SELECT DISTINCT city FROM legacy_batch;
+    INSERT OR IGNORE INTO queue_statuses (name) SELECT DISTINCT queue_status FROM legacy_batch;
+    INSERT OR IGNORE INTO services (duw_id, name)
+      SELECT DISTINCT COALESCE(service_id, 0), COALESCE(service_name, '') FROM legacy_batch;
+  )";
+
+  DBTransaction transaction(connection_->Get());
+  auto abort = [this, &transaction] {
+    transaction.Rollback();
+    ResetAfterRollback();
     return false;
+  };
+  if (!transaction.IsActive() || !ExecuteQuery(batch_sql)) {
+    return abort();
   }
 
-  sqlite3_bind_text(stmt, static_cast<int>(BindIndex::BIND_CITY),
-                    ticket.city.c_str(), -1, SQLITE_STATIC);
-  sqlite3_bind_text(stmt, static_cast<int>(BindIndex::BIND_QUEUE_STATUS),
-                    ticket.queue_status.c_str(), -1, SQLITE_STATIC);
-  sqlite3_bind_int(stmt, static_cast<int>(BindIndex::BIND_QUEUE_LENGTH),
-                   ticket.queue_length);
-  sqlite3_bind_text(stmt, static_cast<int>(BindIndex::BIND_TIMESTAMP),
-                    ticket.timestamp.c_str(), -1, SQLITE_STATIC);
-  sqlite3_bind_text(stmt, static_cast<int>(BindIndex::BIND_SERVICE_NAME),
-                    ticket.service_name.c_str(), -1, SQLITE_STATIC);
-  sqlite3_bind_int(stmt, static_cast<int>(BindIndex::BIND_SERVICE_ID),
-                   ticket.service_id);
-  sqlite3_bind_int(stmt, static_cast<int>(BindIndex::BIND_OPERATIONS_COUNT),
-                   ticket.operations_count);
-  sqlite3_bind_int(stmt, static_cast<int>(BindIndex::BIND_ENABLED_OPERATIONS),
-                   ticket.enabled_operations);
+  std::vector<int> months;
+  {
+    DBStatement stmt(connection_->Get(), R"(
+      SELECT DISTINCT CAST(strftime('%Y%m', sample_ts / 1000, 'unixepoch') AS INTEGER)
+      FROM legacy_batch WHERE sample_ts IS NOT NULL;
+    )");
+    if (!stmt.IsValid()) {
+      return abort();
+    }
+    while (sqlite3_step(stmt.Get()) == SQLITE_ROW) {
+      months.push_back(sqlite3_column_int(stmt.Get(), 0));
+    }
+  }
 
-  result_code = sqlite3_step(stmt);
-  sqlite3_finalize(stmt);
+  for (int month : months) {
+    std::string insert_sql = "INSERT OR IGNORE INTO " + PartitionTable(month) + " (" +
+                             SAMPLE_COLUMNS + R"()
+      SELECT
+        c.id,
+        b.sample_ts,
+        )" + LegacyTimestampMs("b.interval_end") + R"(,
+        sv.id,
+        st.id,
+        b.queue_length,
+        COALESCE(b.operations_count, 0),
+        COALESCE(b.enabled_operations, 0)
+      FROM legacy_batch b
+      JOIN cities c ON c.name = b.city
+      JOIN services sv ON sv.duw_id = COALESCE(b.service_id, 0) AND sv.name = COALESCE(b.service_name, '')
+      JOIN queue_statuses st ON st.name = b.queue_status
+      WHERE )" + MonthFilter("b.sample_ts", month) + ";";
+    std::string copied_sql = R"(
+      INSERT INTO legacy_copied (id)
+      SELECT b.id
+      FROM legacy_batch b
+      JOIN cities c ON c.name = b.city
+      JOIN )" + PartitionTable(month) + R"( p ON p.city_id = c.id AND p.ts = b.sample_ts
+      WHERE )" + MonthFilter("b.sample_ts", month) + ";";
+    if (!EnsurePartition(month) || !ExecuteQuery(insert_sql) || !ExecuteQuery(copied_sql)) {
+      return abort();
+    }
+  }
+
+  auto moved = CountRows("temp.legacy_batch");
+  auto copied = CountRows("temp.legacy_copied");
+  if (!moved.has_value() || !copied.has_value()) {
+    return abort();
+  }
+
+  std::int64_t rejected = *moved - *copied;
+  if (rejected > 0 && !ExecuteQuery(std::string(REJECTED_SAMPLES_SCHEMA_SQL) + R"(
+    INSERT INTO rejected_samples (change_set_sequence, city, queue_status, queue_length, ts,
+                                  service_name, service_id, operations_count,
+                                  enabled_operations, error, rejected_at)
+    SELECT 0, city, queue_status, queue_length, sample_ts, service_name, service_id,
+           operations_count, enabled_operations,
+           CASE WHEN sample_ts IS NULL
+             THEN 'unparseable legacy timestamp ' || quote(timestamp)
+             ELSE 'legacy row could not be copied'
+           END,
+           CAST(strftime('%s', 'now') AS INTEGER) * 1000
+    FROM legacy_batch
+    WHERE id NOT IN (SELECT id FROM legacy_copied);
+  )")) {
+    return abort();
+  }
+
+  if (!ExecuteQuery(R"(
+    DELETE FROM ticket_info_v1 WHERE id IN (SELECT id FROM legacy_batch);
+    DROP TABLE temp.legacy_batch;
+    DROP TABLE temp.legacy_copied;
+  )")) {
+    return abort();
+  }
+
+  bool finished = *moved < max_rows;
+  if (finished) {
+    std::string finish_sql = "DROP VIEW IF EXISTS ticket_info; DROP TABLE ticket_info_v1; " +
+                             CompatibilityViewSql(false) + SchemaVersionSql(SCHEMA_VERSION);
+    if (!ExecuteQuery(finish_sql)) {
+      return abort();
+    }
+  }
+
+  if (!transaction.Commit()) {
+    return abort();
+  }
+
+  legacy_rows_pending_ = !finished;
+  legacy_rows_remaining_ =
+      finished ? 0 : std::max<std::int64_t>(legacy_rows_remaining_.value_or(0) - *moved, 0);
+  MigrationRemainingRows().Set(*legacy_rows_remaining_);
+  if (rejected > 0) {
+    spdlog::warn("Moved {} legacy rows that could not be migrated to rejected_samples", rejected);
+  }
+  auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - started_at);
+  if (legacy_rows_pending_) {
+    spdlog::info("Migrated {} legacy rows to v2 schema in {} ms, about {} remaining", *moved,
+                 elapsed.count(), *legacy_rows_remaining_);
+  } else {
+    spdlog::info("Legacy ticket_info migration completed");
+  }
+  return true;
+}
+
+std::optional<std::vector<SampleRecord>> DatabaseService::ReadSamplesChangedSince(
+    std::int64_t watermark_ms) {
+  const char* sql = R"(
+    SELECT c.name, st.name, s.queue_length, s.ts, sv.name, sv.duw_id, s.operations_count,
+           s.enabled_operations, s.valid_to
+    FROM queue_samples s
+    JOIN cities c ON c.id = s.city_id
+    JOIN services sv ON sv.id = s.service_ref
+    JOIN queue_statuses st ON st.id = s.status_id
+    WHERE s.ts > ?1 OR s.valid_to > ?1
+    ORDER BY s.ts;
+  )";
+
+  DBStatement stmt(connection_->Get(), sql);
+  if (!stmt.IsValid()) {
+    return std::nullopt;
+  }
+  sqlite3_bind_int64(stmt.Get(), 1, watermark_ms);
+
+  std::vector<SampleRecord> records;
+  int result_code = SQLITE_ROW;
+  while ((result_code = sqlite3_step(stmt.Get())) == SQLITE_ROW) {
+    records.push_back(ReadSampleRecord(stmt.Get()));
+  }
+
+  if (result_code != SQLITE_DONE) {
+    spdlog::error("Failed to read changed samples: {}", sqlite3_errmsg(connection_->Get()));
+    return std::nullopt;
+  }
+  return records;
+}
+
+std::optional<SampleChanges> DatabaseService::ReadSampleChanges(std::int64_t after_sequence) {
+  const char* sql = R"(
+    SELECT c.name, st.name, s.queue_length, s.ts, sv.name, sv.duw_id, s.operations_count,
+           s.enabled_operations, s.valid_to, l.seq
+    FROM sample_changes l
+    JOIN queue_samples s ON s.city_id = l.city_id AND s.ts = l.ts
+    JOIN cities c ON c.id = s.city_id
+    JOIN services sv ON sv.id = s.service_ref
+    JOIN queue_statuses st ON st.id = s.status_id
+    WHERE l.seq > ?1
+    ORDER BY l.seq;
+  )";
+
+  DBStatement stmt(connection_->Get(), sql);
+  if (!stmt.IsValid()) {
+    return std::nullopt;
+  }
+  sqlite3_bind_int64(stmt.Get(), 1, after_sequence);
+
+  SampleChanges changes{.records = {}, .last_sequence = after_sequence};
+  int result_code = SQLITE_ROW;
+  while ((result_code = sqlite3_step(stmt.Get())) == SQLITE_ROW) {
+    changes.records.push_back(ReadSampleRecord(stmt.Get()));
+    changes.last_sequence = sqlite3_column_int64(
+        stmt.Get(), static_cast<int>(ColumnIndex::COL_CHANGE_SEQUENCE));
+  }
 
   if (result_code != SQLITE_DONE) {
-    spdlog::error("Failed to insert ticket: {}", sqlite3_errmsg(connection_->Get()));
+    spdlog::error("Failed to read logged sample changes: {}", sqlite3_errmsg(connection_->Get()));
+    return std::nullopt;
+  }
+  return changes;
+}
+
+std::optional<std::int64_t> DatabaseService::LatestChangeSequence() {
+  DBStatement stmt(connection_->Get(), R"(
+    SELECT COALESCE((SELECT seq FROM sqlite_sequence WHERE name = 'sample_changes'), 0);
+  )");
+  if (!stmt.IsValid() || sqlite3_step(stmt.Get()) != SQLITE_ROW) {
+    return std::nullopt;
+  }
+  return sqlite3_column_int64(stmt.Get(), 0);
+}
+
+bool DatabaseService::PruneSampleChanges(std::int64_t through_sequence) {
+  DBStatement stmt(connection_->Get(), "DELETE FROM sample_changes WHERE seq <= ?;");
+  if (!stmt.IsValid()) {
+    return false;
+  }
+
+  sqlite3_bind_int64(stmt.Get(), 1, through_sequence);
+  if (sqlite3_step(stmt.Get()) != SQLITE_DONE) {
+    spdlog::error("Failed to prune sample changes: {}", sqlite3_errmsg(connection_->Get()));
+    return false;
+  }
+  return true;
+}
+
+bool DatabaseService::ApplySampleRecords(std::span<const SampleRecord> records) {
+  return UpsertSampleRecords(records, false);
+}
+
+bool DatabaseService::MergeSampleRecords(std::span<const SampleRecord> records) {
+  return UpsertSampleRecords(records, true);
+}
+
+bool DatabaseService::UpsertSampleRecords(std::span<const SampleRecord> records,
+                                          bool close_earlier) {
+  DBTransaction transaction(connection_->Get());
+  if (!transaction.IsActive()) {
+    return false;
+  }
+
+  std::size_t archived = 0;
+  for (const auto& record : records) {
+    if (IsArchivedMonth(record.ticket.timestamp_ms)) {
+      archived++;
+      continue;
+    }
+
+    int month = WritePartition(record.ticket.timestamp_ms);
+    DBStatement* stmt =
+        month != 0 ? PartitionStatement(month, &PartitionStatements::apply, ApplySampleSql)
+                   : nullptr;
+    int result_code =
+        stmt != nullptr ? InsertSample(stmt, record.ticket, record.valid_to_ms) : SQLITE_ERROR;
+    if (result_code == SQLITE_DONE && close_earlier) {
+      result_code = CloseOpenInterval(record.ticket.city, record.ticket.timestamp_ms);
+    }
+    if (result_code != SQLITE_DONE) {
+      spdlog::error("Failed to apply sample for city {}: {}", record.ticket.city,
+                    sqlite3_errmsg(connection_->Get()));
+      transaction.Rollback();
+      ResetAfterRollback();
+      return false;
+    }
+  }
+
+  if (!transaction.Commit()) {
+    ResetAfterRollback();
+    return false;
+  }
+  if (archived > 0) {
+    spdlog::warn("Skipped {} samples from months that were already archived", archived);
+  }
+  return true;
+}
+
+std::optional<std::int64_t> DatabaseService::LatestChangeTimestamp() {
+  DBStatement stmt(connection_->Get(),
+                   "SELECT COALESCE(MAX(MAX(ts, COALESCE(valid_to, 0))), 0) FROM queue_samples;");
+  if (!stmt.IsValid() || sqlite3_step(stmt.Get()) != SQLITE_ROW) {
+    return std::nullopt;
+  }
+  return sqlite3_column_int64(stmt.Get(), 0);
+}
+
+std::optional<std::string> DatabaseService::LoadSyncValue(const std::string& key) {
+  DBStatement stmt(connection_->Get(), "SELECT value FROM sync_state WHERE key = ?;");
+  if (!stmt.IsValid()) {
+    return std::nullopt;
+  }
+
+  sqlite3_bind_text(stmt.Get(), 1, key.c_str(), -1, SQLITE_STATIC);
+  if (sqlite3_step(stmt.Get()) != SQLITE_ROW) {
+    return std::nullopt;
+  }
+
+  const auto* text = sqlite3_column_text(stmt.Get(), 0);
+  return std::string(reinterpret_cast<const char*>(text));
+}
+
+bool DatabaseService::BackfillRollups() {
+  std::vector<std::int64_t> city_ids;
+  {
+    DBStatement stmt(connection_->Get(), "SELECT id FROM cities ORDER BY id;");
+    if (!stmt.IsValid()) {
+      return false;
+    }
+    while (sqlite3_step(stmt.Get()) == SQLITE_ROW) {
+      city_ids.push_back(sqlite3_column_int64(stmt.Get(), 0));
+    }
+  }
+
+  std::string hot_since =
+      std::to_string(archived_before_ != 0 ? MonthStartMs(archived_before_) : 0);
+  for (std::size_t i = 0; i < city_ids.size(); ++i) {
+    std::string city_filter = "city_id = " + std::to_string(city_ids[i]);
+    std::string intervals = ClosedIntervalsSql(city_filter + " AND valid_to > " + hot_since);
+    std::string sql;
+    for (const auto& resolution : ROLLUP_RESOLUTIONS) {
+      std::string buckets = IntervalBucketsSql(
+          resolution, intervals, RollupBucket("MAX(ts, " + hot_since + ")", resolution));
+      sql += "DELETE FROM " + RollupTable(resolution) + " WHERE " + city_filter +
+             " AND bucket_start >= " + hot_since + ";\n" +
+             RollupMergeSql(resolution, buckets, "covered_ms > 0") + "\n";
+    }
+
+    DBTransaction transaction(connection_->Get());
+    if (!transaction.IsActive() || !ExecuteQuery(sql) || !transaction.Commit()) {
+      spdlog::error("Failed to backfill rollups for city id {}", city_ids[i]);
+      return false;
+    }
+    spdlog::info("Backfilled rollups for {} of {} cities", i + 1, city_ids.size());
+  }
+  return true;
+}
+
+bool DatabaseService::ApplyRetention(int retention_months, const std::string& archive_dir) {
+  if (retention_months <= 0) {
+    return true;
+  }
+
+  int oldest_kept = AddMonths(CurrentMonth(), 1 - retention_months);
+  if (!EnsurePartition(CurrentMonth())) {
     return false;
   }
 
+  bool dropped = false;
+  while (partitions_.size() > 1 && partitions_.front() < oldest_kept) {
+    if (!ArchivePartition(partitions_.front(), archive_dir) || !DropOldestPartition()) {
+      return false;
+    }
+    dropped = true;
+  }
+  return !dropped || ExecuteQuery("PRAGMA incremental_vacuum;");
+}
+
+bool DatabaseService::SaveSyncValue(const std::string& key, const std::string& value) {
+  DBStatement stmt(connection_->Get(),
+                   "INSERT OR REPLACE INTO sync_state (key, value) VALUES (?, ?);");
+  if (!stmt.IsValid()) {
+    return false;
+  }
+
+  sqlite3_bind_text(stmt.Get(), 1, key.c_str(), -1, SQLITE_STATIC);
+  sqlite3_bind_text(stmt.Get(), 2, value.c_str(), -1, SQLITE_STATIC);
+  if (sqlite3_step(stmt.Get()) != SQLITE_DONE) {
+    spdlog::error("Failed to save sync state {}: {}", key, sqlite3_errmsg(connection_->Get()));
+    return false;
+  }
   return true;
 }
 
+void DatabaseService::ResetCachedStatements() {
+  partition_statements_.clear();
+  close_legacy_interval_statement_.reset();
+  reject_sample_statement_.reset();
+  ClearDimensionCaches();
+}
+
+void DatabaseService::ResetAfterRollback() {
+  reject_sample_statement_.reset();
+  ClearDimensionCaches();
+  LoadPartitions();
+}
+
+void DatabaseService::ClearDimensionCaches() {
+  cities_.Clear();
+  services_.Clear();
+  statuses_.Clear();
+}
+
+DBStatement* DatabaseService::GetCachedStatement(std::unique_ptr<DBStatement>& cached,
+                                                 const std::string& sql) {
+  if (cached != nullptr) {
+    return cached.get();
+  }
+
+  auto stmt = std::make_unique<DBStatement>(connection_->Get(), sql);
+  if (!stmt->IsValid()) {
+    return nullptr;
+  }
+
+  cached = std::move(stmt);
+  return cached.get();
+}
+
+int DatabaseService::InsertSample(DBStatement* stmt, const TicketInfo& ticket,
+                                  std::optional<std::int64_t> valid_to_ms) {
+  sqlite3* db = connection_->Get();
+  auto city_id = cities_.Intern(db, ticket.city);
+  if (!city_id.has_value()) {
+    int result_code = sqlite3_extended_errcode(db);
+    return IsRowLevelError(result_code) ? result_code : SQLITE_ERROR;
+  }
+
+  auto service_ref = services_.Intern(db, ticket.service_name, ticket.service_id);
+  auto status_id = statuses_.Intern(db, ticket.queue_status);
+  if (!service_ref.has_value() || !status_id.has_value()) {
+    return SQLITE_ERROR;
+  }
+
+  sqlite3_stmt* raw_stmt = stmt->Get();
+  sqlite3_bind_int64(raw_stmt, static_cast<int>(BindIndex::BIND_CITY_ID), *city_id);
+  sqlite3_bind_int64(raw_stmt, static_cast<int>(BindIndex::BIND_TIMESTAMP),
+                     ticket.timestamp_ms);
+  sqlite3_bind_int64(raw_stmt, static_cast<int>(BindIndex::BIND_SERVICE_REF), *service_ref);
+  sqlite3_bind_int64(raw_stmt, static_cast<int>(BindIndex::BIND_STATUS_ID), *status_id);
+  sqlite3_bind_int(raw_stmt, static_cast<int>(BindIndex::BIND_QUEUE_LENGTH),
+                   ticket.queue_length);
+  sqlite3_bind_int(raw_stmt, static_cast<int>(BindIndex::BIND_OPERATIONS_COUNT),
+                   ticket.operations_count);
+  sqlite3_bind_int(raw_stmt, static_cast<int>(BindIndex::BIND_ENABLED_OPERATIONS),
+                   ticket.enabled_operations);
+  if (valid_to_ms.has_value()) {
+    sqlite3_bind_int64(raw_stmt, static_cast<int>(BindIndex::BIND_VALID_TO), *valid_to_ms);
+  }
+
+  int result_code = sqlite3_step(raw_stmt);
+  stmt->Reset();
+  return result_code;
+}
+
+DBStatement* DatabaseService::PartitionStatement(
+    int month, std::unique_ptr<DBStatement> PartitionStatements::*statement,
+    PartitionSql build_sql) {
+  auto& cached = partition_statements_[month].*statement;
+  return cached != nullptr ? cached.get()
+                           : GetCachedStatement(cached, build_sql(PartitionTable(month)));
+}
+
+int DatabaseService::CloseOpenInterval(const std::string& city, std::int64_t timestamp_ms) {
+  auto city_id = cities_.Intern(connection_->Get(), city);
+  if (!city_id.has_value()) {
+    return SQLITE_ERROR;
+  }
+
+  int result_code = SQLITE_DONE;
+  int newest_month = MonthKey(timestamp_ms);
+  for (auto month : partitions_ | std::views::reverse) {
+    if (month > newest_month) {
+      continue;
+    }
+
+    DBStatement* latest_stmt =
+        PartitionStatement(month, &PartitionStatements::latest_before, LatestSampleBeforeSql);
+    if (latest_stmt == nullptr) {
+      return SQLITE_ERROR;
+    }
+    sqlite3_bind_int64(latest_stmt->Get(), 1, *city_id);
+    sqlite3_bind_int64(latest_stmt->Get(), 2, timestamp_ms);
+    result_code = sqlite3_step(latest_stmt->Get());
+    bool found = result_code == SQLITE_ROW &&
+                 sqlite3_column_type(latest_stmt->Get(), 0) != SQLITE_NULL;
+    std::int64_t latest_ts = found ? sqlite3_column_int64(latest_stmt->Get(), 0) : 0;
+    latest_stmt->Reset();
+    if (result_code != SQLITE_ROW) {
+      return result_code;
+    }
+    if (!found) {
+      result_code = SQLITE_DONE;
+      continue;
+    }
+
+    DBStatement* close_stmt =
+        PartitionStatement(month, &PartitionStatements::close_interval, CloseIntervalSql);
+    if (close_stmt == nullptr) {
+      return SQLITE_ERROR;
+    }
+    sqlite3_bind_int64(close_stmt->Get(), 1, *city_id);
+    sqlite3_bind_int64(close_stmt->Get(), 2, latest_ts);
+    sqlite3_bind_int64(close_stmt->Get(), 3, timestamp_ms);
+    result_code = sqlite3_step(close_stmt->Get());
+    close_stmt->Reset();
+    break;
+  }
+
+  if (result_code != SQLITE_DONE || !legacy_rows_pending_) {
+    return result_code;
+  }
+
+  DBStatement* legacy_stmt =
+      GetCachedStatement(close_legacy_interval_statement_, CLOSE_LEGACY_INTERVAL_SQL);
+  if (legacy_stmt == nullptr) {
+    return SQLITE_ERROR;
+  }
+
+  sqlite3_bind_text(legacy_stmt->Get(), 1, city.c_str(), -1, SQLITE_STATIC);
+  sqlite3_bind_int64(legacy_stmt->Get(), 2, timestamp_ms);
+  result_code = sqlite3_step(legacy_stmt->Get());
+  legacy_stmt->Reset();
+  return result_code;
+}
+
+void DatabaseService::ReadTickets(const std::string& sql, std::vector<TicketInfo>& tickets) {
+  DBStatement stmt(connection_->Get(), sql);
+  if (!stmt.IsValid()) {
+    return;
+  }
+
+  while (sqlite3_step(stmt.Get()) == SQLITE_ROW) {
+    tickets.push_back(ReadTicket(stmt.Get()));
+  }
+}
+
+SampleRecord DatabaseService::ReadSampleRecord(sqlite3_stmt* stmt) {
+  SampleRecord record{.ticket = ReadTicket(stmt), .valid_to_ms = std::nullopt};
+  int valid_to_column = static_cast<int>(ColumnIndex::COL_VALID_TO);
+  if (sqlite3_column_type(stmt, valid_to_column) != SQLITE_NULL) {
+    record.valid_to_ms = sqlite3_column_int64(stmt, valid_to_column);
+  }
+  return record;
+}
+
+TicketInfo DatabaseService::ReadTicket(sqlite3_stmt* stmt) {
+  auto text_column = [stmt](ColumnIndex column) {
+    const auto* text = sqlite3_column_text(stmt, static_cast<int>(column));
+    return text != nullptr ? std::string(reinterpret_cast<const char*>(text)) : std::string();
+  };
+  auto int_column = [stmt](ColumnIndex column) {
+    return sqlite3_column_int(stmt, static_cast<int>(column));
+  };
+
+  return TicketInfo{
+    .city = text_column(ColumnIndex::COL_CITY),
+    .queue_status = text_column(ColumnIndex::COL_QUEUE_STATUS),
+    .queue_length = int_column(ColumnIndex::COL_QUEUE_LENGTH),
+    .timestamp_ms = sqlite3_column_int64(stmt, static_cast<int>(ColumnIndex::COL_TIMESTAMP)),
+    .service_name = text_column(ColumnIndex::COL_SERVICE_NAME),
+    .service_id = int_column(ColumnIndex::COL_SERVICE_ID),
+    .operations_count = int_column(ColumnIndex::COL_OPERATIONS_COUNT),
+    .enabled_operations = int_column(ColumnIndex::COL_ENABLED_OPERATIONS)
+  };
+}
+
 bool DatabaseService::CreateTables() {
   const char* sql = R"(
-    CREATE TABLE IF NOT EXISTS ticket_info (
-      id INTEGER PRIMARY KEY AUTOINCREMENT,
-      city TEXT NOT NULL,
-      queue_status TEXT NOT NULL,
-      queue_length INTEGER NOT NULL,
-      timestamp TEXT NOT NULL,
-      service_name TEXT,
-      service_id INTEGER,
-      operations_count INTEGER DEFAULT 0,
-      enabled_operations INTEGER DEFAULT 0,
-      created_at DATETIME DEFAULT CURRENT_TIMESTAMP
+    CREATE TABLE IF NOT EXISTS cities (
+      id INTEGER PRIMARY KEY,
+      name TEXT NOT NULL UNIQUE
+    );
+
+    CREATE TABLE IF NOT EXISTS services (
+      id INTEGER PRIMARY KEY,
+      duw_id INTEGER NOT NULL,
+      name TEXT NOT NULL,
+      UNIQUE (duw_id, name)
+    );
+
+    CREATE TABLE IF NOT EXISTS queue_statuses (
+      id INTEGER PRIMARY KEY,
+      name TEXT NOT NULL UNIQUE
+    );
+
+    CREATE TABLE IF NOT EXISTS sync_state (
+      key TEXT PRIMARY KEY,
+      value TEXT NOT NULL
     );
-    
-    CREATE INDEX IF NOT EXISTS idx_timestamp ON ticket_info(timestamp);
-    CREATE INDEX IF NOT EXISTS idx_city ON ticket_info(city);
-    CREATE INDEX IF NOT EXISTS idx_created_at ON ticket_info(created_at);
   )";
 
+  return ExecuteQuery(sql) && ExecuteQuery(CityIdLimitSql()) &&
+         ExecuteQuery(CHANGE_LOG_SCHEMA_SQL) && ExecuteQuery(RollupSchemaSql());
+}
+
+bool DatabaseService::CreateChangeLog() {
+  std::string sql = CHANGE_LOG_SCHEMA_SQL;
+  for (int month : partitions_) {
+    sql += ChangeLogTriggerSql(PartitionTable(month));
+  }
   return ExecuteQuery(sql);
 }
 
+bool DatabaseService::UpgradeRollups() {
+  auto has_durations = HasColumn(RollupTable(ROLLUP_RESOLUTIONS[0]), "covered_ms");
+  if (!has_durations.has_value()) {
+    return false;
+  }
+  if (*has_durations) {
+    return true;
+  }
+
+  spdlog::info("Rebuilding rollup tables with duration-weighted aggregates");
+  std::string sql;
+  for (const auto& resolution : ROLLUP_RESOLUTIONS) {
+    sql += "DROP TABLE IF EXISTS " + RollupTable(resolution) + ";\n";
+  }
+  sql += RollupSchemaSql();
+  for (int month : partitions_) {
+    std::string table = PartitionTable(month);
+    sql += "DROP TRIGGER IF EXISTS " + table + "_rollup_insert;\nDROP TRIGGER IF EXISTS " +
+           table + "_rollup_update;\n" + RollupTriggerSql(table);
+  }
+  if (!ExecuteQuery(sql)) {
+    return false;
+  }
+
+  if (CountRows("queue_samples").value_or(0) > 0) {
+    spdlog::warn("Rollup tables were rebuilt for existing samples, run MODE=backfill_rollups");
+  }
+  return true;
+}
 
 bool DatabaseService::ExecuteQuery(const std::string& query) {
   int result_code = sqlite3_exec(connection_->Get(), query.c_str(), nullptr, nullptr, nullptr);
@@ -132,89 +1359,398 @@ bool DatabaseService::ExecuteQuery(const std::string& query) {
 }
 
 bool DatabaseService::MigrateSchema() {
-  const char* check_table = R"(
-    SELECT COUNT(*) FROM sqlite_master WHERE type='table' AND name='ticket_info';
-  )";
+  legacy_rows_remaining_.reset();
+  auto version = ReadSchemaVersion();
+  if (!version.has_value()) {
+    return false;
+  }
 
-  sqlite3_stmt* stmt;
-  int result_code = sqlite3_prepare_v2(connection_->Get(), check_table, -1, &stmt, nullptr);
-  if (result_code != SQLITE_OK) {
-    spdlog::error("Failed to check table existence: {}", sqlite3_errmsg(connection_->Get()));
+  if (*version > SCHEMA_VERSION) {
+    spdlog::error("Database schema version {} is newer than the supported version {}", *version,
+                  SCHEMA_VERSION);
     return false;
   }
 
-  result_code = sqlite3_step(stmt);
-  bool table_exists = false;
-  if (result_code == SQLITE_ROW) {
-    table_exists = sqlite3_column_int(stmt, 0) > 0;
+  if (*version == SCHEMA_VERSION_UNVERSIONED) {
+    return UpgradeUnversionedSchema();
   }
-  sqlite3_finalize(stmt);
 
-  if (!table_exists) {
-    return true;
+  DBTransaction transaction(connection_->Get());
+  if (!transaction.IsActive() || !LoadPartitions() ||
+      (*version < SCHEMA_VERSION_COUNTED_ROLLUPS && !CreateChangeLog()) ||
+      (*version < SCHEMA_VERSION_DECIMAL_VIEW_IDS && !UpgradeRollups()) ||
+      (*version < SCHEMA_VERSION &&
+       !UpgradeCompatibilityView(*version == SCHEMA_VERSION_LEGACY_ROWS_PENDING)) ||
+      !EnsurePartition(CurrentMonth()) ||
+      (*version != SCHEMA_VERSION_LEGACY_ROWS_PENDING && *version < SCHEMA_VERSION &&
+       !ExecuteQuery(SchemaVersionSql(SCHEMA_VERSION))) ||
+      !transaction.Commit()) {
+    return false;
   }
 
-  const char* check_old_schema = R"(
-    SELECT COUNT(*) FROM pragma_table_info('ticket_info') WHERE name='raw_json';
-  )";
+  legacy_rows_pending_ = *version == SCHEMA_VERSION_LEGACY_ROWS_PENDING;
+  return true;
+}
 
-  result_code = sqlite3_prepare_v2(connection_->Get(), check_old_schema, -1, &stmt, nullptr);
-  if (result_code != SQLITE_OK) {
-    spdlog::error("Failed to check schema: {}", sqlite3_errmsg(connection_->Get()));
+bool DatabaseService::UpgradeUnversionedSchema() {
+  auto has_legacy_table = IsTable("ticket_info");
+  auto has_rollups = IsTable("queue_rollup_day");
+  auto has_samples_table = IsTable("queue_samples");
+  auto has_samples_view = IsView("queue_samples");
+  if (!has_legacy_table.has_value() || !has_rollups.has_value() ||
+      !has_samples_table.has_value() || !has_samples_view.has_value()) {
+    return false;
+  }
+
+  spdlog::info("Upgrading unversioned database schema to version {}", SCHEMA_VERSION);
+  if (!EnableIncrementalVacuum()) {
+    return false;
+  }
+
+  DBTransaction transaction(connection_->Get());
+  if (!transaction.IsActive() || (*has_legacy_table && !MigrateLegacyColumns()) ||
+      !CreateTables() || (*has_samples_table && !MigrateSamplesToPartitions()) ||
+      !LoadPartitions() || !CreateChangeLog() || !EnsurePartition(CurrentMonth()) ||
+      !RebuildSamplesView() || !UpgradeRollups()) {
+    return false;
+  }
+
+  if (!*has_rollups && (*has_samples_table || *has_samples_view) &&
+      CountRows("queue_samples").value_or(0) > 0) {
+    spdlog::warn("Rollup tables were created for existing samples, run MODE=backfill_rollups");
+  }
+
+  if (*has_legacy_table) {
+    spdlog::info("Moving legacy ticket_info table aside for online migration");
+    if (!ExecuteQuery("ALTER TABLE ticket_info RENAME TO ticket_info_v1;")) {
+      return false;
+    }
+  }
+
+  auto has_pending_rows = IsTable("ticket_info_v1");
+  if (!has_pending_rows.has_value()) {
     return false;
   }
 
-  result_code = sqlite3_step(stmt);
-  bool has_old_schema = false;
-  if (result_code == SQLITE_ROW) {
-    has_old_schema = sqlite3_column_int(stmt, 0) > 0;
+  std::string view_sql = "DROP VIEW IF EXISTS ticket_info; " +
+                         CompatibilityViewSql(*has_pending_rows) +
+                         SchemaVersionSql(*has_pending_rows ? SCHEMA_VERSION_LEGACY_ROWS_PENDING
+                                                            : SCHEMA_VERSION);
+  if (!ExecuteQuery(view_sql) || !transaction.Commit()) {
+    return false;
+  }
+
+  legacy_rows_pending_ = *has_pending_rows;
+  return true;
+}
+
+bool DatabaseService::UpgradeCompatibilityView(bool include_legacy_rows) {
+  return ExecuteQuery(CityIdLimitSql() + "DROP VIEW IF EXISTS ticket_info; " +
+                      CompatibilityViewSql(include_legacy_rows));
+}
+
+bool DatabaseService::MigrateLegacyColumns() {
+  std::string sql;
+  for (const auto& column : LEGACY_COLUMNS) {
+    auto has_column = HasColumn("ticket_info", column.name);
+    if (!has_column.has_value()) {
+      return false;
+    }
+    if (!*has_column) {
+      spdlog::info("Adding column {} to ticket_info", column.name);
+      sql += std::string("ALTER TABLE ticket_info ADD COLUMN ") + column.name + " " +
+             column.definition + ";\n";
+    }
   }
-  sqlite3_finalize(stmt);
 
-  if (!has_old_schema) {
+  return ExecuteQuery(sql + "CREATE INDEX IF NOT EXISTS idx_city ON ticket_info(city);");
+}
+
+std::optional<int> DatabaseService::ReadSchemaVersion() {
+  DBStatement stmt(connection_->Get(), "PRAGMA user_version;");
+  if (!stmt.IsValid() || sqlite3_step(stmt.Get()) != SQLITE_ROW) {
+    spdlog::error("Failed to read schema version: {}", sqlite3_errmsg(connection_->Get()));
+    return std::nullopt;
+  }
+  return sqlite3_column_int(stmt.Get(), 0);
+}
+
+bool DatabaseService::MigrateSamplesToPartitions() {
+  spdlog::info("Splitting queue_samples into monthly partitions");
+
+  std::vector<int> months;
+  {
+    DBStatement stmt(connection_->Get(), R"(
+      SELECT DISTINCT CAST(strftime('%Y%m', ts / 1000, 'unixepoch') AS INTEGER) FROM queue_samples;
+    )");
+    if (!stmt.IsValid()) {
+      return false;
+    }
+    while (sqlite3_step(stmt.Get()) == SQLITE_ROW) {
+      months.push_back(sqlite3_column_int(stmt.Get(), 0));
+    }
+  }
+
+  std::string sql;
+  for (int month : months) {
+    std::string table = PartitionTable(month);
+    sql += PartitionSchemaSql(table) + "INSERT INTO " + table + " (" + SAMPLE_COLUMNS +
+           ") SELECT " + SAMPLE_COLUMNS + " FROM queue_samples WHERE " +
+           MonthFilter("ts", month) + ";\n" + PartitionTriggerSql(table);
+  }
+  return ExecuteQuery(sql + "DROP TABLE queue_samples;");
+}
+
+bool DatabaseService::EnableIncrementalVacuum() {
+  {
+    DBStatement stmt(connection_->Get(), "PRAGMA auto_vacuum;");
+    if (!stmt.IsValid() || sqlite3_step(stmt.Get()) != SQLITE_ROW) {
+      return false;
+    }
+    if (sqlite3_column_int(stmt.Get(), 0) == AUTO_VACUUM_INCREMENTAL) {
+      return true;
+    }
+  }
+
+  {
+    DBStatement stmt(connection_->Get(), "SELECT COUNT(*) FROM sqlite_master;");
+    if (!stmt.IsValid() || sqlite3_step(stmt.Get()) != SQLITE_ROW) {
+      return false;
+    }
+    if (sqlite3_column_int64(stmt.Get(), 0) > 0) {
+      spdlog::info("Incremental vacuum is disabled, run MODE=vacuum once to enable it");
+      return true;
+    }
+  }
+
+  return ExecuteQuery("PRAGMA auto_vacuum = INCREMENTAL;");
+}
+
+bool DatabaseService::Vacuum() {
+  spdlog::info("Rewriting the database file with incremental vacuum enabled");
+  return ExecuteQuery("PRAGMA auto_vacuum = INCREMENTAL; VACUUM;");
+}
+
+bool DatabaseService::LoadPartitions() {
+  DBStatement stmt(connection_->Get(), R"(
+    SELECT CAST(substr(name, length(?1) + 1) AS INTEGER) FROM sqlite_master
+    WHERE type = 'table' AND name GLOB ?1 || '[0-9]*'
+    ORDER BY 1;
+  )");
+  if (!stmt.IsValid()) {
+    return false;
+  }
+
+  partitions_.clear();
+  partition_statements_.clear();
+  sqlite3_bind_text(stmt.Get(), 1, PARTITION_PREFIX, -1, SQLITE_STATIC);
+  while (sqlite3_step(stmt.Get()) == SQLITE_ROW) {
+    partitions_.push_back(sqlite3_column_int(stmt.Get(), 0));
+  }
+
+  archived_before_ = std::atoi(LoadSyncValue(ARCHIVED_BEFORE_KEY).value_or("0").c_str());
+  return true;
+}
+
+bool DatabaseService::EnsurePartition(int month) {
+  auto position = std::ranges::lower_bound(partitions_, month);
+  if (position != partitions_.end() && *position == month) {
     return true;
   }
 
-  const char* backup_sql = R"(
-    CREATE TABLE IF NOT EXISTS ticket_info_backup AS 
-    SELECT * FROM ticket_info;
-  )";
+  std::string table = PartitionTable(month);
+  spdlog::info("Creating partition {}", table);
+  partitions_.insert(position, month);
+  if (ExecuteQuery("SAVEPOINT create_partition;\n" + PartitionSchemaSql(table) +
+                   PartitionTriggerSql(table)) &&
+      RebuildSamplesView() && ExecuteQuery("RELEASE create_partition;")) {
+    return true;
+  }
+
+  ExecuteQuery("ROLLBACK TO create_partition; RELEASE create_partition;");
+  partitions_.erase(std::ranges::find(partitions_, month));
+  return false;
+}
 
-  if (!ExecuteQuery(backup_sql)) {
+bool DatabaseService::RebuildSamplesView() {
+  std::string sql = "DROP VIEW IF EXISTS queue_samples;\nCREATE VIEW queue_samples AS";
+  for (std::size_t i = 0; i < partitions_.size(); ++i) {
+    sql += std::string(i == 0 ? "" : "\n  UNION ALL") + " SELECT " + SAMPLE_COLUMNS + " FROM " +
+           PartitionTable(partitions_[i]);
+  }
+  return !partitions_.empty() && ExecuteQuery(sql + ";");
+}
+
+bool DatabaseService::IsArchivedMonth(std::int64_t timestamp_ms) const {
+  return MonthKey(timestamp_ms) < archived_before_;
+}
+
+int DatabaseService::WritePartition(std::int64_t timestamp_ms) {
+  if (IsArchivedMonth(timestamp_ms)) {
+    return 0;
+  }
+
+  int month = MonthKey(timestamp_ms);
+  return EnsurePartition(month) ? month : 0;
+}
+
+bool DatabaseService::ArchivePartition(int month, const std::string& archive_dir) {
+  namespace fs = std::filesystem;
+
+  std::string table = PartitionTable(month);
+  std::string base = (fs::path(archive_dir) / table).string();
+  fs::path staging_path = base + ".db.tmp";
+  fs::path compressed_path = base + ".db.gz.tmp";
+  fs::path archive_path = base + ".db.gz";
+  for (int copy = 2; fs::exists(archive_path); ++copy) {
+    archive_path = base + "-" + std::to_string(copy) + ".db.gz";
+  }
+
+  std::error_code error;
+  fs::create_directories(archive_dir, error);
+  fs::remove(staging_path, error);
+  if (error) {
+    spdlog::error("Failed to prepare archive directory {}: {}", archive_dir, error.message());
     return false;
   }
 
-  if (!ExecuteQuery("DROP TABLE ticket_info;")) {
+  {
+    DBStatement attach(connection_->Get(), "ATTACH DATABASE ? AS archive;");
+    if (!attach.IsValid()) {
+      return false;
+    }
+    sqlite3_bind_text(attach.Get(), 1, staging_path.c_str(), -1, SQLITE_STATIC);
+    if (sqlite3_step(attach.Get()) != SQLITE_DONE) {
+      spdlog::error("Failed to attach archive {}: {}", staging_path.string(),
+                    sqlite3_errmsg(connection_->Get()));
+      return false;
+    }
+  }
+
+  std::string export_sql = R"(
+    CREATE TABLE archive.cities AS SELECT * FROM main.cities;
+    CREATE TABLE archive.services AS SELECT * FROM main.services;
+    CREATE TABLE archive.queue_statuses AS SELECT * FROM main.queue_statuses;
+  )" + SampleTableSql("archive.queue_samples") + "INSERT INTO archive.queue_samples (" +
+                           SAMPLE_COLUMNS + ") SELECT " + SAMPLE_COLUMNS + " FROM main." +
+                           table + ";";
+  bool exported = false;
+  {
+    DBTransaction transaction(connection_->Get());
+    exported = transaction.IsActive() && ExecuteQuery(export_sql) && transaction.Commit();
+  }
+  if (!ExecuteQuery("DETACH DATABASE archive;") || !exported) {
+    fs::remove(staging_path, error);
     return false;
   }
 
-  if (!CreateTables()) {
+  std::ifstream staging(staging_path, std::ios::binary);
+  std::string content((std::istreambuf_iterator<char>(staging)), std::istreambuf_iterator<char>());
+  staging.close();
+  auto compressed = GzipCompress(content);
+  if (!compressed.has_value()) {
+    spdlog::error("Failed to compress archive for {}", table);
     return false;
   }
 
-  const char* migrate_sql = R"(
-    INSERT INTO ticket_info (id, city, queue_status, queue_length, timestamp, service_name, service_id, operations_count, enabled_operations, created_at)
-    SELECT 
-      id, 
-      city, 
-      queue_status, 
-      queue_length, 
-      timestamp, 
-      'legacy_service' as service_name,
-      0 as service_id,
-      0 as operations_count,
-      0 as enabled_operations,
-      created_at
-    FROM ticket_info_backup;
-  )";
+  std::ofstream(compressed_path, std::ios::binary | std::ios::trunc) << *compressed;
+  if (!SyncToDisk(compressed_path)) {
+    spdlog::error("Failed to write archive {}", compressed_path.string());
+    return false;
+  }
 
-  if (!ExecuteQuery(migrate_sql)) {
+  fs::rename(compressed_path, archive_path, error);
+  if (error) {
+    spdlog::error("Failed to publish archive {}: {}", archive_path.string(), error.message());
     return false;
   }
+  fs::permissions(archive_path, fs::perms::owner_read | fs::perms::group_read |
+                                    fs::perms::others_read, error);
+  fs::remove(staging_path, error);
+  spdlog::info("Archived partition {} to {} ({} bytes)", table, archive_path.string(),
+               compressed->size());
+  return true;
+}
 
-  ExecuteQuery("DROP TABLE ticket_info_backup;");
+bool DatabaseService::DropOldestPartition() {
+  int month = partitions_.front();
+  std::string table = PartitionTable(month);
+  std::string carry_sql = "DELETE FROM sample_changes WHERE ts < " +
+                          std::to_string(MonthStartMs(AddMonths(month, 1))) +
+                          ";\nINSERT OR IGNORE INTO " + PartitionTable(partitions_[1]) + " (" +
+                          SAMPLE_COLUMNS + ") SELECT " + SAMPLE_COLUMNS + " FROM " + table +
+                          " WHERE valid_to IS NULL;\nDROP TABLE " + table + ";";
+
+  DBTransaction transaction(connection_->Get());
+  partition_statements_.erase(month);
+  if (!transaction.IsActive() || !ExecuteQuery(carry_sql) ||
+      !SaveSyncValue(ARCHIVED_BEFORE_KEY, std::to_string(AddMonths(month, 1)))) {
+    transaction.Rollback();
+    ResetAfterRollback();
+    return false;
+  }
+
+  partitions_.erase(partitions_.begin());
+  if (!RebuildSamplesView() || !transaction.Commit()) {
+    transaction.Rollback();
+    ResetAfterRollback();
+    return false;
+  }
 
+  archived_before_ = AddMonths(month, 1);
+  spdlog::info("Dropped partition {} from the hot database", table);
   return true;
 }
 
+std::optional<bool> DatabaseService::HasColumn(const std::string& table, const std::string& column) {
+  DBStatement stmt(connection_->Get(),
+                   "SELECT COUNT(*) FROM pragma_table_info(?) WHERE name = ?;");
+  if (!stmt.IsValid()) {
+    return std::nullopt;
+  }
+
+  sqlite3_bind_text(stmt.Get(), 1, table.c_str(), -1, SQLITE_STATIC);
+  sqlite3_bind_text(stmt.Get(), 2, column.c_str(), -1, SQLITE_STATIC);
+  if (sqlite3_step(stmt.Get()) != SQLITE_ROW) {
+    spdlog::error("Failed to check schema: {}", sqlite3_errmsg(connection_->Get()));
+    return std::nullopt;
+  }
+
+  return sqlite3_column_int(stmt.Get(), 0) > 0;
+}
+
+std::optional<bool> DatabaseService::IsTable(const std::string& name) {
+  return HasSchemaObject("table", name);
+}
+
+std::optional<bool> DatabaseService::IsView(const std::string& name) {
+  return HasSchemaObject("view", name);
+}
+
+std::optional<bool> DatabaseService::HasSchemaObject(const std::string& type,
+                                                     const std::string& name) {
+  DBStatement stmt(connection_->Get(),
+                   "SELECT COUNT(*) FROM sqlite_master WHERE type = ? AND name = ?;");
+  if (!stmt.IsValid()) {
+    return std::nullopt;
+  }
+
+  sqlite3_bind_text(stmt.Get(), 1, type.c_str(), -1, SQLITE_STATIC);
+  sqlite3_bind_text(stmt.Get(), 2, name.c_str(), -1, SQLITE_STATIC);
+  if (sqlite3_step(stmt.Get()) != SQLITE_ROW) {
+    spdlog::error("Failed to check {} existence: {}", type, sqlite3_errmsg(connection_->Get()));
+    return std::nullopt;
+  }
+
+  return sqlite3_column_int(stmt.Get(), 0) > 0;
+}
+
+std::optional<std::int64_t> DatabaseService::CountRows(const std::string& table) {
+  DBStatement stmt(connection_->Get(), "SELECT COUNT(*) FROM " + table + ";");
+  if (!stmt.IsValid() || sqlite3_step(stmt.Get()) != SQLITE_ROW) {
+    return std::nullopt;
+  }
+  return sqlite3_column_int64(stmt.Get(), 0);
+}
+
 }  // namespace duw
\ No newline at end of file
@@ -1,38 +1,158 @@
 #ifndef DATABASE_SERVICE_H
 #define DATABASE_SERVICE_H
 
+#include <cstddef>
+#include <cstdint>
+#include <map>
 #include <memory>
+#include <optional>
+#include <span>
 #include <string>
+#include <vector>
+
 #include "../data/db_connection.h"
+#include "../data/db_statement.h"
+#include "../data/db_transaction.h"
+#include "../data/dimension_table.h"
+#include "../data/storage_profile.h"
 
 namespace duw {
 
 struct TicketInfo {
-  int id;
   std::string city;
   std::string queue_status;
   int queue_length;
-  std::string timestamp;
+  std::int64_t timestamp_ms;
   std::string service_name;
   int service_id;
   int operations_count;
   int enabled_operations;
 };
 
+struct SampleRecord {
+  TicketInfo ticket;
+  std::optional<std::int64_t> valid_to_ms;
+};
+
+struct TicketChangeSet {
+  std::vector<TicketInfo> changed;
+  std::vector<std::string> vanished;
+  std::int64_t timestamp_ms = 0;
+  std::uint64_t sequence = 0;
+};
+
+struct SampleChanges {
+  std::vector<SampleRecord> records;
+  std::int64_t last_sequence = 0;
+};
+
+struct BatchSaveResult {
+  std::size_t saved_count = 0;
+  std::vector<std::size_t> failed_rows;
+  bool committed = false;
+};
+
+std::optional<std::string> RollupHistorySql(const std::string& resolution_name);
+
 class DatabaseService {
  public:
   DatabaseService();
   ~DatabaseService() = default;
 
   bool Initialize(const std::string& db_path);
+  bool Initialize(const std::string& db_path, const StorageProfile& profile);
+  bool CheckpointWal(CheckpointMode mode);
+  bool FlushToDisk();
   bool SaveTicketInfo(const TicketInfo& ticket);
+  BatchSaveResult SaveTicketInfoBatch(std::span<const TicketInfo> tickets);
+  BatchSaveResult SaveChangeSets(std::span<const TicketChangeSet> change_sets);
+  std::uint64_t LoadChangeSetSequence();
+  bool CloseTicketIntervals(std::span<const std::string> cities, std::int64_t timestamp_ms);
+  std::vector<TicketInfo> LoadOpenTickets();
+  bool HasPendingMigration() const { return legacy_rows_pending_; }
+  bool MigrateLegacyRows(int max_rows);
+  std::optional<std::vector<SampleRecord>> ReadSamplesChangedSince(std::int64_t watermark_ms);
+  std::optional<SampleChanges> ReadSampleChanges(std::int64_t after_sequence);
+  std::optional<std::int64_t> LatestChangeSequence();
+  bool PruneSampleChanges(std::int64_t through_sequence);
+  bool ApplySampleRecords(std::span<const SampleRecord> records);
+  bool MergeSampleRecords(std::span<const SampleRecord> records);
+  std::optional<std::int64_t> LatestChangeTimestamp();
+  std::optional<std::string> LoadSyncValue(const std::string& key);
+  bool SaveSyncValue(const std::string& key, const std::string& value);
+  bool BackfillRollups();
+  bool Vacuum();
+  bool ApplyRetention(int retention_months, const std::string& archive_dir);
 
  private:
+  using PartitionSql = std::string (*)(const std::string& table);
+
+  struct PartitionStatements {
+    std::unique_ptr<DBStatement> insert;
+    std::unique_ptr<DBStatement> apply;
+    std::unique_ptr<DBStatement> latest_before;
+    std::unique_ptr<DBStatement> close_interval;
+  };
+
   std::unique_ptr<DBConnection> connection_;
+  std::vector<int> partitions_;
+  int archived_before_ = 0;
+  std::map<int, PartitionStatements> partition_statements_;
+  std::unique_ptr<DBStatement> close_legacy_interval_statement_;
+  std::unique_ptr<DBStatement> reject_sample_statement_;
+  DimensionTable cities_;
+  DimensionTable services_;
+  DimensionTable statuses_;
+  bool legacy_rows_pending_ = false;
+  std::optional<std::int64_t> legacy_rows_remaining_;
 
   bool ExecuteQuery(const std::string& query);
   bool CreateTables();
   bool MigrateSchema();
+  bool UpgradeUnversionedSchema();
+  bool MigrateLegacyColumns();
+  std::optional<int> ReadSchemaVersion();
+  bool MigrateSamplesToPartitions();
+  bool EnableIncrementalVacuum();
+  bool CreateChangeLog();
+  bool UpgradeRollups();
+  bool UpgradeCompatibilityView(bool include_legacy_rows);
+  bool LoadPartitions();
+  bool EnsurePartition(int month);
+  bool RebuildSamplesView();
+  bool IsArchivedMonth(std::int64_t timestamp_ms) const;
+  int WritePartition(std::int64_t timestamp_ms);
+  bool ArchivePartition(int month, const std::string& archive_dir);
+  bool DropOldestPartition();
+  bool PrepareSchema();
+  std::optional<bool> IsTable(const std::string& name);
+  std::optional<bool> IsView(const std::string& name);
+  std::optional<bool> HasSchemaObject(const std::string& type, const std::string& name);
+  std::optional<bool> HasColumn(const std::string& table, const std::string& column);
+  std::optional<std::int64_t> CountRows(const std::string& table);
+  void ResetCachedStatements();
+  void ResetAfterRollback();
+  void ClearDimensionCaches();
+  DBStatement* GetCachedStatement(std::unique_ptr<DBStatement>& cached, const std::string& sql);
+  DBStatement* PartitionStatement(int month,
+                                  std::unique_ptr<DBStatement> PartitionStatements::*statement,
+                                  PartitionSql build_sql);
+  bool SaveTicketRows(std::span<const TicketInfo> tickets, std::size_t first_row,
+                      BatchSaveResult& result,
+                      std::optional<std::uint64_t> reject_sequence = std::nullopt);
+  bool RejectTicketRow(std::uint64_t sequence, const TicketInfo& ticket,
+                       const std::string& error);
+  BatchSaveResult CommitBatch(DBTransaction& transaction, BatchSaveResult result,
+                              std::size_t row_count);
+  int SaveTicketRow(const TicketInfo& ticket);
+  bool CloseOpenIntervals(std::span<const std::string> cities, std::int64_t timestamp_ms);
+  int InsertSample(DBStatement* stmt, const TicketInfo& ticket,
+                   std::optional<std::int64_t> valid_to_ms = std::nullopt);
+  int CloseOpenInterval(const std::string& city, std::int64_t timestamp_ms);
+  bool UpsertSampleRecords(std::span<const SampleRecord> records, bool close_earlier);
+  void ReadTickets(const std::string& sql, std::vector<TicketInfo>& tickets);
+  static SampleRecord ReadSampleRecord(sqlite3_stmt* stmt);
+  static TicketInfo ReadTicket(sqlite3_stmt* stmt);
 };
 
 }  // namespace duw
@@ -14,17 +14,93 @@ EnvServiceParams EnvService::GetParams() const {
     params.db_path = GetEnvVar("DB_PATH");
   }
   
+  if (HasEnvVar("DUW_URL")) {
+    params.duw_url = GetEnvVar("DUW_URL");
+  }
+
   if (HasEnvVar("GITHUB_REPO")) {
     params.github_repo = GetEnvVar("GITHUB_REPO");
   }
+
+  if (HasEnvVar("GITHUB_TOKEN")) {
+    params.github_token = GetEnvVar("GITHUB_TOKEN");
+  }
+  
+  if (HasEnvVar("GITHUB_SYNC_MODE")) {
+    params.github_sync_mode = GetEnvVar("GITHUB_SYNC_MODE");
+  }
   
-  if (HasEnvVar("POLLING_RATE_SECONDS")) {
-    auto value = GetEnvVar("POLLING_RATE_SECONDS");
-    auto [ptr, ec] = std::from_chars(value.data(), value.data() + value.size(), params.polling_rate_seconds);
-    
-    if (ec != std::errc{} || ptr != value.data() + value.size()) {
-      Panic("Environment variable 'POLLING_RATE_SECONDS' has invalid integer value: " + value);
-    }
+  if (HasEnvVar("DB_STORAGE_PROFILE")) {
+    params.storage_profile = GetEnvVar("DB_STORAGE_PROFILE");
+  }
+
+  if (HasEnvVar("POLLING_OVERRUN_POLICY")) {
+    params.polling_overrun_policy = GetEnvVar("POLLING_OVERRUN_POLICY");
+  }
+
+  ReadIntVar("POLLING_RATE_SECONDS", params.polling_rate_seconds);
+  ReadIntVar("GITHUB_SYNC_MAX_SEGMENTS", params.github_sync_max_segments);
+  ReadIntVar("GITHUB_SYNC_INTERVAL_SECONDS", params.github_sync_interval_seconds);
+  ReadBoolVar("GITHUB_BACKGROUND_BOOTSTRAP", params.github_background_bootstrap);
+  ReadIntVar("GITHUB_DOWNLOAD_TIMEOUT_SECONDS", params.github_download_timeout_seconds);
+  ReadIntVar("SNAPSHOT_PAGES_PER_STEP", params.snapshot_pages_per_step);
+  ReadIntVar("SNAPSHOT_STEP_PAUSE_MS", params.snapshot_step_pause_ms);
+  ReadIntVar("POLLING_INTERVAL_MS", params.polling_interval_ms);
+  ReadIntVar("POLLING_JITTER_MS", params.polling_jitter_ms);
+  ReadBoolVar("POLLING_ADAPTIVE", params.polling_adaptive);
+  ReadIntVar("POLLING_MIN_INTERVAL_MS", params.polling_min_interval_ms);
+  ReadIntVar("POLLING_MAX_INTERVAL_MS", params.polling_max_interval_ms);
+  ReadIntVar("POLLING_BACKOFF_MAX_MS", params.polling_backoff_max_ms);
+  ReadIntVar("POLLING_CIRCUIT_FAILURES", params.polling_circuit_failures);
+  ReadIntVar("POLLING_SPIKE_QUEUE_CHANGE", params.polling_spike_queue_change);
+  ReadIntVar("WAL_CHECKPOINT_INTERVAL_SECONDS", params.wal_checkpoint_interval_seconds);
+  ReadIntVar("HTTP_CONNECT_TIMEOUT_MS", params.http_connect_timeout_ms);
+  ReadIntVar("HTTP_READ_TIMEOUT_MS", params.http_read_timeout_ms);
+  ReadIntVar("HTTP_TOTAL_TIMEOUT_MS", params.http_total_timeout_ms);
+  ReadBoolVar("HTTP_COMPRESS_REQUESTS", params.http_compress_requests);
+  ReadBoolVar("PIPELINE_ENABLED", params.pipeline_enabled);
+  ReadIntVar("PIPELINE_QUEUE_CAPACITY", params.pipeline_queue_capacity);
+
+  if (HasEnvVar("PIPELINE_OVERFLOW_POLICY")) {
+    params.pipeline_overflow_policy = GetEnvVar("PIPELINE_OVERFLOW_POLICY");
+  }
+
+  if (HasEnvVar("COLLECTION_TARGETS")) {
+    params.collection_targets = GetEnvVar("COLLECTION_TARGETS");
+  }
+  ReadIntVar("FETCH_WORKERS", params.fetch_workers);
+
+  if (HasEnvVar("READ_API_HOST")) {
+    params.read_api_host = GetEnvVar("READ_API_HOST");
+  }
+  ReadIntVar("READ_API_PORT", params.read_api_port);
+  ReadIntVar("READ_API_MAX_ROWS", params.read_api_max_rows);
+  ReadIntVar("READ_API_MAX_RANGE_HOURS", params.read_api_max_range_hours);
+
+  if (HasEnvVar("METRICS_HOST")) {
+    params.metrics_host = GetEnvVar("METRICS_HOST");
+  }
+  ReadIntVar("METRICS_PORT", params.metrics_port);
+
+  if (HasEnvVar("CAPTURE_PATH")) {
+    params.capture_path = GetEnvVar("CAPTURE_PATH");
+  }
+  if (HasEnvVar("REPLAY_PATH")) {
+    params.replay_path = GetEnvVar("REPLAY_PATH");
+  }
+  if (HasEnvVar("REPLAY_TIMING")) {
+    params.replay_timing = GetEnvVar("REPLAY_TIMING");
+  }
+  ReadIntVar("REPLAY_MAX_ALLOCATIONS", params.replay_max_allocations);
+
+  ReadIntVar("RETENTION_MONTHS", params.retention_months);
+  if (HasEnvVar("ARCHIVE_DIR")) {
+    params.archive_dir = GetEnvVar("ARCHIVE_DIR");
+  }
+
+  ReadBoolVar("SPOOL_ENABLED", params.spool_enabled);
+  if (HasEnvVar("SPOOL_PATH")) {
+    params.spool_path = GetEnvVar("SPOOL_PATH");
   }
   
   return params;
@@ -66,9 +142,37 @@ bool EnvService::HasEnvVar(const std::string& name) {
   return std::getenv(name.c_str()) != nullptr;
 }
 
+void EnvService::ReadIntVar(const std::string& name, int& value) {
+  if (!HasEnvVar(name)) {
+    return;
+  }
+
+  auto text = GetEnvVar(name);
+  auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+
+  if (ec != std::errc{} || ptr != text.data() + text.size()) {
+    Panic("Environment variable '" + name + "' has invalid integer value: " + text);
+  }
+}
+
 void EnvService::ExitWithError(const std::string& message) {
   spdlog::critical("{}", message);
   std::exit(1);
 }
 
+void EnvService::ReadBoolVar(const std::string& name, bool& value) {
+  if (!HasEnvVar(name)) {
+    return;
+  }
+
+  auto text = GetEnvVar(name);
+  if (text == "1" || text == "true") {
+    value = true;
+  } else if (text == "0" || text == "false") {
+    value = false;
+  } else {
+    Panic("Environment variable '" + name + "' has invalid boolean value: " + text);
+  }
+}
+
 }  // namespace duw
\ No newline at end of file
@@ -7,8 +7,51 @@ namespace duw {
 
 struct EnvServiceParams {
   std::string db_path = "duw_data.db";
+  std::string duw_url = "https://rezerwacje.duw.pl/status_kolejek/query.php?status";
   std::string github_repo = "";
+  std::string github_token = "";
+  std::string github_sync_mode = "full";
+  int github_sync_max_segments = 96;
+  int github_sync_interval_seconds = 0;
+  bool github_background_bootstrap = true;
+  int github_download_timeout_seconds = 600;
+  int snapshot_pages_per_step = 256;
+  int snapshot_step_pause_ms = 10;
   int polling_rate_seconds = 5;
+  int polling_interval_ms = 0;
+  int polling_jitter_ms = 0;
+  std::string polling_overrun_policy = "skip";
+  bool polling_adaptive = false;
+  int polling_min_interval_ms = 2000;
+  int polling_max_interval_ms = 60000;
+  int polling_backoff_max_ms = 300000;
+  int polling_circuit_failures = 5;
+  int polling_spike_queue_change = 10;
+  std::string storage_profile = "balanced";
+  int wal_checkpoint_interval_seconds = 60;
+  int http_connect_timeout_ms = 5000;
+  int http_read_timeout_ms = 10000;
+  int http_total_timeout_ms = 15000;
+  bool http_compress_requests = false;
+  bool pipeline_enabled = false;
+  int pipeline_queue_capacity = 16;
+  std::string pipeline_overflow_policy = "drop_oldest";
+  std::string collection_targets = "";
+  int fetch_workers = 4;
+  std::string read_api_host = "127.0.0.1";
+  int read_api_port = 0;
+  int read_api_max_rows = 5000;
+  int read_api_max_range_hours = 168;
+  std::string metrics_host = "127.0.0.1";
+  int metrics_port = 0;
+  std::string capture_path = "";
+  std::string replay_path = "";
+  std::string replay_timing = "fast";
+  int replay_max_allocations = -1;
+  int retention_months = 0;
+  std::string archive_dir = "archive";
+  bool spool_enabled = true;
+  std::string spool_path = "";
 };
 
 class EnvService {
@@ -25,6 +68,8 @@ class EnvService {
  private:
   static std::string GetEnvVar(const std::string& name);
   static bool HasEnvVar(const std::string& name);
+  static void ReadIntVar(const std::string& name, int& value);
+  static void ReadBoolVar(const std::string& name, bool& value);
   static void ExitWithError(const std::string& message);
 };
 
@@ -1,14 +1,140 @@
 #include "github_service.h"
 
+#include <cstdint>
+#include <filesystem>
 #include <fstream>
-#include <sstream>
+#include <functional>
 
+#include <nlohmann/json.hpp>
+#include <openssl/evp.h>
 #include <spdlog/spdlog.h>
 
 #include "http_client.h"
+#include "../util/base64.h"
+#include "../util/file_sync.h"
+#include "../util/metrics.h"
 
 namespace duw {
 
+namespace {
+
+constexpr std::size_t UPLOAD_CHUNK_BYTES = 3 * 64 * 1024;
+constexpr std::size_t HASH_CHUNK_BYTES = 1024 * 1024;
+constexpr int HTTP_OK = 200;
+constexpr int HTTP_PARTIAL_CONTENT = 206;
+constexpr char PART_SUFFIX[] = ".part";
+constexpr char PART_SHA_SUFFIX[] = ".part.sha";
+
+struct ContentsPath {
+  std::string url;
+  std::string branch;
+};
+
+struct RemoteFileInfo {
+  std::string sha;
+  std::uintmax_t size = 0;
+};
+
+class BlobHasher {
+ public:
+  explicit BlobHasher(std::uintmax_t size)
+      : context_(EVP_MD_CTX_new(), EVP_MD_CTX_free) {
+    std::string header = "blob " + std::to_string(size);
+    header.push_back('\0');
+    ok_ = context_ != nullptr && EVP_DigestInit_ex(context_.get(), EVP_sha1(), nullptr) == 1;
+    Update(header);
+  }
+
+  void Update(std::string_view data) {
+    ok_ = ok_ && EVP_DigestUpdate(context_.get(), data.data(), data.size()) == 1;
+  }
+
+  std::string Finish() {
+    unsigned char digest[EVP_MAX_MD_SIZE];
+    unsigned int digest_size = 0;
+    if (!ok_ || EVP_DigestFinal_ex(context_.get(), digest, &digest_size) != 1) {
+      return "";
+    }
+
+    constexpr char HEX_DIGITS[] = "0123456789abcdef";
+    std::string sha;
+    sha.reserve(digest_size * 2);
+    for (unsigned int i = 0; i < digest_size; ++i) {
+      sha.push_back(HEX_DIGITS[digest[i] >> 4]);
+      sha.push_back(HEX_DIGITS[digest[i] & 0x0F]);
+    }
+    return sha;
+  }
+
+ private:
+  std::unique_ptr<EVP_MD_CTX, void (*)(EVP_MD_CTX*)> context_;
+  bool ok_ = false;
+};
+
+std::string FileBlobSha(const std::filesystem::path& path) {
+  std::error_code error;
+  auto size = std::filesystem::file_size(path, error);
+  std::ifstream file(path, std::ios::binary);
+  if (error || !file.is_open()) {
+    return "";
+  }
+
+  BlobHasher hasher(size);
+  std::string buffer(HASH_CHUNK_BYTES, '\0');
+  std::uintmax_t hashed = 0;
+  while (file.read(buffer.data(), static_cast<std::streamsize>(buffer.size())) || file.gcount() > 0) {
+    auto count = static_cast<std::size_t>(file.gcount());
+    hasher.Update(std::string_view(buffer.data(), count));
+    hashed += count;
+  }
+  return hashed == size && !file.bad() ? hasher.Finish() : "";
+}
+
+std::string ReadSmallFile(const std::filesystem::path& path) {
+  std::ifstream file(path);
+  std::string content;
+  std::getline(file, content);
+  return content;
+}
+
+std::optional<ContentsPath> ParseContentsPath(const std::string& repo_path) {
+  std::size_t owner_end = repo_path.find('/');
+  std::size_t repo_end = owner_end == std::string::npos ? owner_end : repo_path.find('/', owner_end + 1);
+  std::size_t branch_end = repo_end == std::string::npos ? repo_end : repo_path.find('/', repo_end + 1);
+  if (branch_end == std::string::npos) {
+    return std::nullopt;
+  }
+
+  return ContentsPath{.url = "https://api.github.com/repos/" + repo_path.substr(0, repo_end) +
+                             "/contents/" + repo_path.substr(branch_end + 1),
+                      .branch = repo_path.substr(repo_end + 1, branch_end - repo_end - 1)};
+}
+
+std::string BuildContentsUrl(const std::string& repo_path) {
+  auto contents = ParseContentsPath(repo_path);
+  return contents.has_value() ? contents->url + "?ref=" + contents->branch : "";
+}
+
+bool TrackGitHubCall(const char* operation, const std::function<bool()>& call) {
+  auto& registry = MetricsRegistry::Get();
+  bool succeeded = false;
+  {
+    ScopedTimer timer(registry.GetHistogram("duw_github_request_duration_seconds",
+                                            "Duration of GitHub sync operations",
+                                            {{"operation", operation}}));
+    succeeded = call();
+  }
+  if (!succeeded) {
+    registry
+        .GetCounter("duw_github_failures_total", "Failed GitHub sync operations",
+                    {{"operation", operation}})
+        .Increment();
+  }
+  return succeeded;
+}
+
+}  // anonymous namespace
+
 class GitHubServiceImpl : public GitHubService {
  public:
   explicit GitHubServiceImpl(std::unique_ptr<HttpClient> http_client);
@@ -19,13 +145,27 @@ class GitHubServiceImpl : public GitHubService {
   bool PushDatabase(const std::string& repo_path,
                    const std::string& local_path,
                    const std::string& commit_message) override;
+  std::optional<std::string> FetchFile(const std::string& repo_path) override;
+  bool PushFile(const std::string& repo_path,
+                const std::string& content,
+                const std::string& commit_message,
+                const std::string& previous_sha) override;
 
  private:
   std::unique_ptr<HttpClient> http_client_;
+  bool DownloadDatabase(const std::string& repo_path, const std::string& local_path);
+  bool UploadDatabase(const std::string& repo_path,
+                      const std::string& local_path,
+                      const std::string& commit_message);
+  bool UploadFile(const std::string& repo_path,
+                  const std::string& content,
+                  const std::string& commit_message,
+                  const std::string& previous_sha);
   std::string BuildRawUrl(const std::string& repo_path);
-  bool WriteFile(const std::string& path, const std::string& content);
-  std::string ReadFile(const std::string& path);
-  std::string EncodeBase64(const std::string& data);
+  std::optional<RemoteFileInfo> FetchRemoteInfo(const std::string& repo_path);
+  bool DownloadPart(const std::string& url,
+                    const std::filesystem::path& part_path,
+                    std::uintmax_t offset);
 };
 
 GitHubServiceImpl::GitHubServiceImpl(std::unique_ptr<HttpClient> http_client)
@@ -33,100 +173,251 @@ GitHubServiceImpl::GitHubServiceImpl(std::unique_ptr<HttpClient> http_client)
 
 bool GitHubServiceImpl::FetchDatabase(const std::string& repo_path, 
                                      const std::string& local_path) {
-  std::string url = BuildRawUrl(repo_path);
-  std::string content = http_client_->Get(url);
-  
-  if (content.empty()) {
-    spdlog::error("Failed to fetch database from GitHub");
-    return false;
-  }
-  
-  return WriteFile(local_path, content);
+  return TrackGitHubCall("fetch_database",
+                         [&] { return DownloadDatabase(repo_path, local_path); });
 }
 
 bool GitHubServiceImpl::PushDatabase(const std::string& repo_path,
                                    const std::string& local_path,
                                    const std::string& commit_message) {
-  std::string content = ReadFile(local_path);
-  if (content.empty()) {
-    spdlog::error("Failed to read local database file");
+  return TrackGitHubCall("push_database", [&] {
+    return UploadDatabase(repo_path, local_path, commit_message);
+  });
+}
+
+std::optional<std::string> GitHubServiceImpl::FetchFile(const std::string& repo_path) {
+  std::string content;
+  bool fetched = TrackGitHubCall("fetch_file", [&] {
+    content = http_client_->Get(BuildRawUrl(repo_path));
+    return !content.empty();
+  });
+  if (!fetched) {
+    return std::nullopt;
+  }
+  return content;
+}
+
+bool GitHubServiceImpl::PushFile(const std::string& repo_path,
+                                 const std::string& content,
+                                 const std::string& commit_message,
+                                 const std::string& previous_sha) {
+  return TrackGitHubCall("push_file", [&] {
+    return UploadFile(repo_path, content, commit_message, previous_sha);
+  });
+}
+
+bool GitHubServiceImpl::DownloadDatabase(const std::string& repo_path,
+                                         const std::string& local_path) {
+  namespace fs = std::filesystem;
+  auto remote = FetchRemoteInfo(repo_path);
+  if (remote.has_value() && FileBlobSha(local_path) == remote->sha) {
+    spdlog::info("Local database already matches GitHub revision {}", remote->sha);
+    return true;
+  }
+
+  fs::path part_path = local_path + PART_SUFFIX;
+  fs::path part_sha_path = local_path + PART_SHA_SUFFIX;
+  std::error_code error;
+  std::uintmax_t offset = 0;
+  if (remote.has_value() && ReadSmallFile(part_sha_path) == remote->sha) {
+    offset = fs::file_size(part_path, error);
+    if (error || offset >= remote->size) {
+      offset = 0;
+    }
+  }
+
+  if (offset == 0) {
+    fs::remove(part_path, error);
+    fs::remove(part_sha_path, error);
+    if (remote.has_value()) {
+      std::ofstream(part_sha_path) << remote->sha << '\n';
+    }
+  } else {
+    spdlog::info("Resuming database download at byte {} of {}", offset, remote->size);
+  }
+
+  if (!DownloadPart(BuildRawUrl(repo_path), part_path, offset)) {
+    spdlog::error("Failed to fetch database from GitHub");
     return false;
   }
-  
-  std::string api_url = "https://api.github.com/repos/" + repo_path;
-  std::string json_payload = R"({"message":")" + commit_message + R"(","content":")" + 
-                            EncodeBase64(content) + R"("})";
-  
-  std::string response = http_client_->Put(api_url, json_payload);
-  
-  if (response.empty()) {
-    spdlog::error("Failed to push database to GitHub");
+
+  auto size = fs::file_size(part_path, error);
+  if (error || size == 0 ||
+      (remote.has_value() && (size != remote->size || FileBlobSha(part_path) != remote->sha))) {
+    spdlog::error("Downloaded database failed verification, discarding {}", part_path.string());
+    fs::remove(part_path, error);
+    fs::remove(part_sha_path, error);
     return false;
   }
-  
-  spdlog::info("Successfully pushed database to GitHub");
+
+  if (!SyncToDisk(part_path)) {
+    spdlog::error("Failed to sync downloaded database: {}", part_path.string());
+    return false;
+  }
+
+  fs::remove(local_path + "-wal", error);
+  fs::remove(local_path + "-shm", error);
+  fs::rename(part_path, local_path, error);
+  if (error) {
+    spdlog::error("Failed to replace {}: {}", local_path, error.message());
+    return false;
+  }
+  fs::remove(part_sha_path, error);
+  SyncToDisk(fs::absolute(local_path).parent_path());
+
+  spdlog::info("Fetched database from GitHub ({} bytes)", size);
   return true;
 }
 
-std::string GitHubServiceImpl::BuildRawUrl(const std::string& repo_path) {
-  return "https://raw.githubusercontent.com/" + repo_path;
+std::optional<RemoteFileInfo> GitHubServiceImpl::FetchRemoteInfo(const std::string& repo_path) {
+  std::string url = BuildContentsUrl(repo_path);
+  std::string body = url.empty() ? "" : http_client_->Get(url);
+  auto metadata = nlohmann::json::parse(body, nullptr, false);
+  if (metadata.is_discarded() || !metadata.is_object() ||
+      !metadata.contains("sha") || !metadata["sha"].is_string() ||
+      !metadata.contains("size") || !metadata["size"].is_number_unsigned()) {
+    spdlog::warn("No GitHub metadata for {}, download will not be verified", repo_path);
+    return std::nullopt;
+  }
+
+  return RemoteFileInfo{.sha = metadata["sha"].get<std::string>(),
+                        .size = metadata["size"].get<std::uintmax_t>()};
 }
 
-bool GitHubServiceImpl::WriteFile(const std::string& path, const std::string& content) {
-  std::ofstream file(path, std::ios::binary);
-  if (!file.is_open()) {
-    spdlog::error("Failed to open file for writing: {}", path);
-    return false;
+bool GitHubServiceImpl::DownloadPart(const std::string& url,
+                                     const std::filesystem::path& part_path,
+                                     std::uintmax_t offset) {
+  httplib::Headers headers;
+  if (offset > 0) {
+    headers.emplace("Range", "bytes=" + std::to_string(offset) + "-");
   }
-  
-  file << content;
+
+  std::ofstream file;
+  auto on_response = [&file, &part_path, offset](const httplib::Response& response) {
+    std::string expected_range = "bytes " + std::to_string(offset) + "-";
+    if (offset > 0 && response.status == HTTP_PARTIAL_CONTENT &&
+        response.get_header_value("Content-Range").starts_with(expected_range)) {
+      file.open(part_path, std::ios::binary | std::ios::app);
+    } else if (response.status == HTTP_OK) {
+      file.open(part_path, std::ios::binary | std::ios::trunc);
+    } else {
+      spdlog::error("Unexpected HTTP status {} for database download", response.status);
+      return false;
+    }
+    return file.is_open();
+  };
+  auto on_content = [&file](const char* data, std::size_t length) {
+    file.write(data, static_cast<std::streamsize>(length));
+    return file.good();
+  };
+
+  int status = http_client_->Download(url, headers, on_response, on_content);
   file.close();
-  
-  if (file.fail()) {
-    spdlog::error("Failed to write to file: {}", path);
+  if (status == 0 || file.fail()) {
+    spdlog::warn("Database download interrupted, partial data kept in {}", part_path.string());
     return false;
   }
-  
   return true;
 }
 
-std::string GitHubServiceImpl::ReadFile(const std::string& path) {
-  std::ifstream file(path, std::ios::binary);
-  if (!file.is_open()) {
-    spdlog::error("Failed to open file for reading: {}", path);
-    return "";
+bool GitHubServiceImpl::UploadDatabase(const std::string& repo_path,
+                                       const std::string& local_path,
+                                       const std::string& commit_message) {
+  auto file = std::make_shared<std::ifstream>(local_path, std::ios::binary | std::ios::ate);
+  if (!file->is_open()) {
+    spdlog::error("Failed to read local database file");
+    return false;
   }
-  
-  std::stringstream buffer;
-  buffer << file.rdbuf();
-  file.close();
-  
-  return buffer.str();
-}
 
-std::string GitHubServiceImpl::EncodeBase64(const std::string& data) {
-  const char* chars = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
-  std::string result;
-  int val = 0, valb = -6;
-  
-  for (unsigned char c : data) {
-    val = (val << 8) + c;
-    valb += 8;
-    while (valb >= 0) {
-      result.push_back(chars[(val >> valb) & 0x3F]);
-      valb -= 6;
+  auto file_size = static_cast<std::size_t>(file->tellg());
+  file->seekg(0);
+  if (file_size == 0) {
+    spdlog::error("Local database file is empty");
+    return false;
+  }
+
+  auto contents = ParseContentsPath(repo_path);
+  if (!contents.has_value()) {
+    spdlog::error("GitHub path {} has no owner/repo/branch/file form", repo_path);
+    return false;
+  }
+
+  nlohmann::json fields = {{"message", commit_message}, {"branch", contents->branch}};
+  auto remote = FetchRemoteInfo(repo_path);
+  if (remote.has_value()) {
+    fields["sha"] = remote->sha;
+  }
+  std::string prefix = fields.dump();
+  prefix.back() = ',';
+  prefix += R"("content":")";
+  std::string suffix = R"("})";
+  std::size_t content_length = prefix.size() + Base64EncodedSize(file_size) + suffix.size();
+
+  auto encoder = std::make_shared<Base64Encoder>();
+  auto provider = [file, encoder, prefix, suffix, content_length](
+                      std::size_t offset, std::size_t, httplib::DataSink& sink) {
+    std::string chunk;
+    if (offset == 0) {
+      chunk = prefix;
+    }
+
+    std::string buffer(UPLOAD_CHUNK_BYTES, '\0');
+    file->read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+    encoder->Update(std::string_view(buffer.data(), static_cast<std::size_t>(file->gcount())),
+                    chunk);
+    if (file->eof()) {
+      encoder->Finish(chunk);
+      chunk += suffix;
     }
+
+    if (offset + chunk.size() > content_length || file->bad()) {
+      return false;
+    }
+    return sink.write(chunk.data(), chunk.size());
+  };
+
+  if (http_client_->Put(contents->url, content_length, std::move(provider)).empty()) {
+    spdlog::error("Failed to push database to GitHub");
+    return false;
   }
   
-  if (valb > -6) {
-    result.push_back(chars[((val << 8) >> (valb + 8)) & 0x3F]);
+  spdlog::info("Successfully pushed database to GitHub");
+  return true;
+}
+
+bool GitHubServiceImpl::UploadFile(const std::string& repo_path,
+                                   const std::string& content,
+                                   const std::string& commit_message,
+                                   const std::string& previous_sha) {
+  auto contents = ParseContentsPath(repo_path);
+  if (!contents.has_value()) {
+    spdlog::error("GitHub path {} has no owner/repo/branch/file form", repo_path);
+    return false;
   }
-  
-  while (result.size() % 4) {
-    result.push_back('=');
+
+  nlohmann::json payload = {{"message", commit_message},
+                            {"branch", contents->branch},
+                            {"content", Base64Encode(content)}};
+  if (!previous_sha.empty()) {
+    payload["sha"] = previous_sha;
   }
-  
-  return result;
+
+  std::string response = http_client_->Put(contents->url, payload.dump());
+  if (response.empty()) {
+    spdlog::error("Failed to push {} to GitHub", repo_path);
+    return false;
+  }
+  return true;
+}
+
+std::string GitHubServiceImpl::BuildRawUrl(const std::string& repo_path) {
+  return "https://raw.githubusercontent.com/" + repo_path;
+}
+
+std::string GitBlobSha(std::string_view content) {
+  BlobHasher hasher(content.size());
+  hasher.Update(content);
+  return hasher.Finish();
 }
 
 std::unique_ptr<GitHubService> CreateGitHubService(std::unique_ptr<HttpClient> http_client) {
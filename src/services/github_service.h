@@ -2,7 +2,9 @@
 #define GITHUB_SERVICE_H
 
 #include <memory>
+#include <optional>
 #include <string>
+#include <string_view>
 
 namespace duw {
 
@@ -17,8 +19,15 @@ class GitHubService {
   virtual bool PushDatabase(const std::string& repo_path,
                            const std::string& local_path,
                            const std::string& commit_message) = 0;
+  virtual std::optional<std::string> FetchFile(const std::string& repo_path) = 0;
+  virtual bool PushFile(const std::string& repo_path,
+                        const std::string& content,
+                        const std::string& commit_message,
+                        const std::string& previous_sha) = 0;
 };
 
+std::string GitBlobSha(std::string_view content);
+
 std::unique_ptr<GitHubService> CreateGitHubService(std::unique_ptr<HttpClient> http_client);
 
 }  // namespace duw
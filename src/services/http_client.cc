@@ -1,61 +1,312 @@
 #include "http_client.h"
 
+#include <algorithm>
+#include <optional>
+
 #include <spdlog/spdlog.h>
 
+#include "../util/gzip.h"
+#include "../util/metrics.h"
+
 namespace duw {
 
-HttpClient::HttpClient() {
-  // Constructor - no initialization needed since we create clients per request
-}
+namespace {
 
-std::string HttpClient::Get(const std::string& url) {
-  httplib::Client cli(url);
-  auto res = cli.Get("/");
-  return res ? res->body : "";
-}
+constexpr int HTTP_OK = 200;
+constexpr int HTTP_CREATED = 201;
+constexpr int HTTP_NOT_MODIFIED = 304;
+constexpr int HTTP_UNSUPPORTED_MEDIA_TYPE = 415;
+constexpr std::size_t COMPRESS_MIN_BYTES = 1024;
 
-std::string HttpClient::Put(const std::string& url, const std::string& data) {
-  std::string response;
-  
-  // Parse URL to extract host and path
+struct ParsedUrl {
+  std::string scheme_host;
+  std::string path;
+};
+
+std::optional<ParsedUrl> ParseUrl(const std::string& url) {
   size_t protocol_end = url.find("://");
   if (protocol_end == std::string::npos) {
     spdlog::error("Invalid URL format: {}", url);
-    return response;
+    return std::nullopt;
   }
-  
-  std::string protocol = url.substr(0, protocol_end);
+
   size_t host_start = protocol_end + 3;
   size_t path_start = url.find('/', host_start);
-  
-  std::string host = url.substr(host_start, path_start - host_start);
-  std::string path = (path_start == std::string::npos) ? "/" : url.substr(path_start);
-  
-  // Create a new client for this specific host
-  httplib::Client cli(protocol == "https" ? "https://" + host : host);
-  cli.set_read_timeout(30);
-  cli.set_write_timeout(30);
-  cli.set_connection_timeout(10);
-  cli.enable_server_certificate_verification(true);
-  cli.set_follow_location(true);
-  
-  // Set User-Agent to avoid potential blocking
-  cli.set_default_headers({
-    {"User-Agent", "duw-collector/1.0"}
-  });
-  
-  auto res = cli.Put(path, data, "application/json");
+
+  return ParsedUrl{
+      .scheme_host = url.substr(0, path_start),
+      .path = (path_start == std::string::npos) ? "/" : url.substr(path_start)};
+}
+
+Counter& ReceivedBytes() {
+  static Counter& counter = MetricsRegistry::Get().GetCounter(
+      "duw_http_received_bytes_total", "HTTP response body bytes received");
+  return counter;
+}
+
+Counter& SentBytes() {
+  static Counter& counter = MetricsRegistry::Get().GetCounter(
+      "duw_http_sent_bytes_total", "HTTP request body bytes sent");
+  return counter;
+}
+
+Counter& DecodedBytes() {
+  static Counter& counter = MetricsRegistry::Get().GetCounter(
+      "duw_http_decoded_bytes_total", "HTTP response body bytes after content decoding");
+  return counter;
+}
+
+Histogram& ResponseWireBytes() {
+  static Histogram& histogram = MetricsRegistry::Get().GetHistogram(
+      "duw_http_response_wire_bytes", "HTTP response body bytes on the wire per request", {},
+      {1024, 4096, 16384, 65536, 262144, 1048576, 4194304});
+  return histogram;
+}
+
+Histogram& DecompressDuration() {
+  static Histogram& histogram = MetricsRegistry::Get().GetHistogram(
+      "duw_http_decompress_duration_seconds", "Time to decode one compressed HTTP response body");
+  return histogram;
+}
+
+Counter& RequestFailures() {
+  static Counter& counter = MetricsRegistry::Get().GetCounter(
+      "duw_http_request_failures_total", "HTTP requests that failed or returned an error status");
+  return counter;
+}
+
+}  // anonymous namespace
+
+HttpClient::HttpClient() : HttpClient(HttpClientOptions{}) {}
+
+HttpClient::HttpClient(HttpClientOptions options)
+    : options_(options), decoder_(std::make_unique<ContentDecoder>()) {}
+
+std::string HttpClient::Get(const std::string& url) {
+  auto result = Fetch(url, {});
+  return result.status == FetchStatus::FETCH_OK ? std::move(result.body) : "";
+}
+
+FetchResult HttpClient::GetIfModified(const std::string& url) {
+  httplib::Headers headers;
+  {
+    std::lock_guard lock(validators_mutex_);
+    const auto& validators = validators_[url];
+    if (!validators.etag.empty()) {
+      headers.emplace("If-None-Match", validators.etag);
+    }
+    if (!validators.last_modified.empty()) {
+      headers.emplace("If-Modified-Since", validators.last_modified);
+    }
+  }
+
+  return Fetch(url, headers);
+}
+
+void HttpClient::CommitValidators(const std::string& url, CacheValidators validators) {
+  std::lock_guard lock(validators_mutex_);
+  validators_[url] = std::move(validators);
+}
+
+std::string HttpClient::Put(const std::string& url, const std::string& data) {
+  auto parsed = ParseUrl(url);
+  if (!parsed.has_value()) {
+    return "";
+  }
+
+  auto& client = GetClient(parsed->scheme_host);
+  if (options_.compress_requests && data.size() >= COMPRESS_MIN_BYTES &&
+      !uncompressed_hosts_.contains(parsed->scheme_host)) {
+    auto compressed = GzipCompress(data);
+    if (compressed.has_value()) {
+      auto res = client.Put(parsed->path, {{"Content-Encoding", "gzip"}}, *compressed,
+                            "application/json");
+      SentBytes().Increment(compressed->size());
+      if (!res || res->status != HTTP_UNSUPPORTED_MEDIA_TYPE) {
+        return PutResponseBody(url, res);
+      }
+      spdlog::warn("{} rejected a gzip request body, sending it uncompressed",
+                   parsed->scheme_host);
+      uncompressed_hosts_.insert(parsed->scheme_host);
+    }
+  }
+
+  auto res = client.Put(parsed->path, data, "application/json");
+  SentBytes().Increment(data.size());
+  return PutResponseBody(url, res);
+}
+
+std::string HttpClient::Put(const std::string& url,
+                            std::size_t content_length,
+                            httplib::ContentProvider content_provider) {
+  auto parsed = ParseUrl(url);
+  if (!parsed.has_value()) {
+    return "";
+  }
+
+  auto res = GetClient(parsed->scheme_host)
+                 .Put(parsed->path, content_length, std::move(content_provider),
+                      "application/json");
+  SentBytes().Increment(content_length);
+  return PutResponseBody(url, res);
+}
+
+int HttpClient::Download(const std::string& url,
+                         const httplib::Headers& headers,
+                         httplib::ResponseHandler response_handler,
+                         httplib::ContentReceiver content_receiver) {
+  auto parsed = ParseUrl(url);
+  if (!parsed.has_value()) {
+    return 0;
+  }
+
+  auto counting_receiver = [receiver = std::move(content_receiver)](const char* data,
+                                                                     std::size_t length) {
+    ReceivedBytes().Increment(length);
+    return receiver(data, length);
+  };
+  auto identity_headers = headers;
+  if (!identity_headers.contains("Accept-Encoding")) {
+    identity_headers.emplace("Accept-Encoding", "identity");
+  }
+  auto& client = GetClient(parsed->scheme_host);
+  auto res = client.Get(parsed->path, identity_headers, std::move(response_handler),
+                        std::move(counting_receiver), StartTotalTimeout(client));
   if (!res) {
-    spdlog::error("HTTP PUT request failed for URL: {} - Error: {}", url, static_cast<int>(res.error()));
-    return response;
+    RequestFailures().Increment();
+    spdlog::error("HTTP download failed for URL: {} - Error: {}", url, static_cast<int>(res.error()));
+    return 0;
   }
-  
-  if (res->status != 200) {
-    spdlog::error("HTTP PUT error: {} for URL: {}", res->status, url);
-    return response;
+  return res->status;
+}
+
+std::string HttpClient::PutResponseBody(const std::string& url, httplib::Result& result) {
+  if (!result) {
+    RequestFailures().Increment();
+    spdlog::error("HTTP PUT request failed for URL: {} - Error: {}", url,
+                  static_cast<int>(result.error()));
+    return "";
+  }
+
+  if (result->status != HTTP_OK && result->status != HTTP_CREATED) {
+    RequestFailures().Increment();
+    spdlog::error("HTTP PUT error: {} for URL: {}", result->status, url);
+    return "";
+  }
+
+  std::string body;
+  if (!DecodeBody(url, *result, body)) {
+    return "";
+  }
+  return body;
+}
+
+httplib::Client& HttpClient::GetClient(const std::string& scheme_host) {
+  auto& client = clients_[scheme_host];
+  if (client != nullptr) {
+    client->set_connection_timeout(options_.connect_timeout);
+    client->set_read_timeout(options_.read_timeout);
+    client->set_write_timeout(options_.write_timeout);
+    return *client;
+  }
+
+  client = std::make_unique<httplib::Client>(scheme_host);
+  client->set_keep_alive(true);
+  client->set_connection_timeout(options_.connect_timeout);
+  client->set_read_timeout(options_.read_timeout);
+  client->set_write_timeout(options_.write_timeout);
+  client->enable_server_certificate_verification(true);
+  client->set_follow_location(true);
+  client->set_decompress(false);
+  httplib::Headers default_headers = {
+    {"User-Agent", "duw-collector/1.0"},
+    {"Accept-Encoding", AcceptedContentEncodings()}
+  };
+  if (!options_.authorization.empty()) {
+    default_headers.emplace("Authorization", options_.authorization);
+  }
+  client->set_default_headers(std::move(default_headers));
+  return *client;
+}
+
+FetchResult HttpClient::Fetch(const std::string& url, const httplib::Headers& headers) {
+  FetchResult result;
+  auto parsed = ParseUrl(url);
+  if (!parsed.has_value()) {
+    return result;
   }
-  
-  return res->body;
+
+  auto& client = GetClient(parsed->scheme_host);
+  auto res = client.Get(parsed->path, headers, StartTotalTimeout(client));
+  if (!res) {
+    RequestFailures().Increment();
+    spdlog::error("HTTP GET request failed for URL: {} - Error: {}", url, static_cast<int>(res.error()));
+    return result;
+  }
+
+  if (res->status == HTTP_NOT_MODIFIED) {
+    result.status = FetchStatus::FETCH_NOT_MODIFIED;
+    return result;
+  }
+
+  ReceivedBytes().Increment(res->body.size());
+  if (res->status != HTTP_OK) {
+    RequestFailures().Increment();
+    spdlog::error("HTTP GET error: {} for URL: {}", res->status, url);
+    return result;
+  }
+
+  if (!DecodeBody(url, *res, result.body)) {
+    return result;
+  }
+
+  result.validators.etag = res->get_header_value("ETag");
+  result.validators.last_modified = res->get_header_value("Last-Modified");
+  result.status = FetchStatus::FETCH_OK;
+  return result;
+}
+
+bool HttpClient::DecodeBody(const std::string& url, httplib::Response& response,
+                            std::string& body) {
+  ResponseWireBytes().Observe(static_cast<double>(response.body.size()));
+  auto encoding = ParseContentEncoding(response.get_header_value("Content-Encoding"));
+  if (encoding == ContentEncoding::IDENTITY) {
+    DecodedBytes().Increment(response.body.size());
+    body = std::move(response.body);
+    return true;
+  }
+
+  auto started_at = std::chrono::steady_clock::now();
+  auto decoded = decoder_->Decode(encoding, response.body);
+  auto elapsed = std::chrono::steady_clock::now() - started_at;
+  DecompressDuration().ObserveDuration(elapsed);
+  if (!decoded.has_value()) {
+    RequestFailures().Increment();
+    spdlog::error("Failed to decode {} response body for URL: {}",
+                  ContentEncodingName(encoding), url);
+    return false;
+  }
+
+  DecodedBytes().Increment(decoded->size());
+  spdlog::debug("{} response for {}: {} bytes on the wire, {} decoded in {} us",
+                ContentEncodingName(encoding), url, response.body.size(), decoded->size(),
+                std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+  decoder_->TakeDecoded(body);
+  return true;
+}
+
+httplib::Progress HttpClient::StartTotalTimeout(httplib::Client& client) const {
+  if (options_.total_timeout <= std::chrono::milliseconds::zero()) {
+    return nullptr;
+  }
+
+  client.set_connection_timeout(std::min(options_.connect_timeout, options_.total_timeout));
+  client.set_read_timeout(std::min(options_.read_timeout, options_.total_timeout));
+  client.set_write_timeout(std::min(options_.write_timeout, options_.total_timeout));
+  auto deadline = std::chrono::steady_clock::now() + options_.total_timeout;
+  return [deadline](uint64_t, uint64_t) {
+    return std::chrono::steady_clock::now() < deadline;
+  };
 }
 
 }  // namespace duw
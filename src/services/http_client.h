@@ -1,30 +1,83 @@
 #ifndef HTTP_CLIENT_H
 #define HTTP_CLIENT_H
 
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <unordered_map>
+#include <unordered_set>
 
 #include <httplib.h>
 
+#include "../util/content_decoder.h"
+
 namespace duw {
 
+struct HttpClientOptions {
+  std::chrono::milliseconds connect_timeout{10000};
+  std::chrono::milliseconds read_timeout{30000};
+  std::chrono::milliseconds write_timeout{30000};
+  std::chrono::milliseconds total_timeout{0};
+  bool compress_requests = false;
+  std::string authorization = "";
+};
+
+enum class FetchStatus : std::uint8_t {
+  FETCH_OK = 0,
+  FETCH_NOT_MODIFIED = 1,
+  FETCH_FAILED = 2
+};
+
+struct CacheValidators {
+  std::string etag;
+  std::string last_modified;
+};
+
+struct FetchResult {
+  FetchStatus status = FetchStatus::FETCH_FAILED;
+  std::string body;
+  CacheValidators validators;
+};
+
 class HttpClient {
  public:
   HttpClient();
+  explicit HttpClient(HttpClientOptions options);
   ~HttpClient() = default;
 
   HttpClient(const HttpClient&) = delete;
   HttpClient& operator=(const HttpClient&) = delete;
 
-  HttpClient(HttpClient&& other) noexcept = default;
-  HttpClient& operator=(HttpClient&& other) noexcept = default;
-
   std::string Get(const std::string& url);
+  FetchResult GetIfModified(const std::string& url);
+  void CommitValidators(const std::string& url, CacheValidators validators);
   std::string Put(const std::string& url, const std::string& data);
+  std::string Put(const std::string& url,
+                  std::size_t content_length,
+                  httplib::ContentProvider content_provider);
+  int Download(const std::string& url,
+               const httplib::Headers& headers,
+               httplib::ResponseHandler response_handler,
+               httplib::ContentReceiver content_receiver);
 
  private:
-  // No need to store client since we create it per request
+  HttpClientOptions options_;
+  std::unordered_map<std::string, std::unique_ptr<httplib::Client>> clients_;
+  std::mutex validators_mutex_;
+  std::unordered_map<std::string, CacheValidators> validators_;
+  std::unordered_set<std::string> uncompressed_hosts_;
+  std::unique_ptr<ContentDecoder> decoder_;
+
+  httplib::Client& GetClient(const std::string& scheme_host);
+  FetchResult Fetch(const std::string& url, const httplib::Headers& headers);
+  httplib::Progress StartTotalTimeout(httplib::Client& client) const;
+  bool DecodeBody(const std::string& url, httplib::Response& response, std::string& body);
+  std::string PutResponseBody(const std::string& url, httplib::Result& result);
 };
 
 }  // namespace duw
 
-#endif  // HTTP_CLIENT_H
\ No newline at end of file
+#endif  // HTTP_CLIENT_H
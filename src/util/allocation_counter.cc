@@ -0,0 +1,123 @@
+#include "allocation_counter.h"
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace duw {
+
+namespace {
+
+constexpr int EXACT_BUCKETS = 16;
+
+#ifdef DUW_COUNT_ALLOCATIONS
+thread_local std::uint64_t thread_allocations = 0;
+
+void* CountedAllocate(std::size_t size) noexcept {
+  ++thread_allocations;
+  return std::malloc(size == 0 ? 1 : size);
+}
+
+void* CountedAlignedAllocate(std::size_t size, std::align_val_t alignment) noexcept {
+  ++thread_allocations;
+  auto align = static_cast<std::size_t>(alignment);
+  return std::aligned_alloc(align, (size + align - 1) / align * align);
+}
+#endif
+
+}  // anonymous namespace
+
+bool AllocationCountingEnabled() {
+#ifdef DUW_COUNT_ALLOCATIONS
+  return true;
+#else
+  return false;
+#endif
+}
+
+std::uint64_t ThreadAllocationCount() {
+#ifdef DUW_COUNT_ALLOCATIONS
+  return thread_allocations;
+#else
+  return 0;
+#endif
+}
+
+std::vector<double> AllocationBuckets() {
+  std::vector<double> bounds;
+  for (int count = 0; count <= EXACT_BUCKETS; ++count) {
+    bounds.push_back(count);
+  }
+  for (int count = EXACT_BUCKETS * 2; count <= 4096; count *= 2) {
+    bounds.push_back(count);
+  }
+  return bounds;
+}
+
+}  // namespace duw
+
+#ifdef DUW_COUNT_ALLOCATIONS
+
+void* operator new(std::size_t size) {
+  if (void* memory = duw::CountedAllocate(size)) {
+    return memory;
+  }
+  throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+  return ::operator new(size);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+  return duw::CountedAllocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+  return duw::CountedAllocate(size);
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+  if (void* memory = duw::CountedAlignedAllocate(size, alignment)) {
+    return memory;
+  }
+  throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size, std::align_val_t alignment) {
+  return ::operator new(size, alignment);
+}
+
+void operator delete(void* memory) noexcept {
+  std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+  std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+  std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+  std::free(memory);
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept {
+  std::free(memory);
+}
+
+void operator delete[](void* memory, std::align_val_t) noexcept {
+  std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept {
+  std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t, std::align_val_t) noexcept {
+  std::free(memory);
+}
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef ALLOCATION_COUNTER_H
+#define ALLOCATION_COUNTER_H
+
+#include <cstdint>
+#include <vector>
+
+#include "metrics.h"
+
+namespace duw {
+
+bool AllocationCountingEnabled();
+std::uint64_t ThreadAllocationCount();
+std::vector<double> AllocationBuckets();
+
+class ScopedAllocationCounter {
+ public:
+  explicit ScopedAllocationCounter(Histogram& histogram)
+      : histogram_(histogram), started_at_(ThreadAllocationCount()) {}
+  ~ScopedAllocationCounter() {
+    if (AllocationCountingEnabled()) {
+      histogram_.Observe(static_cast<double>(ThreadAllocationCount() - started_at_));
+    }
+  }
+
+  ScopedAllocationCounter(const ScopedAllocationCounter&) = delete;
+  ScopedAllocationCounter& operator=(const ScopedAllocationCounter&) = delete;
+
+ private:
+  Histogram& histogram_;
+  std::uint64_t started_at_;
+};
+
+}  // namespace duw
+
+#endif  // ALLOCATION_COUNTER_H
@@ -0,0 +1,296 @@
+#include "base64.h"
+
+#include "base64_kernels.h"
+
+namespace duw {
+
+namespace {
+
+constexpr char ENCODE_TABLE[] =
+    "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+constexpr char PADDING = '=';
+constexpr unsigned char INVALID_VALUE = 0xFF;
+
+struct DecodeTable {
+  std::array<unsigned char, 256> values;
+
+  constexpr DecodeTable() : values() {
+    values.fill(INVALID_VALUE);
+    for (unsigned char i = 0; i < 64; ++i) {
+      values[static_cast<unsigned char>(ENCODE_TABLE[i])] = i;
+    }
+  }
+};
+
+constexpr DecodeTable DECODE_TABLE;
+
+struct KernelSet {
+  Base64EncodeKernel encode;
+  Base64DecodeKernel decode;
+};
+
+std::size_t EncodeScalar(const unsigned char* input, std::size_t size, char* output) {
+  std::size_t i = 0;
+  for (; i + 3 <= size; i += 3) {
+    std::uint32_t triple = (static_cast<std::uint32_t>(input[i]) << 16) |
+                           (static_cast<std::uint32_t>(input[i + 1]) << 8) | input[i + 2];
+    *output++ = ENCODE_TABLE[(triple >> 18) & 0x3F];
+    *output++ = ENCODE_TABLE[(triple >> 12) & 0x3F];
+    *output++ = ENCODE_TABLE[(triple >> 6) & 0x3F];
+    *output++ = ENCODE_TABLE[triple & 0x3F];
+  }
+  return i;
+}
+
+std::size_t DecodeScalar(const char* input, std::size_t size, unsigned char* output) {
+  std::size_t i = 0;
+  for (; i + 4 <= size; i += 4) {
+    auto a = DECODE_TABLE.values[static_cast<unsigned char>(input[i])];
+    auto b = DECODE_TABLE.values[static_cast<unsigned char>(input[i + 1])];
+    auto c = DECODE_TABLE.values[static_cast<unsigned char>(input[i + 2])];
+    auto d = DECODE_TABLE.values[static_cast<unsigned char>(input[i + 3])];
+    if (((a | b | c | d) & 0xC0) != 0) {
+      break;
+    }
+    std::uint32_t triple = (static_cast<std::uint32_t>(a) << 18) |
+                           (static_cast<std::uint32_t>(b) << 12) |
+                           (static_cast<std::uint32_t>(c) << 6) | d;
+    *output++ = static_cast<unsigned char>(triple >> 16);
+    *output++ = static_cast<unsigned char>(triple >> 8);
+    *output++ = static_cast<unsigned char>(triple);
+  }
+  return i;
+}
+
+KernelSet KernelsFor(Base64Kernel kernel) {
+  switch (kernel) {
+#ifdef DUW_BASE64_X86
+    case Base64Kernel::KERNEL_SSSE3:
+      return KernelSet{EncodeBase64Ssse3, DecodeBase64Ssse3};
+    case Base64Kernel::KERNEL_AVX2:
+      return KernelSet{EncodeBase64Avx2, DecodeBase64Avx2};
+#endif
+#ifdef DUW_BASE64_NEON
+    case Base64Kernel::KERNEL_NEON:
+      return KernelSet{EncodeBase64Neon, DecodeBase64Neon};
+#endif
+    default:
+      return KernelSet{EncodeScalar, DecodeScalar};
+  }
+}
+
+Base64Kernel DetectKernel() {
+#ifdef DUW_BASE64_X86
+  if (__builtin_cpu_supports("avx2")) {
+    return Base64Kernel::KERNEL_AVX2;
+  }
+  if (__builtin_cpu_supports("ssse3")) {
+    return Base64Kernel::KERNEL_SSSE3;
+  }
+#endif
+#ifdef DUW_BASE64_NEON
+  return Base64Kernel::KERNEL_NEON;
+#endif
+  return Base64Kernel::KERNEL_SCALAR;
+}
+
+void EncodeBlocks(Base64Kernel kernel, const unsigned char* input, std::size_t size,
+                  char* output) {
+  std::size_t consumed = KernelsFor(kernel).encode(input, size, output);
+  EncodeScalar(input + consumed, size - consumed, output + consumed / 3 * 4);
+}
+
+bool IsWhitespace(char c) {
+  return c == '\n' || c == '\r' || c == ' ' || c == '\t';
+}
+
+}  // anonymous namespace
+
+Base64Kernel ActiveBase64Kernel() {
+  static const Base64Kernel kernel = DetectKernel();
+  return kernel;
+}
+
+bool IsBase64KernelSupported(Base64Kernel kernel) {
+  switch (kernel) {
+    case Base64Kernel::KERNEL_SCALAR:
+      return true;
+#ifdef DUW_BASE64_X86
+    case Base64Kernel::KERNEL_SSSE3:
+      return __builtin_cpu_supports("ssse3");
+    case Base64Kernel::KERNEL_AVX2:
+      return __builtin_cpu_supports("avx2");
+#endif
+#ifdef DUW_BASE64_NEON
+    case Base64Kernel::KERNEL_NEON:
+      return true;
+#endif
+    default:
+      return false;
+  }
+}
+
+const char* Base64KernelName(Base64Kernel kernel) {
+  switch (kernel) {
+    case Base64Kernel::KERNEL_SSSE3:
+      return "ssse3";
+    case Base64Kernel::KERNEL_AVX2:
+      return "avx2";
+    case Base64Kernel::KERNEL_NEON:
+      return "neon";
+    default:
+      return "scalar";
+  }
+}
+
+std::size_t Base64EncodedSize(std::size_t input_size) {
+  return (input_size + 2) / 3 * 4;
+}
+
+std::string Base64Encode(std::string_view data, Base64Kernel kernel) {
+  std::string output;
+  output.reserve(Base64EncodedSize(data.size()));
+  Base64Encoder encoder(kernel);
+  encoder.Update(data, output);
+  encoder.Finish(output);
+  return output;
+}
+
+std::optional<std::string> Base64Decode(std::string_view text, Base64Kernel kernel) {
+  std::string output;
+  Base64Decoder decoder(kernel);
+  if (!decoder.Update(text, output) || !decoder.Finish(output)) {
+    return std::nullopt;
+  }
+  return output;
+}
+
+Base64Encoder::Base64Encoder(Base64Kernel kernel)
+    : kernel_(IsBase64KernelSupported(kernel) ? kernel : Base64Kernel::KERNEL_SCALAR) {}
+
+void Base64Encoder::Update(std::string_view chunk, std::string& output) {
+  const auto* input = reinterpret_cast<const unsigned char*>(chunk.data());
+  std::size_t size = chunk.size();
+
+  while (pending_size_ > 0 && pending_size_ < pending_.size() && size > 0) {
+    pending_[pending_size_++] = *input++;
+    --size;
+  }
+
+  std::size_t blocks_size = size / 3 * 3;
+  std::size_t base = output.size();
+  std::size_t pending_output = pending_size_ == pending_.size() ? 4 : 0;
+  output.resize(base + pending_output + blocks_size / 3 * 4);
+
+  if (pending_output > 0) {
+    EncodeScalar(pending_.data(), pending_.size(), output.data() + base);
+    pending_size_ = 0;
+  }
+  EncodeBlocks(kernel_, input, blocks_size, output.data() + base + pending_output);
+
+  for (std::size_t i = blocks_size; i < size; ++i) {
+    pending_[pending_size_++] = input[i];
+  }
+}
+
+void Base64Encoder::Finish(std::string& output) {
+  if (pending_size_ == 0) {
+    return;
+  }
+
+  std::uint32_t triple = static_cast<std::uint32_t>(pending_[0]) << 16;
+  if (pending_size_ == 2) {
+    triple |= static_cast<std::uint32_t>(pending_[1]) << 8;
+  }
+
+  output.push_back(ENCODE_TABLE[(triple >> 18) & 0x3F]);
+  output.push_back(ENCODE_TABLE[(triple >> 12) & 0x3F]);
+  output.push_back(pending_size_ == 2 ? ENCODE_TABLE[(triple >> 6) & 0x3F] : PADDING);
+  output.push_back(PADDING);
+  pending_size_ = 0;
+}
+
+Base64Decoder::Base64Decoder(Base64Kernel kernel)
+    : kernel_(IsBase64KernelSupported(kernel) ? kernel : Base64Kernel::KERNEL_SCALAR) {}
+
+bool Base64Decoder::Update(std::string_view chunk, std::string& output) {
+  if (failed_) {
+    return false;
+  }
+
+  std::size_t base = output.size();
+  output.resize(base + (chunk.size() + pending_size_) / 4 * 3 + 3);
+  auto* out = reinterpret_cast<unsigned char*>(output.data() + base);
+  std::size_t written = 0;
+  auto decode = KernelsFor(kernel_).decode;
+
+  std::size_t i = 0;
+  while (i < chunk.size() && !failed_) {
+    if (pending_size_ == 0 && !padding_seen_) {
+      std::size_t consumed = decode(chunk.data() + i, chunk.size() - i, out + written);
+      consumed += DecodeScalar(chunk.data() + i + consumed, chunk.size() - i - consumed,
+                               out + written + consumed / 4 * 3);
+      i += consumed;
+      written += consumed / 4 * 3;
+      if (i == chunk.size()) {
+        break;
+      }
+    }
+
+    char c = chunk[i++];
+    if (IsWhitespace(c)) {
+      continue;
+    }
+    if (padding_seen_) {
+      failed_ = true;
+      break;
+    }
+
+    pending_[pending_size_++] = c;
+    if (pending_size_ == pending_.size()) {
+      written += DecodeQuantum(out + written);
+    }
+  }
+
+  output.resize(base + written);
+  return !failed_;
+}
+
+bool Base64Decoder::Finish(std::string& output) {
+  static_cast<void>(output);
+  if (pending_size_ != 0) {
+    failed_ = true;
+  }
+  return !failed_;
+}
+
+std::size_t Base64Decoder::DecodeQuantum(unsigned char* output) {
+  pending_size_ = 0;
+
+  std::size_t data_chars = pending_.size();
+  while (data_chars > 2 && pending_[data_chars - 1] == PADDING) {
+    --data_chars;
+  }
+
+  std::uint32_t triple = 0;
+  for (std::size_t i = 0; i < pending_.size(); ++i) {
+    unsigned char value = 0;
+    if (i < data_chars) {
+      value = DECODE_TABLE.values[static_cast<unsigned char>(pending_[i])];
+      if (value == INVALID_VALUE) {
+        failed_ = true;
+        return 0;
+      }
+    }
+    triple = (triple << 6) | value;
+  }
+
+  padding_seen_ = data_chars < pending_.size();
+  std::size_t bytes = data_chars - 1;
+  for (std::size_t i = 0; i < bytes; ++i) {
+    output[i] = static_cast<unsigned char>(triple >> (16 - 8 * i));
+  }
+  return bytes;
+}
+
+}  // namespace duw
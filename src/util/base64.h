@@ -0,0 +1,61 @@
+#ifndef BASE64_H
+#define BASE64_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace duw {
+
+enum class Base64Kernel : std::uint8_t {
+  KERNEL_SCALAR = 0,
+  KERNEL_SSSE3 = 1,
+  KERNEL_AVX2 = 2,
+  KERNEL_NEON = 3
+};
+
+Base64Kernel ActiveBase64Kernel();
+bool IsBase64KernelSupported(Base64Kernel kernel);
+const char* Base64KernelName(Base64Kernel kernel);
+
+std::size_t Base64EncodedSize(std::size_t input_size);
+std::string Base64Encode(std::string_view data, Base64Kernel kernel = ActiveBase64Kernel());
+std::optional<std::string> Base64Decode(std::string_view text,
+                                        Base64Kernel kernel = ActiveBase64Kernel());
+
+class Base64Encoder {
+ public:
+  explicit Base64Encoder(Base64Kernel kernel = ActiveBase64Kernel());
+
+  void Update(std::string_view chunk, std::string& output);
+  void Finish(std::string& output);
+
+ private:
+  Base64Kernel kernel_;
+  std::array<unsigned char, 3> pending_{};
+  std::size_t pending_size_ = 0;
+};
+
+class Base64Decoder {
+ public:
+  explicit Base64Decoder(Base64Kernel kernel = ActiveBase64Kernel());
+
+  bool Update(std::string_view chunk, std::string& output);
+  bool Finish(std::string& output);
+
+ private:
+  Base64Kernel kernel_;
+  std::array<char, 4> pending_{};
+  std::size_t pending_size_ = 0;
+  bool padding_seen_ = false;
+  bool failed_ = false;
+
+  std::size_t DecodeQuantum(unsigned char* output);
+};
+
+}  // namespace duw
+
+#endif  // BASE64_H
@@ -0,0 +1,35 @@
+#ifndef BASE64_KERNELS_H
+#define BASE64_KERNELS_H
+
+#include <cstddef>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define DUW_BASE64_X86 1
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#define DUW_BASE64_NEON 1
+#endif
+
+namespace duw {
+
+using Base64EncodeKernel = std::size_t (*)(const unsigned char* input, std::size_t size,
+                                           char* output);
+using Base64DecodeKernel = std::size_t (*)(const char* input, std::size_t size,
+                                           unsigned char* output);
+
+#ifdef DUW_BASE64_X86
+std::size_t EncodeBase64Ssse3(const unsigned char* input, std::size_t size, char* output);
+std::size_t DecodeBase64Ssse3(const char* input, std::size_t size, unsigned char* output);
+std::size_t EncodeBase64Avx2(const unsigned char* input, std::size_t size, char* output);
+std::size_t DecodeBase64Avx2(const char* input, std::size_t size, unsigned char* output);
+#endif
+
+#ifdef DUW_BASE64_NEON
+std::size_t EncodeBase64Neon(const unsigned char* input, std::size_t size, char* output);
+std::size_t DecodeBase64Neon(const char* input, std::size_t size, unsigned char* output);
+#endif
+
+}  // namespace duw
+
+#endif  // BASE64_KERNELS_H
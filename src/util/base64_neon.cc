@@ -0,0 +1,100 @@
+#include "base64_kernels.h"
+
+#ifdef DUW_BASE64_NEON
+
+#include <arm_neon.h>
+
+namespace duw {
+
+namespace {
+
+constexpr unsigned char ENCODE_TABLE[64] = {
+    'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P',
+    'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z', 'a', 'b', 'c', 'd', 'e', 'f',
+    'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o', 'p', 'q', 'r', 's', 't', 'u', 'v',
+    'w', 'x', 'y', 'z', '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '+', '/'};
+
+constexpr unsigned char INVALID = 0xFF;
+
+constexpr unsigned char DECODE_TABLE[128] = {
+    INVALID, INVALID, INVALID, INVALID, INVALID, INVALID, INVALID, INVALID,
+    INVALID, INVALID, INVALID, INVALID, INVALID, INVALID, INVALID, INVALID,
+    INVALID, INVALID, INVALID, INVALID, INVALID, INVALID, INVALID, INVALID,
+    INVALID, INVALID, INVALID, INVALID, INVALID, INVALID, INVALID, INVALID,
+    INVALID, INVALID, INVALID, INVALID, INVALID, INVALID, INVALID, INVALID,
+    INVALID, INVALID, INVALID, 62,      INVALID, INVALID, INVALID, 63,
+    52,      53,      54,      55,      56,      57,      58,      59,
+    60,      61,      INVALID, INVALID, INVALID, INVALID, INVALID, INVALID,
+    INVALID, 0,       1,       2,       3,       4,       5,       6,
+    7,       8,       9,       10,      11,      12,      13,      14,
+    15,      16,      17,      18,      19,      20,      21,      22,
+    23,      24,      25,      INVALID, INVALID, INVALID, INVALID, INVALID,
+    INVALID, 26,      27,      28,      29,      30,      31,      32,
+    33,      34,      35,      36,      37,      38,      39,      40,
+    41,      42,      43,      44,      45,      46,      47,      48,
+    49,      50,      51,      INVALID, INVALID, INVALID, INVALID, INVALID};
+
+uint8x16x4_t LoadTable(const unsigned char* table) {
+  return uint8x16x4_t{{vld1q_u8(table), vld1q_u8(table + 16), vld1q_u8(table + 32),
+                       vld1q_u8(table + 48)}};
+}
+
+}  // anonymous namespace
+
+std::size_t EncodeBase64Neon(const unsigned char* input, std::size_t size, char* output) {
+  const uint8x16x4_t table = LoadTable(ENCODE_TABLE);
+  const uint8x16_t low_six_bits = vdupq_n_u8(0x3F);
+
+  std::size_t i = 0;
+  for (; i + 48 <= size; i += 48) {
+    uint8x16x3_t in = vld3q_u8(input + i);
+    uint8x16x4_t indices;
+    indices.val[0] = vshrq_n_u8(in.val[0], 2);
+    indices.val[1] =
+        vandq_u8(vorrq_u8(vshlq_n_u8(in.val[0], 4), vshrq_n_u8(in.val[1], 4)), low_six_bits);
+    indices.val[2] =
+        vandq_u8(vorrq_u8(vshlq_n_u8(in.val[1], 2), vshrq_n_u8(in.val[2], 6)), low_six_bits);
+    indices.val[3] = vandq_u8(in.val[2], low_six_bits);
+
+    uint8x16x4_t encoded;
+    for (int lane = 0; lane < 4; ++lane) {
+      encoded.val[lane] = vqtbl4q_u8(table, indices.val[lane]);
+    }
+    vst4q_u8(reinterpret_cast<unsigned char*>(output + i / 3 * 4), encoded);
+  }
+  return i;
+}
+
+std::size_t DecodeBase64Neon(const char* input, std::size_t size, unsigned char* output) {
+  const uint8x16x4_t low_table = LoadTable(DECODE_TABLE);
+  const uint8x16x4_t high_table = LoadTable(DECODE_TABLE + 64);
+  const uint8x16_t table_offset = vdupq_n_u8(64);
+  const uint8x16_t non_ascii = vdupq_n_u8(0x80);
+
+  std::size_t i = 0;
+  for (; i + 64 <= size; i += 64) {
+    uint8x16x4_t in = vld4q_u8(reinterpret_cast<const unsigned char*>(input + i));
+    uint8x16x4_t values;
+    uint8x16_t errors = vdupq_n_u8(0);
+    for (int lane = 0; lane < 4; ++lane) {
+      uint8x16_t value = vqtbl4q_u8(low_table, in.val[lane]);
+      value = vqtbx4q_u8(value, high_table, vsubq_u8(in.val[lane], table_offset));
+      errors = vorrq_u8(errors, vorrq_u8(value, vandq_u8(in.val[lane], non_ascii)));
+      values.val[lane] = value;
+    }
+    if (vmaxvq_u8(errors) > 0x3F) {
+      break;
+    }
+
+    uint8x16x3_t decoded;
+    decoded.val[0] = vorrq_u8(vshlq_n_u8(values.val[0], 2), vshrq_n_u8(values.val[1], 4));
+    decoded.val[1] = vorrq_u8(vshlq_n_u8(values.val[1], 4), vshrq_n_u8(values.val[2], 2));
+    decoded.val[2] = vorrq_u8(vshlq_n_u8(values.val[2], 6), values.val[3]);
+    vst3q_u8(output + i / 4 * 3, decoded);
+  }
+  return i;
+}
+
+}  // namespace duw
+
+#endif  // DUW_BASE64_NEON
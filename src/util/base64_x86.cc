@@ -0,0 +1,172 @@
+#include "base64_kernels.h"
+
+#ifdef DUW_BASE64_X86
+
+#include <immintrin.h>
+
+namespace duw {
+
+namespace {
+
+#define DUW_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define DUW_TARGET_AVX2 __attribute__((target("avx2")))
+
+DUW_TARGET_SSSE3 __m128i EncodeLanes128(__m128i input) {
+  input = _mm_shuffle_epi8(input, _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+  __m128i high = _mm_mulhi_epu16(_mm_and_si128(input, _mm_set1_epi32(0x0FC0FC00)),
+                                 _mm_set1_epi32(0x04000040));
+  __m128i low = _mm_mullo_epi16(_mm_and_si128(input, _mm_set1_epi32(0x003F03F0)),
+                                _mm_set1_epi32(0x01000010));
+  __m128i indices = _mm_or_si128(high, low);
+
+  __m128i offsets = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+  __m128i is_upper = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+  offsets = _mm_or_si128(offsets, _mm_and_si128(is_upper, _mm_set1_epi8(13)));
+  __m128i shift_table = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                      '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+                                      '/' - 63, 'A', 0, 0);
+  return _mm_add_epi8(_mm_shuffle_epi8(shift_table, offsets), indices);
+}
+
+DUW_TARGET_SSSE3 bool TranslateLanes128(__m128i input, __m128i& values) {
+  const __m128i lo_table = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                         0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B, 0x1A);
+  const __m128i hi_table = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10,
+                                         0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+  const __m128i roll_table =
+      _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+  const __m128i slash = _mm_set1_epi8(0x2F);
+
+  __m128i hi_nibbles = _mm_and_si128(_mm_srli_epi32(input, 4), slash);
+  __m128i lo_nibbles = _mm_and_si128(input, slash);
+  __m128i invalid = _mm_and_si128(_mm_shuffle_epi8(lo_table, lo_nibbles),
+                                  _mm_shuffle_epi8(hi_table, hi_nibbles));
+  if (_mm_movemask_epi8(_mm_cmpeq_epi8(invalid, _mm_setzero_si128())) != 0xFFFF) {
+    return false;
+  }
+
+  __m128i roll = _mm_shuffle_epi8(roll_table,
+                                  _mm_add_epi8(_mm_cmpeq_epi8(input, slash), hi_nibbles));
+  values = _mm_add_epi8(input, roll);
+  return true;
+}
+
+DUW_TARGET_SSSE3 __m128i PackLanes128(__m128i values) {
+  __m128i merged = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+  merged = _mm_madd_epi16(merged, _mm_set1_epi32(0x00011000));
+  return _mm_shuffle_epi8(merged,
+                          _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+}
+
+}  // anonymous namespace
+
+DUW_TARGET_SSSE3 std::size_t EncodeBase64Ssse3(const unsigned char* input, std::size_t size,
+                                               char* output) {
+  std::size_t i = 0;
+  for (; i + 16 <= size; i += 12) {
+    __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(output + i / 3 * 4), EncodeLanes128(block));
+  }
+  return i;
+}
+
+DUW_TARGET_SSSE3 std::size_t DecodeBase64Ssse3(const char* input, std::size_t size,
+                                               unsigned char* output) {
+  std::size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    __m128i values;
+    if (!TranslateLanes128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i)),
+                           values)) {
+      break;
+    }
+
+    __m128i packed = PackLanes128(values);
+    unsigned char* out = output + i / 4 * 3;
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out), packed);
+    int tail = _mm_cvtsi128_si32(_mm_srli_si128(packed, 8));
+    __builtin_memcpy(out + 8, &tail, sizeof(tail));
+  }
+  return i;
+}
+
+DUW_TARGET_AVX2 std::size_t EncodeBase64Avx2(const unsigned char* input, std::size_t size,
+                                             char* output) {
+  const __m256i shuffle = _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+                                           1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+  const __m256i shift_table = _mm256_setr_epi8(
+      'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+      '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0, 'a' - 26, '0' - 52, '0' - 52, '0' - 52,
+      '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63,
+      'A', 0, 0);
+
+  std::size_t i = 0;
+  for (; i + 28 <= size; i += 24) {
+    __m128i low_lane = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i));
+    __m128i high_lane = _mm_loadu_si128(reinterpret_cast<const __m128i*>(input + i + 12));
+    __m256i block = _mm256_shuffle_epi8(
+        _mm256_inserti128_si256(_mm256_castsi128_si256(low_lane), high_lane, 1), shuffle);
+
+    __m256i high = _mm256_mulhi_epu16(_mm256_and_si256(block, _mm256_set1_epi32(0x0FC0FC00)),
+                                      _mm256_set1_epi32(0x04000040));
+    __m256i low = _mm256_mullo_epi16(_mm256_and_si256(block, _mm256_set1_epi32(0x003F03F0)),
+                                     _mm256_set1_epi32(0x01000010));
+    __m256i indices = _mm256_or_si256(high, low);
+
+    __m256i offsets = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+    __m256i is_upper = _mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices);
+    offsets = _mm256_or_si256(offsets, _mm256_and_si256(is_upper, _mm256_set1_epi8(13)));
+    __m256i encoded = _mm256_add_epi8(_mm256_shuffle_epi8(shift_table, offsets), indices);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i / 3 * 4), encoded);
+  }
+
+  return i + EncodeBase64Ssse3(input + i, size - i, output + i / 3 * 4);
+}
+
+DUW_TARGET_AVX2 std::size_t DecodeBase64Avx2(const char* input, std::size_t size,
+                                             unsigned char* output) {
+  const __m256i lo_table = _mm256_setr_epi8(
+      0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B, 0x1B,
+      0x1A, 0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x13, 0x1A, 0x1B, 0x1B,
+      0x1B, 0x1A);
+  const __m256i hi_table = _mm256_setr_epi8(
+      0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+      0x10, 0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+      0x10, 0x10);
+  const __m256i roll_table = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0,
+                                              0, 0, 0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0,
+                                              0, 0, 0, 0);
+  const __m256i slash = _mm256_set1_epi8(0x2F);
+  const __m256i pack_shuffle =
+      _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1, 2, 1, 0, 6, 5, 4,
+                       10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+
+  std::size_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(input + i));
+    __m256i hi_nibbles = _mm256_and_si256(_mm256_srli_epi32(block, 4), slash);
+    __m256i lo_nibbles = _mm256_and_si256(block, slash);
+    if (!_mm256_testz_si256(_mm256_shuffle_epi8(lo_table, lo_nibbles),
+                            _mm256_shuffle_epi8(hi_table, hi_nibbles))) {
+      break;
+    }
+
+    __m256i roll = _mm256_shuffle_epi8(
+        roll_table, _mm256_add_epi8(_mm256_cmpeq_epi8(block, slash), hi_nibbles));
+    __m256i values = _mm256_add_epi8(block, roll);
+
+    __m256i merged = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+    merged = _mm256_madd_epi16(merged, _mm256_set1_epi32(0x00011000));
+    merged = _mm256_shuffle_epi8(merged, pack_shuffle);
+    merged = _mm256_permutevar8x32_epi32(merged, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+
+    unsigned char* out = output + i / 4 * 3;
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm256_castsi256_si128(merged));
+    _mm_storel_epi64(reinterpret_cast<__m128i*>(out + 16), _mm256_extracti128_si256(merged, 1));
+  }
+
+  return i + DecodeBase64Ssse3(input + i, size - i, output + i / 4 * 3);
+}
+
+}  // namespace duw
+
+#endif  // DUW_BASE64_X86
@@ -0,0 +1,193 @@
+#include "content_decoder.h"
+
+#include <algorithm>
+#include <cctype>
+#include <climits>
+
+#include <zlib.h>
+
+#ifdef DUW_HAVE_BROTLI
+#include <brotli/decode.h>
+#endif
+
+namespace duw {
+
+namespace {
+
+constexpr int AUTO_DETECT_WINDOW_BITS = MAX_WBITS + 32;
+constexpr std::size_t MIN_BUFFER_BYTES = 64 * 1024;
+constexpr std::size_t EXPANSION_GUESS = 8;
+
+std::string_view Trim(std::string_view value) {
+  auto first = value.find_first_not_of(" \t");
+  if (first == std::string_view::npos) {
+    return {};
+  }
+  return value.substr(first, value.find_last_not_of(" \t") - first + 1);
+}
+
+bool EqualsIgnoreCase(std::string_view lhs, std::string_view rhs) {
+  return std::ranges::equal(lhs, rhs, [](unsigned char a, unsigned char b) {
+    return std::tolower(a) == std::tolower(b);
+  });
+}
+
+}  // anonymous namespace
+
+struct ContentDecoder::ZlibState {
+  z_stream stream{};
+  bool initialized = false;
+
+  ~ZlibState() {
+    if (initialized) {
+      inflateEnd(&stream);
+    }
+  }
+};
+
+ContentEncoding ParseContentEncoding(std::string_view header) {
+  auto encoding = Trim(header);
+  if (encoding.empty() || EqualsIgnoreCase(encoding, "identity")) {
+    return ContentEncoding::IDENTITY;
+  }
+  if (EqualsIgnoreCase(encoding, "gzip") || EqualsIgnoreCase(encoding, "x-gzip")) {
+    return ContentEncoding::GZIP;
+  }
+  if (EqualsIgnoreCase(encoding, "deflate")) {
+    return ContentEncoding::DEFLATE;
+  }
+#ifdef DUW_HAVE_BROTLI
+  if (EqualsIgnoreCase(encoding, "br")) {
+    return ContentEncoding::BROTLI;
+  }
+#endif
+  return ContentEncoding::UNSUPPORTED;
+}
+
+std::string_view ContentEncodingName(ContentEncoding encoding) {
+  switch (encoding) {
+    case ContentEncoding::IDENTITY:
+      return "identity";
+    case ContentEncoding::GZIP:
+      return "gzip";
+    case ContentEncoding::DEFLATE:
+      return "deflate";
+    case ContentEncoding::BROTLI:
+      return "br";
+    case ContentEncoding::UNSUPPORTED:
+      break;
+  }
+  return "unsupported";
+}
+
+std::string AcceptedContentEncodings() {
+#ifdef DUW_HAVE_BROTLI
+  return "br, gzip, deflate";
+#else
+  return "gzip, deflate";
+#endif
+}
+
+ContentDecoder::ContentDecoder() : zlib_(std::make_unique<ZlibState>()) {}
+
+ContentDecoder::~ContentDecoder() = default;
+
+std::optional<std::string_view> ContentDecoder::Decode(ContentEncoding encoding,
+                                                       std::string_view input) {
+  switch (encoding) {
+    case ContentEncoding::IDENTITY:
+      return input;
+    case ContentEncoding::GZIP:
+    case ContentEncoding::DEFLATE:
+      return Inflate(input);
+    case ContentEncoding::BROTLI:
+      return DecodeBrotli(input);
+    case ContentEncoding::UNSUPPORTED:
+      break;
+  }
+  return std::nullopt;
+}
+
+void ContentDecoder::TakeDecoded(std::string& out) {
+  buffer_.resize(decoded_size_);
+  out.swap(buffer_);
+}
+
+void ContentDecoder::EnsureSpace(std::size_t produced, std::size_t input_size) {
+  if (produced == 0) {
+    auto wanted = std::max({MIN_BUFFER_BYTES, input_size * EXPANSION_GUESS, decoded_size_});
+    if (buffer_.size() < wanted) {
+      buffer_.resize(std::max(wanted, buffer_.capacity()));
+    }
+  }
+  if (produced == buffer_.size()) {
+    buffer_.resize(buffer_.size() * 2);
+  }
+}
+
+std::optional<std::string_view> ContentDecoder::Inflate(std::string_view input) {
+  auto& stream = zlib_->stream;
+  if (!zlib_->initialized) {
+    if (inflateInit2(&stream, AUTO_DETECT_WINDOW_BITS) != Z_OK) {
+      return std::nullopt;
+    }
+    zlib_->initialized = true;
+  } else if (inflateReset(&stream) != Z_OK) {
+    return std::nullopt;
+  }
+
+  stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(input.data()));
+  stream.avail_in = static_cast<uInt>(input.size());
+  std::size_t produced = 0;
+  int result = Z_OK;
+  while (result != Z_STREAM_END) {
+    EnsureSpace(produced, input.size());
+    auto available = static_cast<uInt>(std::min<std::size_t>(buffer_.size() - produced, UINT_MAX));
+    stream.next_out = reinterpret_cast<Bytef*>(buffer_.data() + produced);
+    stream.avail_out = available;
+    result = inflate(&stream, Z_NO_FLUSH);
+    produced += available - stream.avail_out;
+    if (result != Z_OK && result != Z_STREAM_END) {
+      return std::nullopt;
+    }
+  }
+  return Decoded(produced);
+}
+
+std::string_view ContentDecoder::Decoded(std::size_t produced) {
+  decoded_size_ = produced;
+  return std::string_view(buffer_.data(), produced);
+}
+
+std::optional<std::string_view> ContentDecoder::DecodeBrotli(std::string_view input) {
+#ifdef DUW_HAVE_BROTLI
+  std::unique_ptr<BrotliDecoderState, void (*)(BrotliDecoderState*)> state(
+      BrotliDecoderCreateInstance(nullptr, nullptr, nullptr), BrotliDecoderDestroyInstance);
+  if (state == nullptr) {
+    return std::nullopt;
+  }
+
+  const auto* next_in = reinterpret_cast<const std::uint8_t*>(input.data());
+  std::size_t available_in = input.size();
+  std::size_t produced = 0;
+  while (true) {
+    EnsureSpace(produced, input.size());
+    auto* next_out = reinterpret_cast<std::uint8_t*>(buffer_.data() + produced);
+    std::size_t available_out = buffer_.size() - produced;
+    auto result = BrotliDecoderDecompressStream(state.get(), &available_in, &next_in,
+                                                &available_out, &next_out, nullptr);
+    produced = buffer_.size() - available_out;
+    if (result == BROTLI_DECODER_RESULT_SUCCESS) {
+      return Decoded(produced);
+    }
+    if (result != BROTLI_DECODER_RESULT_NEEDS_MORE_OUTPUT) {
+      return std::nullopt;
+    }
+  }
+#else
+  static_cast<void>(input);
+  return std::nullopt;
+#endif
+}
+
+}  // namespace duw
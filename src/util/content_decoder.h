@@ -0,0 +1,51 @@
+#ifndef CONTENT_DECODER_H
+#define CONTENT_DECODER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace duw {
+
+enum class ContentEncoding : std::uint8_t {
+  IDENTITY = 0,
+  GZIP = 1,
+  DEFLATE = 2,
+  BROTLI = 3,
+  UNSUPPORTED = 4
+};
+
+ContentEncoding ParseContentEncoding(std::string_view header);
+std::string_view ContentEncodingName(ContentEncoding encoding);
+std::string AcceptedContentEncodings();
+
+class ContentDecoder {
+ public:
+  ContentDecoder();
+  ~ContentDecoder();
+
+  ContentDecoder(const ContentDecoder&) = delete;
+  ContentDecoder& operator=(const ContentDecoder&) = delete;
+
+  std::optional<std::string_view> Decode(ContentEncoding encoding, std::string_view input);
+  void TakeDecoded(std::string& out);
+
+ private:
+  struct ZlibState;
+
+  std::unique_ptr<ZlibState> zlib_;
+  std::string buffer_;
+  std::size_t decoded_size_ = 0;
+
+  void EnsureSpace(std::size_t produced, std::size_t input_size);
+  std::string_view Decoded(std::size_t produced);
+  std::optional<std::string_view> Inflate(std::string_view input);
+  std::optional<std::string_view> DecodeBrotli(std::string_view input);
+};
+
+}  // namespace duw
+
+#endif  // CONTENT_DECODER_H
@@ -0,0 +1,12 @@
+#ifndef FILE_SYNC_H
+#define FILE_SYNC_H
+
+#include <filesystem>
+
+namespace duw {
+
+bool SyncToDisk(const std::filesystem::path& path);
+
+}  // namespace duw
+
+#endif  // FILE_SYNC_H
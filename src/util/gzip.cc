@@ -0,0 +1,69 @@
+#include "gzip.h"
+
+#include <array>
+#include <memory>
+
+#include <zlib.h>
+
+namespace duw {
+
+namespace {
+
+constexpr int GZIP_WINDOW_BITS = MAX_WBITS + 16;
+constexpr int MEMORY_LEVEL = 8;
+constexpr std::size_t CHUNK_BYTES = 64 * 1024;
+
+using ZStream = std::unique_ptr<z_stream, int (*)(z_stream*)>;
+
+Bytef* InputBytes(std::string_view data) {
+  return reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+}
+
+std::optional<std::string> Drain(z_stream& stream, int (*step)(z_stream*, int), int flush) {
+  std::string output;
+  std::array<char, CHUNK_BYTES> chunk;
+  int result = Z_OK;
+  do {
+    stream.next_out = reinterpret_cast<Bytef*>(chunk.data());
+    stream.avail_out = static_cast<uInt>(chunk.size());
+    result = step(&stream, flush);
+    if (result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR) {
+      return std::nullopt;
+    }
+    output.append(chunk.data(), chunk.size() - stream.avail_out);
+  } while (result != Z_STREAM_END && (stream.avail_in > 0 || stream.avail_out == 0));
+
+  if (result != Z_STREAM_END) {
+    return std::nullopt;
+  }
+  return output;
+}
+
+}  // anonymous namespace
+
+std::optional<std::string> GzipCompress(std::string_view data) {
+  z_stream stream{};
+  if (deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, GZIP_WINDOW_BITS, MEMORY_LEVEL,
+                   Z_DEFAULT_STRATEGY) != Z_OK) {
+    return std::nullopt;
+  }
+  ZStream guard(&stream, deflateEnd);
+
+  stream.next_in = InputBytes(data);
+  stream.avail_in = static_cast<uInt>(data.size());
+  return Drain(stream, deflate, Z_FINISH);
+}
+
+std::optional<std::string> GzipDecompress(std::string_view data) {
+  z_stream stream{};
+  if (inflateInit2(&stream, GZIP_WINDOW_BITS) != Z_OK) {
+    return std::nullopt;
+  }
+  ZStream guard(&stream, inflateEnd);
+
+  stream.next_in = InputBytes(data);
+  stream.avail_in = static_cast<uInt>(data.size());
+  return Drain(stream, inflate, Z_NO_FLUSH);
+}
+
+}  // namespace duw
@@ -0,0 +1,15 @@
+#ifndef GZIP_H
+#define GZIP_H
+
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace duw {
+
+std::optional<std::string> GzipCompress(std::string_view data);
+std::optional<std::string> GzipDecompress(std::string_view data);
+
+}  // namespace duw
+
+#endif  // GZIP_H
@@ -0,0 +1,211 @@
+#include "metrics.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace duw {
+
+namespace {
+
+const char* TypeName(MetricType type) {
+  switch (type) {
+    case MetricType::METRIC_COUNTER:
+      return "counter";
+    case MetricType::METRIC_GAUGE:
+      return "gauge";
+    case MetricType::METRIC_HISTOGRAM:
+      return "histogram";
+  }
+  return "untyped";
+}
+
+std::string EscapeLabelValue(const std::string& value) {
+  std::string escaped;
+  escaped.reserve(value.size());
+  for (char c : value) {
+    if (c == '\\' || c == '"') {
+      escaped.push_back('\\');
+      escaped.push_back(c);
+    } else if (c == '\n') {
+      escaped += "\\n";
+    } else {
+      escaped.push_back(c);
+    }
+  }
+  return escaped;
+}
+
+std::string FormatLabels(const MetricLabels& labels) {
+  std::string text;
+  for (const auto& [key, value] : labels) {
+    text += text.empty() ? "" : ",";
+    text += key + "=\"" + EscapeLabelValue(value) + "\"";
+  }
+  return text;
+}
+
+std::string FormatDouble(double value) {
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+  return buffer;
+}
+
+void AppendSample(const std::string& name, const std::string& labels, const std::string& value,
+                  std::string& out) {
+  out += name;
+  if (!labels.empty()) {
+    out += "{" + labels + "}";
+  }
+  out += " " + value + "\n";
+}
+
+std::string JoinLabels(const std::string& labels, const std::string& extra) {
+  return labels.empty() ? extra : labels + "," + extra;
+}
+
+}  // anonymous namespace
+
+void Counter::Render(const std::string& name, const std::string& labels, std::string& out) const {
+  AppendSample(name, labels, std::to_string(Value()), out);
+}
+
+void Gauge::Render(const std::string& name, const std::string& labels, std::string& out) const {
+  AppendSample(name, labels, std::to_string(Value()), out);
+}
+
+Histogram::Histogram(std::vector<double> bounds)
+    : bounds_(std::move(bounds)),
+      buckets_(std::make_unique<std::atomic<std::uint64_t>[]>(bounds_.size())) {
+  std::ranges::sort(bounds_);
+}
+
+void Histogram::Observe(double value) {
+  auto bucket = std::ranges::lower_bound(bounds_, value) - bounds_.begin();
+  if (static_cast<std::size_t>(bucket) < bounds_.size()) {
+    buckets_[bucket].fetch_add(1, std::memory_order_relaxed);
+  }
+  count_.fetch_add(1, std::memory_order_relaxed);
+  sum_.fetch_add(value, std::memory_order_relaxed);
+}
+
+void Histogram::ObserveDuration(std::chrono::nanoseconds duration) {
+  Observe(std::chrono::duration<double>(duration).count());
+}
+
+double Histogram::Quantile(double quantile) const {
+  auto count = Count();
+  if (count == 0) {
+    return 0.0;
+  }
+
+  double rank = std::clamp(quantile, 0.0, 1.0) * static_cast<double>(count);
+  std::uint64_t cumulative = 0;
+  for (std::size_t i = 0; i < bounds_.size(); ++i) {
+    auto in_bucket = buckets_[i].load(std::memory_order_relaxed);
+    if (in_bucket > 0 && static_cast<double>(cumulative + in_bucket) >= rank) {
+      double lower = i == 0 ? 0.0 : bounds_[i - 1];
+      double fraction = (rank - static_cast<double>(cumulative)) / static_cast<double>(in_bucket);
+      return lower + (bounds_[i] - lower) * fraction;
+    }
+    cumulative += in_bucket;
+  }
+  return bounds_.empty() ? 0.0 : bounds_.back();
+}
+
+void Histogram::Render(const std::string& name, const std::string& labels,
+                       std::string& out) const {
+  std::uint64_t cumulative = 0;
+  for (std::size_t i = 0; i < bounds_.size(); ++i) {
+    cumulative += buckets_[i].load(std::memory_order_relaxed);
+    AppendSample(name + "_bucket", JoinLabels(labels, "le=\"" + FormatDouble(bounds_[i]) + "\""),
+                 std::to_string(cumulative), out);
+  }
+  AppendSample(name + "_bucket", JoinLabels(labels, "le=\"+Inf\""), std::to_string(Count()), out);
+  AppendSample(name + "_sum", labels, FormatDouble(sum_.load(std::memory_order_relaxed)), out);
+  AppendSample(name + "_count", labels, std::to_string(Count()), out);
+}
+
+std::vector<double> LatencyBuckets() {
+  return {0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25, 0.5, 1, 2.5, 5, 10, 30};
+}
+
+MetricsRegistry& MetricsRegistry::Get() {
+  static MetricsRegistry registry;
+  return registry;
+}
+
+Counter& MetricsRegistry::GetCounter(const std::string& name, const std::string& help,
+                                     const MetricLabels& labels) {
+  return static_cast<Counter&>(GetOrCreate(name, help, MetricType::METRIC_COUNTER, labels,
+                                           [] { return std::make_unique<Counter>(); }));
+}
+
+Gauge& MetricsRegistry::GetGauge(const std::string& name, const std::string& help,
+                                 const MetricLabels& labels) {
+  return static_cast<Gauge&>(GetOrCreate(name, help, MetricType::METRIC_GAUGE, labels,
+                                         [] { return std::make_unique<Gauge>(); }));
+}
+
+Histogram& MetricsRegistry::GetHistogram(const std::string& name, const std::string& help,
+                                         const MetricLabels& labels, std::vector<double> bounds) {
+  return static_cast<Histogram&>(
+      GetOrCreate(name, help, MetricType::METRIC_HISTOGRAM, labels,
+                  [&bounds] { return std::make_unique<Histogram>(std::move(bounds)); }));
+}
+
+const Histogram* MetricsRegistry::FindHistogram(const std::string& name,
+                                                const MetricLabels& labels) const {
+  std::lock_guard lock(mutex_);
+  auto family = std::ranges::find(families_, name, &Family::name);
+  if (family == families_.end() || family->type != MetricType::METRIC_HISTOGRAM) {
+    return nullptr;
+  }
+
+  auto series = std::ranges::find(family->series, FormatLabels(labels), &Series::labels);
+  return series == family->series.end() ? nullptr
+                                        : static_cast<const Histogram*>(series->metric.get());
+}
+
+void MetricsRegistry::AddScrapeHook(ScrapeHook hook) {
+  std::lock_guard lock(mutex_);
+  scrape_hooks_.push_back(std::move(hook));
+}
+
+std::string MetricsRegistry::RenderPrometheus() const {
+  std::lock_guard lock(mutex_);
+  for (const auto& hook : scrape_hooks_) {
+    hook();
+  }
+
+  std::string out;
+  for (const auto& family : families_) {
+    out += "# HELP " + family.name + " " + family.help + "\n";
+    out += "# TYPE " + family.name + " " + TypeName(family.type) + "\n";
+    for (const auto& series : family.series) {
+      series.metric->Render(family.name, series.labels, out);
+    }
+  }
+  return out;
+}
+
+Metric& MetricsRegistry::GetOrCreate(const std::string& name, const std::string& help,
+                                     MetricType type, const MetricLabels& labels,
+                                     const std::function<std::unique_ptr<Metric>()>& create) {
+  std::lock_guard lock(mutex_);
+  auto family = std::ranges::find(families_, name, &Family::name);
+  if (family == families_.end()) {
+    families_.push_back(Family{.name = name, .help = help, .type = type, .series = {}});
+    family = families_.end() - 1;
+  }
+
+  std::string label_text = FormatLabels(labels);
+  auto series = std::ranges::find(family->series, label_text, &Series::labels);
+  if (series != family->series.end()) {
+    return *series->metric;
+  }
+
+  family->series.push_back(Series{.labels = label_text, .metric = create()});
+  return *family->series.back().metric;
+}
+
+}  // namespace duw
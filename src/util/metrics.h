@@ -0,0 +1,135 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace duw {
+
+using MetricLabels = std::vector<std::pair<std::string, std::string>>;
+
+enum class MetricType : std::uint8_t {
+  METRIC_COUNTER = 0,
+  METRIC_GAUGE = 1,
+  METRIC_HISTOGRAM = 2
+};
+
+class Metric {
+ public:
+  virtual ~Metric() = default;
+  virtual void Render(const std::string& name, const std::string& labels,
+                      std::string& out) const = 0;
+};
+
+class Counter : public Metric {
+ public:
+  void Increment(std::uint64_t amount = 1) {
+    value_.fetch_add(amount, std::memory_order_relaxed);
+  }
+  std::uint64_t Value() const { return value_.load(std::memory_order_relaxed); }
+  void Render(const std::string& name, const std::string& labels,
+              std::string& out) const override;
+
+ private:
+  std::atomic<std::uint64_t> value_{0};
+};
+
+class Gauge : public Metric {
+ public:
+  void Set(std::int64_t value) { value_.store(value, std::memory_order_relaxed); }
+  std::int64_t Value() const { return value_.load(std::memory_order_relaxed); }
+  void Render(const std::string& name, const std::string& labels,
+              std::string& out) const override;
+
+ private:
+  std::atomic<std::int64_t> value_{0};
+};
+
+class Histogram : public Metric {
+ public:
+  explicit Histogram(std::vector<double> bounds);
+
+  void Observe(double value);
+  void ObserveDuration(std::chrono::nanoseconds duration);
+  std::uint64_t Count() const { return count_.load(std::memory_order_relaxed); }
+  double Quantile(double quantile) const;
+  void Render(const std::string& name, const std::string& labels,
+              std::string& out) const override;
+
+ private:
+  std::vector<double> bounds_;
+  std::unique_ptr<std::atomic<std::uint64_t>[]> buckets_;
+  std::atomic<std::uint64_t> count_{0};
+  std::atomic<double> sum_{0.0};
+};
+
+class ScopedTimer {
+ public:
+  explicit ScopedTimer(Histogram& histogram)
+      : histogram_(histogram), started_at_(std::chrono::steady_clock::now()) {}
+  ~ScopedTimer() { histogram_.ObserveDuration(std::chrono::steady_clock::now() - started_at_); }
+
+  ScopedTimer(const ScopedTimer&) = delete;
+  ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+ private:
+  Histogram& histogram_;
+  std::chrono::steady_clock::time_point started_at_;
+};
+
+std::vector<double> LatencyBuckets();
+
+class MetricsRegistry {
+ public:
+  using ScrapeHook = std::function<void()>;
+
+  static MetricsRegistry& Get();
+
+  MetricsRegistry() = default;
+  MetricsRegistry(const MetricsRegistry&) = delete;
+  MetricsRegistry& operator=(const MetricsRegistry&) = delete;
+
+  Counter& GetCounter(const std::string& name, const std::string& help,
+                      const MetricLabels& labels = {});
+  Gauge& GetGauge(const std::string& name, const std::string& help,
+                  const MetricLabels& labels = {});
+  Histogram& GetHistogram(const std::string& name, const std::string& help,
+                          const MetricLabels& labels = {},
+                          std::vector<double> bounds = LatencyBuckets());
+  const Histogram* FindHistogram(const std::string& name, const MetricLabels& labels = {}) const;
+  void AddScrapeHook(ScrapeHook hook);
+  std::string RenderPrometheus() const;
+
+ private:
+  struct Series {
+    std::string labels;
+    std::unique_ptr<Metric> metric;
+  };
+
+  struct Family {
+    std::string name;
+    std::string help;
+    MetricType type;
+    std::vector<Series> series;
+  };
+
+  mutable std::mutex mutex_;
+  std::vector<Family> families_;
+  std::vector<ScrapeHook> scrape_hooks_;
+
+  Metric& GetOrCreate(const std::string& name, const std::string& help, MetricType type,
+                      const MetricLabels& labels,
+                      const std::function<std::unique_ptr<Metric>()>& create);
+};
+
+}  // namespace duw
+
+#endif  // METRICS_H